@@ -0,0 +1,52 @@
+#include <iostream>
+
+#include <rmagine/map/EmbreeMap.hpp>
+#include <rmagine/map/MapFile.hpp>
+#include <rmagine/util/StopWatch.hpp>
+
+namespace rm = rmagine;
+
+int main(int argc, char** argv)
+{
+    std::cout << "Rmagine Map Convert" << std::endl;
+
+    // minimum 2 arguments
+    if(argc < 3)
+    {
+        std::cout << "Usage: " << argv[0] << " mesh_file output.rmap" << std::endl;
+        return 0;
+    }
+
+    std::string filename_in = argv[1];
+    std::string filename_out = argv[2];
+
+    std::cout << "Inputs: " << std::endl;
+    std::cout << "- input: " << filename_in << std::endl;
+    std::cout << "- output: " << filename_out << std::endl;
+
+    if(!rm::is_map_file(filename_out))
+    {
+        std::cout << "Output file has to end with .rmap" << std::endl;
+        return 1;
+    }
+
+    rm::StopWatch sw;
+    double el;
+
+    sw();
+    rm::EmbreeMapPtr map = rm::import_embree_map(filename_in);
+    el = sw();
+    std::cout << "- import: " << el * 1000.0 << "ms" << std::endl;
+
+    sw();
+    rm::write_map_file(filename_out, map->scene);
+    el = sw();
+    std::cout << "- write: " << el * 1000.0 << "ms" << std::endl;
+
+    sw();
+    rm::EmbreeMapPtr map_cached = rm::import_embree_map(filename_out);
+    el = sw();
+    std::cout << "- import cached: " << el * 1000.0 << "ms" << std::endl;
+
+    return 0;
+}
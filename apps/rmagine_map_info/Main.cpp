@@ -2,9 +2,113 @@
 #include <rmagine/util/assimp/prints.h>
 #include <assimp/Importer.hpp>
 #include <rmagine/map/AssimpIO.hpp>
+#include <rmagine/map/MapFile.hpp>
+
+#ifdef RMAGINE_MAP_INFO_EMBREE
+#include <rmagine/map/EmbreeMap.hpp>
+#include <rmagine/util/StopWatch.hpp>
+#include <iomanip>
+#include <sstream>
+#endif // RMAGINE_MAP_INFO_EMBREE
 
 namespace rm = rmagine;
 
+#ifdef RMAGINE_MAP_INFO_EMBREE
+
+std::string bytes_string(size_t bytes)
+{
+    std::stringstream ss;
+    ss << std::fixed << std::setprecision(2);
+    if(bytes >= (1 << 30))
+    {
+        ss << static_cast<double>(bytes) / (1 << 30) << " GiB";
+    } else if(bytes >= (1 << 20)) {
+        ss << static_cast<double>(bytes) / (1 << 20) << " MiB";
+    } else if(bytes >= (1 << 10)) {
+        ss << static_cast<double>(bytes) / (1 << 10) << " KiB";
+    } else {
+        ss << bytes << " B";
+    }
+    return ss.str();
+}
+
+void print_embree_stats(const std::string& filename)
+{
+    const std::vector<std::pair<RTCBuildQuality, std::string> > qualities = {
+        {RTC_BUILD_QUALITY_LOW, "LOW"},
+        {RTC_BUILD_QUALITY_MEDIUM, "MEDIUM"},
+        {RTC_BUILD_QUALITY_HIGH, "HIGH"}};
+
+    std::cout << "Embree" << std::endl;
+
+    // complete map: import, freeze and commit
+    std::cout << "- map:" << std::endl;
+    rm::EmbreeMapPtr map;
+    for(const auto& quality : qualities)
+    {
+        rm::EmbreeDevicePtr device = std::make_shared<rm::EmbreeDevice>();
+        rm::EmbreeSceneSettings settings;
+        settings.quality = quality.first;
+
+        rm::StopWatch sw;
+        sw();
+        rm::EmbreeMapPtr map_q = rm::import_embree_map(filename, device, settings);
+        const double el = sw();
+
+        std::cout << "  - " << quality.second << ": " 
+            << "import " << el * 1000.0 << "ms, "
+            << "top-level commit " << map_q->scene->commitStats().last_time * 1000.0 << "ms, "
+            << "embree " << bytes_string(device->bytes()) << " (peak " << bytes_string(device->bytesPeak()) << "), "
+            << "buffers " << bytes_string(map_q->scene->bytes()) << std::endl;
+
+        if(quality.first == RTC_BUILD_QUALITY_MEDIUM)
+        {
+            map = map_q;
+        }
+    }
+
+    // meshes: BVH of every mesh built alone
+    std::vector<rm::EmbreeMeshPtr> meshes;
+    for(rm::EmbreeGeometryPtr geom : map->scene->findLeafs())
+    {
+        if(rm::EmbreeMeshPtr mesh = std::dynamic_pointer_cast<rm::EmbreeMesh>(geom))
+        {
+            meshes.push_back(mesh);
+        }
+    }
+
+    std::cout << "- meshes: " << meshes.size() << std::endl;
+    for(size_t i=0; i<meshes.size(); i++)
+    {
+        rm::EmbreeMeshPtr mesh = meshes[i];
+        std::cout << "  - " << i << ": '" << mesh->name << "', " 
+            << mesh->faces().size() << " faces, "
+            << "buffers " << bytes_string(mesh->bytes()) << std::endl;
+
+        for(const auto& quality : qualities)
+        {
+            rm::EmbreeSceneSettings settings;
+            settings.quality = quality.first;
+            rm::EmbreeDevicePtr device = map->scene->device();
+            rm::EmbreeScenePtr scene = std::make_shared<rm::EmbreeScene>(settings, device);
+            scene->add(mesh);
+
+            // nothing else is built on the device meanwhile: 
+            // the growth of the device is the BVH of this scene
+            const size_t bytes_before = device->bytes();
+            scene->commit();
+            const size_t bytes_after = device->bytes();
+
+            const rm::EmbreeCommitStats& stats = scene->commitStats();
+            std::cout << "    - " << quality.second << ": build " 
+                << stats.last_time * 1000.0 << "ms, BVH " 
+                << bytes_string(bytes_after > bytes_before ? bytes_after - bytes_before : 0) << std::endl;
+        }
+    }
+}
+
+#endif // RMAGINE_MAP_INFO_EMBREE
+
 int main(int argc, char** argv)
 {
     std::cout << "Rmagine Map Info" << std::endl;
@@ -12,24 +116,62 @@ int main(int argc, char** argv)
     // minimum 1 argument
     if(argc < 2)
     {
-        std::cout << "Usage: " << argv[0] << " mesh_file" << std::endl;
+        std::cout << "Usage: " << argv[0] << " mesh_file [--embree]" << std::endl;
+#ifdef RMAGINE_MAP_INFO_EMBREE
+        std::cout << "  --embree: import the map at every build quality and build a BVH per mesh. Slow for large maps" << std::endl;
+#endif // RMAGINE_MAP_INFO_EMBREE
         return 0;
     }
 
     std::string filename = argv[1];
+    const bool embree_stats = (argc > 2 && std::string(argv[2]) == "--embree");
 
     std::cout << "Inputs: " << std::endl;
     std::cout << "- filename: " << filename << std::endl;
 
-    rm::AssimpIO io;
-    const aiScene* ascene = io.ReadFile(filename, 0);
-
-    if(ascene)
+    if(rm::is_map_file(filename))
     {
-        rm::print(ascene);
+        rm::MapFile file(filename);
+        std::cout << "Rmagine map file (.rmap)" << std::endl;
+        std::cout << "- bytes: " << file.bytes() << std::endl;
+        std::cout << "- root geometries: " << file.root().size() << std::endl;
+        std::cout << "- meshes: " << file.meshes().size() << std::endl;
+        for(size_t i=0; i<file.meshes().size(); i++)
+        {
+            const rm::MapFileMesh& mesh = file.meshes()[i];
+            std::cout << "  - " << i << ": '" << mesh.name << "', " 
+                << mesh.vertices.size() << " vertices, " 
+                << mesh.faces.size() << " faces"
+                << (mesh.vertex_normals.size() ? ", vertex normals" : "") << std::endl;
+        }
+        std::cout << "- instances: " << file.instances().size() << std::endl;
+        for(size_t i=0; i<file.instances().size(); i++)
+        {
+            const rm::MapFileInstance& instance = file.instances()[i];
+            std::cout << "  - " << i << ": '" << instance.name << "', " 
+                << instance.geometries.size() << " geometries" << std::endl;
+        }
     } else {
-        std::cout << "Loading failed" << std::endl;
-        std::cerr << io.Importer::GetErrorString() << std::endl;
+        rm::AssimpIO io;
+        const aiScene* ascene = io.ReadFile(filename, 0);
+
+        if(ascene)
+        {
+            rm::print(ascene);
+        } else {
+            std::cout << "Loading failed" << std::endl;
+            std::cerr << io.Importer::GetErrorString() << std::endl;
+            return 0;
+        }
+    }
+
+    if(embree_stats)
+    {
+#ifdef RMAGINE_MAP_INFO_EMBREE
+        print_embree_stats(filename);
+#else
+        std::cout << "--embree: rmagine was built without Embree" << std::endl;
+#endif // RMAGINE_MAP_INFO_EMBREE
     }
 
     return 0;
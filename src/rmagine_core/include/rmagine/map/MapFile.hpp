@@ -0,0 +1,279 @@
+/*
+ * Copyright (c) 2025, University Osnabrück
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *     * Redistributions of source code must retain the above copyright
+ *       notice, this list of conditions and the following disclaimer.
+ *     * Redistributions in binary form must reproduce the above copyright
+ *       notice, this list of conditions and the following disclaimer in the
+ *       documentation and/or other materials provided with the distribution.
+ *     * Neither the name of the University Osnabrück nor the
+ *       names of its contributors may be used to endorse or promote products
+ *       derived from this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND
+ * ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+ * WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+ * DISCLAIMED. IN NO EVENT SHALL University Osnabrück BE LIABLE FOR ANY
+ * DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES
+ * (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+ * LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND
+ * ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ * (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS
+ * SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+/**
+ * @file
+ *
+ * @brief Binary map cache (.rmap) with memory mapped loading
+ *
+ * A .rmap file stores the buffers of a map after conversion
+ * (vertices, faces, face and vertex normals) together with the instance
+ * hierarchy and the geometry ids. Loading maps the file into memory:
+ * the buffers are used in place, nothing is parsed or copied.
+ *
+ * Layout (native byte order, every buffer aligned to rmap::ALIGNMENT):
+ *
+ * | rmap::Header | rmap::MeshEntry[num_meshes] | rmap::InstanceEntry[num_instances]
+ * | rmap::GeometryRef[...] | names | buffers |
+ *
+ * @copyright Copyright (c) 2025, University Osnabrück. All rights reserved.
+ * This project is released under the 3-Clause BSD License.
+ *
+ */
+
+#ifndef RMAGINE_MAP_MAP_FILE_HPP
+#define RMAGINE_MAP_MAP_FILE_HPP
+
+#include <rmagine/math/types.h>
+#include <rmagine/types/mesh_types.h>
+#include <rmagine/types/Memory.hpp>
+
+#include <cstdint>
+#include <memory>
+#include <string>
+#include <vector>
+
+namespace rmagine
+{
+
+namespace rmap
+{
+
+// "RMAP" in little endian. Files of the other byte order are rejected
+static constexpr uint32_t MAGIC = 0x50414D52;
+static constexpr uint32_t VERSION = 1;
+
+/**
+ * @brief Alignment of every buffer in the file. Also guarantees the
+ * padding that Embree requires behind shared vertex buffers
+ */
+static constexpr uint64_t ALIGNMENT = 64;
+
+/**
+ * @brief Geometry ids index flat tables of the scenes. They are accepted
+ * up to the number of geometry references of the file or up to this
+ * limit, whichever is larger. Ids can be sparse after geometries were removed
+ */
+static constexpr uint32_t GEOM_ID_LIMIT = 1 << 20;
+
+/**
+ * @brief Maximum nesting of instances. Deeper hierarchies are rejected
+ */
+static constexpr uint32_t MAX_INSTANCE_DEPTH = 64;
+
+/**
+ * @brief Bytes required behind the last vertex of a vertex buffer: 
+ * Embree reads vertices with 16 byte loads
+ */
+static constexpr uint64_t VERTEX_PADDING = 4;
+
+enum class GeometryType : uint32_t
+{
+    MESH = 0,
+    INSTANCE = 1
+};
+
+/**
+ * @brief Geometry attached to a scene: the root scene or the scene
+ * instanced by an InstanceEntry
+ */
+struct GeometryRef
+{
+    GeometryType type;
+    // index into the mesh or instance table
+    uint32_t index;
+    // geometry id inside of the scene
+    uint32_t geom_id;
+    uint32_t reserved;
+};
+
+struct Header
+{
+    uint32_t magic;
+    uint32_t version;
+    uint64_t file_size;
+    uint32_t num_meshes;
+    uint32_t num_instances;
+    uint32_t num_root_geometries;
+    uint32_t reserved;
+    // byte offsets from the beginning of the file
+    uint64_t meshes_offset;
+    uint64_t instances_offset;
+    uint64_t root_offset;
+};
+
+struct MeshEntry
+{
+    uint64_t name_offset;
+    uint32_t name_length;
+    uint32_t num_vertices;
+    uint32_t num_faces;
+    // 1 if vertex normals are stored
+    uint32_t has_vertex_normals;
+    uint64_t vertices_offset;
+    uint64_t faces_offset;
+    uint64_t face_normals_offset;
+    uint64_t vertex_normals_offset;
+};
+
+struct InstanceEntry
+{
+    uint64_t name_offset;
+    uint32_t name_length;
+    uint32_t num_geometries;
+    uint64_t geometries_offset;
+    Transform T;
+    Vector3 scale;
+    uint32_t reserved;
+};
+
+} // namespace rmap
+
+/**
+ * @brief Mesh buffers of a .rmap file. The buffers are
+ * already transformed: meshes of a map file carry no transform of their own
+ */
+struct MapFileMesh
+{
+    std::string name;
+    MemoryView<Vertex, RAM> vertices{nullptr, 0};
+    MemoryView<Face, RAM> faces{nullptr, 0};
+    MemoryView<Vector, RAM> face_normals{nullptr, 0};
+    // empty if the mesh has no vertex normals
+    MemoryView<Vector, RAM> vertex_normals{nullptr, 0};
+};
+
+/**
+ * @brief Instance of a scene that consists of the geometries 'geometries'
+ */
+struct MapFileInstance
+{
+    std::string name;
+    Transform T;
+    Vector3 scale;
+    std::vector<rmap::GeometryRef> geometries;
+};
+
+/**
+ * @brief A .rmap file mapped into memory
+ *
+ * The file is mapped copy-on-write: the buffers can be modified
+ * (e.g. by transforming a mesh) without changing the file. Only the
+ * modified pages are copied. The views stay valid as long as the
+ * MapFile exists.
+ *
+ * Example:
+ *
+ * @code{cpp}
+ * MapFilePtr file = std::make_shared<MapFile>("city.rmap");
+ * for(const MapFileMesh& mesh : file->meshes())
+ * {
+ *   std::cout << mesh.name << ": " << mesh.faces.size() << " faces" << std::endl;
+ * }
+ * @endcode
+ */
+class MapFile
+{
+public:
+    /**
+     * @brief Map and validate a .rmap file
+     *
+     * @throws Exception if the file cannot be opened or is no valid .rmap file
+     */
+    MapFile(const std::string& filename);
+    ~MapFile();
+
+    MapFile(const MapFile&) = delete;
+    MapFile& operator=(const MapFile&) = delete;
+
+    inline const std::vector<MapFileMesh>& meshes() const
+    {
+        return m_meshes;
+    }
+
+    inline const std::vector<MapFileInstance>& instances() const
+    {
+        return m_instances;
+    }
+
+    /**
+     * @brief Geometries of the top-level scene
+     */
+    inline const std::vector<rmap::GeometryRef>& root() const
+    {
+        return m_root;
+    }
+
+    /**
+     * @brief Size of the mapping in bytes
+     */
+    inline size_t bytes() const
+    {
+        return m_bytes;
+    }
+
+    inline const std::string& filename() const
+    {
+        return m_filename;
+    }
+
+private:
+    std::string m_filename;
+    void* m_data = nullptr;
+    size_t m_bytes = 0;
+
+    std::vector<MapFileMesh> m_meshes;
+    std::vector<MapFileInstance> m_instances;
+    std::vector<rmap::GeometryRef> m_root;
+};
+
+using MapFilePtr = std::shared_ptr<MapFile>;
+
+/**
+ * @brief Write a .rmap file
+ *
+ * @param filename    output file
+ * @param meshes      mesh buffers. The views only need to be valid during the call
+ * @param instances   instances referencing meshes or other instances
+ * @param root        geometries of the top-level scene
+ *
+ * @throws Exception if a reference is out of range or the file cannot be written
+ */
+void write_map_file(
+    const std::string& filename,
+    const std::vector<MapFileMesh>& meshes,
+    const std::vector<MapFileInstance>& instances,
+    const std::vector<rmap::GeometryRef>& root);
+
+/**
+ * @brief true if filename ends with .rmap
+ */
+bool is_map_file(const std::string& filename);
+
+} // namespace rmagine
+
+#endif // RMAGINE_MAP_MAP_FILE_HPP
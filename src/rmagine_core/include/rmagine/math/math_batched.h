@@ -41,11 +41,118 @@
 #ifndef RMAGINE_MATH_MATH_BATCHED_H
 #define RMAGINE_MATH_MATH_BATCHED_H
 
-
+#include <rmagine/math/types.h>
+#include <rmagine/types/Memory.hpp>
+#include <cstdint>
 
 namespace rmagine
 {
 
+/**
+ * The data is split into consecutive batches of equal size, 
+ * e.g. one batch per simulated pose. The number of batches is
+ * given by the size of the output, the batch size by data.size() / sums.size().
+ * Batches are reduced in parallel. Large batches are additionally split 
+ * over several threads, so a single huge batch is as fast as memory_math's sum.
+ */
+
+//////////
+// #sumBatched
+void sumBatched(
+    const MemoryView<Vector, RAM>& data,
+    MemoryView<Vector, RAM>& sums);
+
+Memory<Vector, RAM> sumBatched(
+    const MemoryView<Vector, RAM>& data,
+    size_t batchSize);
+
+void sumBatched(
+    const MemoryView<Matrix3x3, RAM>& data,
+    MemoryView<Matrix3x3, RAM>& sums);
+
+Memory<Matrix3x3, RAM> sumBatched(
+    const MemoryView<Matrix3x3, RAM>& data,
+    size_t batchSize);
+
+void sumBatched(
+    const MemoryView<float, RAM>& data,
+    MemoryView<float, RAM>& sums);
+
+Memory<float, RAM> sumBatched(
+    const MemoryView<float, RAM>& data,
+    size_t batchSize);
+
+void sumBatched(
+    const MemoryView<unsigned int, RAM>& data,
+    MemoryView<unsigned int, RAM>& sums);
+
+Memory<unsigned int, RAM> sumBatched(
+    const MemoryView<unsigned int, RAM>& data,
+    size_t batchSize);
+
+//////////
+// #sumBatched masked
+// only elements with mask[i] > 0 are summed up
+void sumBatched(
+    const MemoryView<Vector, RAM>& data,
+    const MemoryView<bool, RAM>& mask,
+    MemoryView<Vector, RAM>& sums);
+
+Memory<Vector, RAM> sumBatched(
+    const MemoryView<Vector, RAM>& data,
+    const MemoryView<bool, RAM>& mask,
+    size_t batchSize);
+
+void sumBatched(
+    const MemoryView<Vector, RAM>& data,
+    const MemoryView<unsigned int, RAM>& mask,
+    MemoryView<Vector, RAM>& sums);
+
+Memory<Vector, RAM> sumBatched(
+    const MemoryView<Vector, RAM>& data,
+    const MemoryView<unsigned int, RAM>& mask,
+    size_t batchSize);
+
+void sumBatched(
+    const MemoryView<Vector, RAM>& data,
+    const MemoryView<uint8_t, RAM>& mask,
+    MemoryView<Vector, RAM>& sums);
+
+Memory<Vector, RAM> sumBatched(
+    const MemoryView<Vector, RAM>& data,
+    const MemoryView<uint8_t, RAM>& mask,
+    size_t batchSize);
+
+////////
+// #covBatched   C_b = sum_{i in b} (m1[i] * m2[i].T) / batchSize
+void covBatched(
+    const MemoryView<Vector, RAM>& m1, 
+    const MemoryView<Vector, RAM>& m2,
+    MemoryView<Matrix3x3, RAM>& covs);
+
+Memory<Matrix3x3, RAM> covBatched(
+    const MemoryView<Vector, RAM>& m1, 
+    const MemoryView<Vector, RAM>& m2,
+    unsigned int batchSize);
+
+/**
+ * @brief Only correspondences with corr[i] set are used. Every batch b
+ * is normalized by ncorr[b]. Batches without correspondences (ncorr[b] == 0) are zero
+ */
+void covBatched(
+    const MemoryView<Vector, RAM>& m1, 
+    const MemoryView<Vector, RAM>& m2,
+    const MemoryView<bool, RAM>& corr,
+    const MemoryView<unsigned int, RAM>& ncorr,
+    MemoryView<Matrix3x3, RAM>& covs);
+
+Memory<Matrix3x3, RAM> covBatched(
+    const MemoryView<Vector, RAM>& m1, 
+    const MemoryView<Vector, RAM>& m2,
+    const MemoryView<bool, RAM>& corr,
+    const MemoryView<unsigned int, RAM>& ncorr,
+    unsigned int batchSize);
+
 } // namespace rmagine
 
 #endif // RMAGINE_MATH_MATH_BATCHED_H
\ No newline at end of file
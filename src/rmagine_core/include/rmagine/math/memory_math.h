@@ -42,6 +42,7 @@
 #define RMAGINE_MATH_MEMORY_MATH_H
 
 #include <rmagine/types/Memory.hpp>
+#include <rmagine/types/VectorSoA.hpp>
 #include <rmagine/math/types.h>
 #include <functional>
 
@@ -164,6 +165,9 @@ Memory<Vector, RAM> multNx1(
 
 /////////////
 // #mult1xN
+// The Vector variants (a single Quaternion, Transform or Matrix3x3 
+// applied to N vectors) use the SIMD kernels of simd.h. 
+// See there for the tolerance to the scalar results
 ////////
 void mult1xN(
     const MemoryView<Quaternion, RAM>& a,
@@ -362,6 +366,94 @@ Memory<Matrix3x3, RAM> cov(
     const MemoryView<Vector, RAM>& v2
 );
 
+///////
+// #soa
+// Structure-of-arrays variants of the vector functions above. 
+// Outputs are views and are written in place, pass a VectorSoA or a 
+// VectorSoAView of matching size.
+void to_soa(
+    const MemoryView<Vector, RAM>& A,
+    VectorSoAView_<RAM> B);
+
+VectorSoA_<RAM> to_soa(
+    const MemoryView<Vector, RAM>& A);
+
+void to_aos(
+    const VectorSoAView_<RAM>& A,
+    MemoryView<Vector, RAM>& B);
+
+Memory<Vector, RAM> to_aos(
+    const VectorSoAView_<RAM>& A);
+
+void mult1xN(
+    const MemoryView<Transform, RAM>& t,
+    const VectorSoAView_<RAM>& X,
+    VectorSoAView_<RAM> C);
+
+VectorSoA_<RAM> mult1xN(
+    const MemoryView<Transform, RAM>& t,
+    const VectorSoAView_<RAM>& X);
+
+void mult1xN(
+    const MemoryView<Matrix3x3, RAM>& m,
+    const VectorSoAView_<RAM>& X,
+    VectorSoAView_<RAM> C);
+
+VectorSoA_<RAM> mult1xN(
+    const MemoryView<Matrix3x3, RAM>& m,
+    const VectorSoAView_<RAM>& X);
+
+void addNxN(
+    const VectorSoAView_<RAM>& A,
+    const VectorSoAView_<RAM>& B,
+    VectorSoAView_<RAM> C);
+
+VectorSoA_<RAM> addNxN(
+    const VectorSoAView_<RAM>& A,
+    const VectorSoAView_<RAM>& B);
+
+void subNxN(
+    const VectorSoAView_<RAM>& A,
+    const VectorSoAView_<RAM>& B,
+    VectorSoAView_<RAM> C);
+
+VectorSoA_<RAM> subNxN(
+    const VectorSoAView_<RAM>& A,
+    const VectorSoAView_<RAM>& B);
+
+void sub(
+    const VectorSoAView_<RAM>& A,
+    const Vector& b,
+    VectorSoAView_<RAM> C);
+
+VectorSoA_<RAM> sub(
+    const VectorSoAView_<RAM>& A,
+    const Vector& b);
+
+void sum(
+    const VectorSoAView_<RAM>& X, 
+    MemoryView<Vector, RAM>& res);
+
+Memory<Vector, RAM> sum(
+    const VectorSoAView_<RAM>& X);
+
+void mean(
+    const VectorSoAView_<RAM>& X,
+    MemoryView<Vector, RAM>& res);
+
+Memory<Vector, RAM> mean(
+    const VectorSoAView_<RAM>& X);
+
+// C = (v1 * v2.T) / N
+void cov(
+    const VectorSoAView_<RAM>& v1,
+    const VectorSoAView_<RAM>& v2,
+    MemoryView<Matrix3x3, RAM>& C);
+
+Memory<Matrix3x3, RAM> cov(
+    const VectorSoAView_<RAM>& v1,
+    const VectorSoAView_<RAM>& v2);
+
 /**
  * @brief decompose A = UWV* using singular value decomposition
  */
@@ -45,6 +45,8 @@
 #include <rmagine/types/shared_functions.h>
 #include "linalg.h"
 #include "lie.h"
+#include <rmagine/types/PointCloud.hpp>
+#include <rmagine/types/UmeyamaReductionConstraints.hpp>
 
 namespace rmagine
 {
@@ -74,6 +76,20 @@ Transform umeyama_transform(
 Transform umeyama_transform(
     const CrossStatistics& stats);
 
+/**
+ * @brief umeyama_transform with the covariance already decomposed by simd::svd3:
+ * C = U * diag(s) * V^T with U and V rotations. Used by the batched versions
+ */
+Transform umeyama_transform_svd(
+    const Vector3& d,
+    const Vector3& m,
+    const Matrix3x3& U,
+    const Matrix3x3& V,
+    const unsigned int n_meas = 1);
+
+/**
+ * @brief Geman-McClure weight of a squared residual
+ */
 RMAGINE_INLINE_FUNCTION
 float GM_weight(
     const float kernel_scale,
@@ -82,7 +98,72 @@ float GM_weight(
   return sqr(kernel_scale) / sqr(kernel_scale + residual2);
 }
 
-// TODO: test 
+/**
+ * @brief Huber weight of a squared residual. 1 inside of kernel_scale, k/|r| outside
+ */
+RMAGINE_INLINE_FUNCTION
+float Huber_weight(
+    const float kernel_scale,
+    const float residual2)
+{
+  return (residual2 <= sqr(kernel_scale)) ? 1.0f : kernel_scale / sqrtf(residual2);
+}
+
+/**
+ * @brief Cauchy weight of a squared residual
+ */
+RMAGINE_INLINE_FUNCTION
+float Cauchy_weight(
+    const float kernel_scale,
+    const float residual2)
+{
+  return 1.0f / (1.0f + residual2 / sqr(kernel_scale));
+}
+
+enum class RobustKernelType
+{
+  NONE, // least squares
+  HUBER,
+  CAUCHY,
+  GEMAN_MCCLURE
+};
+
+/**
+ * @brief Robust kernel used to weight the residuals of the Gauss-Newton systems
+ */
+struct RobustKernel
+{
+  RobustKernelType type = RobustKernelType::GEMAN_MCCLURE;
+  float scale = 5.0;
+
+  RMAGINE_INLINE_FUNCTION
+  float weight(const float residual2) const
+  {
+    switch(type)
+    {
+      case RobustKernelType::HUBER:
+        return Huber_weight(scale, residual2);
+      case RobustKernelType::CAUCHY:
+        return Cauchy_weight(scale, residual2);
+      case RobustKernelType::GEMAN_MCCLURE:
+        return GM_weight(scale, residual2);
+      default:
+        return 1.0;
+    }
+  }
+};
+
+// Gauss-Newton
+// 
+// The dataset point is perturbed from the left by a twist x = (w, v), 
+// rotation first: Pd' = se3_exp(v, w) * Pd.
+// Residuals are dataset minus model, r(x) ~ r + J * x. 
+// The weighted normal equations are
+// (J^T * W * J) * x = -(J^T * W * r)
+
+/**
+ * @brief Jacobian and residual of a point to point correspondence Pd -> Pm
+ */
 RMAGINE_INLINE_FUNCTION
 void jacobian_and_residual_p2p(
     Matrix_<float, 3, 6>& Jr, // [out] Jacobian 
@@ -90,26 +171,26 @@ void jacobian_and_residual_p2p(
     const Vector3f& Pm, // model point
     const Vector3f& Pd) // dataset point
 {
-  // this is slightly different from kiss icp
-  // TODO: test
-
-  // Jr top 3x3 = Identity
-  Jr(0,0) = 1.0; Jr(1,0) = 0.0; Jr(2,0) = 0.0;
-  Jr(0,1) = 0.0; Jr(1,1) = 1.0; Jr(2,1) = 0.0;
-  Jr(0,2) = 0.0; Jr(1,2) = 0.0; Jr(2,2) = 1.0;
+  // Jr left 3x3 = -hat(Pd)
+  Jr(0,0) =   0.0; Jr(1,0) = -Pd.z; Jr(2,0) =  Pd.y;
+  Jr(0,1) =  Pd.z; Jr(1,1) =   0.0; Jr(2,1) = -Pd.x;
+  Jr(0,2) = -Pd.y; Jr(1,2) =  Pd.x; Jr(2,2) =   0.0;
 
-  // Jr bottom 3x3 = -1 * hat(Pd) -> only hat
-  Jr(0,3) =   0.0; Jr(1,3) = -Pd.z; Jr(2,3) =  Pd.y;
-  Jr(0,4) =  Pd.z; Jr(1,4) =   0.0; Jr(2,4) = -Pd.x;
-  Jr(0,5) = -Pd.y; Jr(1,5) =  Pd.x; Jr(2,5) =   0.0;
+  // Jr right 3x3 = Identity
+  Jr(0,3) = 1.0; Jr(1,3) = 0.0; Jr(2,3) = 0.0;
+  Jr(0,4) = 0.0; Jr(1,4) = 1.0; Jr(2,4) = 0.0;
+  Jr(0,5) = 0.0; Jr(1,5) = 0.0; Jr(2,5) = 1.0;
 
-  const Vector3f res_vec = Pm - Pd; // Pm <- Pd
+  const Vector3f res_vec = Pd - Pm;
   residual(0,0) = res_vec.x;
   residual(1,0) = res_vec.y;
   residual(2,0) = res_vec.z;
 }
 
-
+/**
+ * @brief Jacobian and residual of a point to plane correspondence: 
+ * Pd -> plane through Pm with normal Nm
+ */
 RMAGINE_INLINE_FUNCTION
 void jacobian_and_residual_p2l(
     Matrix_<float, 1, 6>& J, // [out] Jacobian
@@ -118,13 +199,8 @@ void jacobian_and_residual_p2l(
     const Vector3f& Nm, // model normal
     const Vector3f& Pd) // dataset point
 {
-  // this is slightly different from kiss icp
-  // TODO: test
-
-  // TODO: test if we should better write Pm - Pd
+  // signed distance of Pd to the plane
   residual = (Pd - Pm).dot(Nm);
-  // put this outside?
-  // const float w = GM_weight(5.0, residual);
 
   const Vector3f PdNm = Pd.cross(Nm);
 
@@ -136,22 +212,19 @@ void jacobian_and_residual_p2l(
   J(0,5) = Nm.z;
 }
 
-
 /**
  * @brief Build a Gauss-Newton linear system of the form 
- * (J^T * W * J) * x = (J^T * W * r)
- * using point to point metric (P2P)
+ * (J^T * W * J) * x = -(J^T * W * r)
+ * using point to point metric (P2P). Serial, accumulates onto JTwJ and JTwr.
  */
 RMAGINE_INLINE_FUNCTION
 void build_linear_system_p2p(
     Matrix_<float, 6, 6>& JTwJ,
     Matrix_<float, 6, 1>& JTwr,
     const MemoryView<Vector, RAM>& model_points, 
-    const MemoryView<Vector, RAM>& dataset_points)
+    const MemoryView<Vector, RAM>& dataset_points,
+    const RobustKernel kernel = RobustKernel())
 {
-  // TODO:
-  // - test
-  // - make reduction from this
   for(size_t i=0; i<model_points.size(); i++)
   {
     Matrix_<float, 3, 6> J;
@@ -160,8 +233,8 @@ void build_linear_system_p2p(
     jacobian_and_residual_p2p(J, r, 
       model_points[i], dataset_points[i]);
 
-    float residual2 = sqr(r(0,0)) + sqr(r(1,0)) + sqr(r(2,0)); 
-    float w = GM_weight(5.0, residual2);
+    const float residual2 = sqr(r(0,0)) + sqr(r(1,0)) + sqr(r(2,0)); 
+    const float w = kernel.weight(residual2);
     JTwJ += (J.T() * w) * J; 
     JTwr += (J.T() * w) * r;
   }
@@ -169,8 +242,8 @@ void build_linear_system_p2p(
 
 /**
  * @brief Build a Gauss-Newton linear system of the form 
- * (J^T * W * J) * x = (J^T * W * r)
- * using point to plane metric (P2L)
+ * (J^T * W * J) * x = -(J^T * W * r)
+ * using point to plane metric (P2L). Serial, accumulates onto JTwJ and JTwr.
  */
 RMAGINE_INLINE_FUNCTION
 void build_linear_system_p2l(
@@ -178,11 +251,9 @@ void build_linear_system_p2l(
     Matrix_<float, 6, 1>& JTwr,
     const MemoryView<Vector, RAM>& model_points,
     const MemoryView<Vector, RAM>& model_normals, 
-    const MemoryView<Vector, RAM>& dataset_points)
+    const MemoryView<Vector, RAM>& dataset_points,
+    const RobustKernel kernel = RobustKernel())
 {
-  // TODO:
-  // - test
-  // - make reduction from this
   for(size_t i=0; i<model_points.size(); i++)
   {
     Matrix_<float, 1, 6> J;
@@ -190,9 +261,9 @@ void build_linear_system_p2l(
     jacobian_and_residual_p2l(J, r, 
       model_points[i], model_normals[i], dataset_points[i]);
 
-    float weight = GM_weight(5.0, r);
-    JTwJ += (J.T() * weight) * J; 
-    JTwr += (J.T() * weight) * r;
+    const float w = kernel.weight(sqr(r));
+    JTwJ += (J.T() * w) * J; 
+    JTwr += J.T() * (w * r);
   }
 }
 
@@ -201,24 +272,10 @@ void build_linear_system_p2p(
     Matrix_<float, 6, 6>& JTwJ,
     Matrix_<float, 6, 1>& JTwr,
     const PointCloudView_<RAM>& model, 
-    const PointCloudView_<RAM>& dataset)
-{   
-  // TODO:
-  // - test
-  // - make reduction from this
-  for(size_t i=0; i<model.points.size(); i++)
-  {
-    Matrix_<float, 3, 6> J;
-    Matrix_<float, 3, 1> r;
-    
-    jacobian_and_residual_p2p(J, r, 
-      model.points[i], dataset.points[i]);
-
-    float residual2 = sqr(r(0,0)) + sqr(r(1,0)) + sqr(r(2,0)); 
-    float w = GM_weight(5.0, residual2);
-    JTwJ += (J.T() * w) * J; 
-    JTwr += (J.T() * w) * r;
-  }
+    const PointCloudView_<RAM>& dataset,
+    const RobustKernel kernel = RobustKernel())
+{
+  build_linear_system_p2p(JTwJ, JTwr, model.points, dataset.points, kernel);
 }
 
 RMAGINE_INLINE_FUNCTION
@@ -226,24 +283,77 @@ void build_linear_system_p2l(
     Matrix_<float, 6, 6>& JTwJ,
     Matrix_<float, 6, 1>& JTwr,
     const PointCloudView_<RAM>& model,
-    const PointCloudView_<RAM>& dataset)
-{   
-  // TODO:
-  // - test
-  // - make reduction from this
-  for(size_t i=0; i<model.points.size(); i++)
-  {
-    Matrix_<float, 1, 6> J;
-    float r;
-    jacobian_and_residual_p2l(J, r, 
-      model.points[i], model.normals[i], dataset.points[i]);
-
-    float weight = GM_weight(5.0, r);
-    JTwJ += (J.T() * weight) * J; 
-    JTwr += (J.T() * weight) * r;
-  }
+    const PointCloudView_<RAM>& dataset,
+    const RobustKernel kernel = RobustKernel())
+{
+  build_linear_system_p2l(JTwJ, JTwr, model.points, model.normals, dataset.points, kernel);
 }
 
+/**
+ * @brief Parallel reduction of the Gauss-Newton system over index-wise 
+ * corresponding dataset and model points, using point to point metric (P2P).
+ * Filters by mask, ids and max_dist like statistics_p2p.
+ * 
+ * @param pre_transform  current estimate, applied to the dataset points
+ * @param[out] JTwJ 
+ * @param[out] JTwr 
+ * @return number of correspondences used
+ */
+unsigned int build_linear_system_p2p(
+    const Transform& pre_transform,
+    const PointCloudView_<RAM>& dataset,
+    const PointCloudView_<RAM>& model,
+    const UmeyamaReductionConstraints params,
+    const RobustKernel kernel,
+    Matrix_<float, 6, 6>& JTwJ,
+    Matrix_<float, 6, 1>& JTwr);
+
+/**
+ * @brief Parallel reduction of the Gauss-Newton system over index-wise 
+ * corresponding dataset and model points, using point to plane metric (P2L).
+ * Filters by mask, ids and max_dist like statistics_p2l.
+ * 
+ * @param pre_transform  current estimate, applied to the dataset points
+ * @param[out] JTwJ 
+ * @param[out] JTwr 
+ * @return number of correspondences used
+ */
+unsigned int build_linear_system_p2l(
+    const Transform& pre_transform,
+    const PointCloudView_<RAM>& dataset,
+    const PointCloudView_<RAM>& model,
+    const UmeyamaReductionConstraints params,
+    const RobustKernel kernel,
+    Matrix_<float, 6, 6>& JTwJ,
+    Matrix_<float, 6, 1>& JTwr);
+
+/**
+ * @brief Solves (J^T * W * J) * x = -(J^T * W * r) via Cholesky decomposition 
+ * and maps the twist x = (w, v) to a transform with se3_exp. 
+ * Directions that are not constrained (e.g. along a plane) are not moved.
+ * 
+ * @return Transform to be applied from the left to the current estimate
+ */
+Transform gauss_newton_step(
+    const Matrix_<float, 6, 6>& JTwJ,
+    const Matrix_<float, 6, 1>& JTwr);
+
+/**
+ * @brief Iterative point to plane Gauss-Newton registration 
+ * with fixed index-wise correspondences
+ * 
+ * @param Tinit          initial guess, applied to the dataset points
+ * @param n_iterations   maximum number of Gauss-Newton iterations
+ * @return Transform that moves the dataset onto the model planes
+ */
+Transform gauss_newton_p2l(
+    const Transform& Tinit,
+    const PointCloudView_<RAM>& dataset,
+    const PointCloudView_<RAM>& model,
+    const UmeyamaReductionConstraints params,
+    const RobustKernel kernel = RobustKernel(),
+    const unsigned int n_iterations = 10);
+
 // Collection of minimization strategies
 //
 // Umeyama
@@ -0,0 +1,132 @@
+/*
+ * Copyright (c) 2025, University Osnabrück
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *     * Redistributions of source code must retain the above copyright
+ *       notice, this list of conditions and the following disclaimer.
+ *     * Redistributions in binary form must reproduce the above copyright
+ *       notice, this list of conditions and the following disclaimer in the
+ *       documentation and/or other materials provided with the distribution.
+ *     * Neither the name of the University Osnabrück nor the
+ *       names of its contributors may be used to endorse or promote products
+ *       derived from this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND
+ * ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+ * WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+ * DISCLAIMED. IN NO EVENT SHALL University Osnabrück BE LIABLE FOR ANY
+ * DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES
+ * (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+ * LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND
+ * ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ * (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS
+ * SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+/**
+ * @file
+ * 
+ * @brief Explicitly vectorized kernels with runtime instruction set dispatch
+ * 
+ * The kernels are compiled for SSE4.1, AVX2/FMA and AVX-512F independent 
+ * of the compiler flags of the build. The widest instruction set supported 
+ * by the CPU is selected at runtime.
+ * 
+ * Results are not bit-identical to the scalar implementations: the SIMD 
+ * kernels rotate with the rotation matrix instead of the quaternion and 
+ * fuse multiply-adds. The absolute difference per component is below 
+ * 1e-6 * (|x| + |t|) for unit quaternions.
+ *
+ * @copyright Copyright (c) 2025, University Osnabrück. All rights reserved.
+ * This project is released under the 3-Clause BSD License.
+ * 
+ */
+
+#ifndef RMAGINE_MATH_SIMD_H
+#define RMAGINE_MATH_SIMD_H
+
+#include <rmagine/math/types.h>
+#include <cstddef>
+
+namespace rmagine
+{
+
+enum class SimdLevel 
+{
+    SCALAR = 0,
+    SSE4 = 1,
+    AVX2 = 2,
+    AVX512 = 3
+};
+
+/**
+ * @brief Widest instruction set supported by the CPU
+ */
+SimdLevel simd_level_supported();
+
+/**
+ * @brief Instruction set currently used by the kernels
+ */
+SimdLevel simd_level();
+
+/**
+ * @brief Restrict the kernels to an instruction set, e.g. for testing or 
+ * reproducibility. Levels above simd_level_supported() are clamped.
+ */
+void set_simd_level(SimdLevel level);
+
+const char* simd_level_name(SimdLevel level);
+
+namespace simd
+{
+
+/**
+ * @brief out[i] = R * in[i] + t for i in [0, N)
+ * 
+ * in and out may be the same buffer
+ */
+void transform_points(
+    const Matrix3x3& R,
+    const Vector& t,
+    const Vector* in,
+    Vector* out,
+    size_t N);
+
+/**
+ * @brief Singular value decompositions A[i] = U[i] * diag(s[i]) * V[i]^T
+ * for i in [0, N). The matrices are processed 4, 8 or 16 at a time, one per SIMD lane.
+ *
+ * Closed form with a fixed number of Jacobi sweeps (McAdams et al. 2011),
+ * no iteration until convergence and no exceptions.
+ * U and V are rotations (det = +1). The singular values are sorted by
+ * decreasing magnitude, s.x, s.y >= 0 and s.z has the sign of det(A).
+ * Therefore the closest rotation to A is U * V^T.
+ *
+ * Accuracy is limited to single precision:
+ * ||A - U diag(s) V^T|| is below ~1e-5 * ||A||.
+ */
+void svd3(
+    const Matrix3x3* A,
+    Matrix3x3* U,
+    Vector3* s,
+    Matrix3x3* V,
+    size_t N);
+
+/**
+ * @brief Singular value decomposition of a single matrix, same conventions as above. 
+ * Scalar code without instruction set dispatch: leaves the floating point 
+ * control register (MXCSR) untouched. Use the batched version for many matrices
+ */
+void svd3(
+    const Matrix3x3& A,
+    Matrix3x3& U,
+    Vector3& s,
+    Matrix3x3& V);
+
+} // namespace simd
+
+} // namespace rmagine
+
+#endif // RMAGINE_MATH_SIMD_H
@@ -0,0 +1,113 @@
+/*
+ * Copyright (c) 2025, University Osnabrück
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *     * Redistributions of source code must retain the above copyright
+ *       notice, this list of conditions and the following disclaimer.
+ *     * Redistributions in binary form must reproduce the above copyright
+ *       notice, this list of conditions and the following disclaimer in the
+ *       documentation and/or other materials provided with the distribution.
+ *     * Neither the name of the University Osnabrück nor the
+ *       names of its contributors may be used to endorse or promote products
+ *       derived from this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND
+ * ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+ * WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+ * DISCLAIMED. IN NO EVENT SHALL University Osnabrück BE LIABLE FOR ANY
+ * DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES
+ * (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+ * LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND
+ * ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ * (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS
+ * SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+/**
+ * @file
+ * 
+ * @brief Vectorizable reduction helpers for structure-of-arrays data
+ * 
+ * The loops work on plain float pointers and accumulate into 
+ * RMAGINE_SOA_LANES independent partial sums. In contrast to a single 
+ * accumulator this is vectorized by the compiler without -ffast-math
+ *
+ * @copyright Copyright (c) 2025, University Osnabrück. All rights reserved.
+ * This project is released under the 3-Clause BSD License.
+ * 
+ */
+
+#ifndef RMAGINE_MATH_SOA_H
+#define RMAGINE_MATH_SOA_H
+
+#include <cstddef>
+
+#define RMAGINE_SOA_LANES 16
+
+namespace rmagine
+{
+
+/**
+ * @brief sum_i a[i] * b[i]
+ */
+inline float soa_dot(
+  const float* __restrict__ a, 
+  const float* __restrict__ b, 
+  size_t n)
+{
+  float acc[RMAGINE_SOA_LANES] = {0.0};
+  size_t i = 0;
+  for(; i + RMAGINE_SOA_LANES <= n; i += RMAGINE_SOA_LANES)
+  {
+    for(size_t j=0; j<RMAGINE_SOA_LANES; j++)
+    {
+      acc[j] += a[i + j] * b[i + j];
+    }
+  }
+  for(; i < n; i++)
+  {
+    acc[0] += a[i] * b[i];
+  }
+
+  float res = 0.0;
+  for(size_t j=0; j<RMAGINE_SOA_LANES; j++)
+  {
+    res += acc[j];
+  }
+  return res;
+}
+
+/**
+ * @brief sum_i a[i]
+ */
+inline float soa_sum(
+  const float* __restrict__ a, 
+  size_t n)
+{
+  float acc[RMAGINE_SOA_LANES] = {0.0};
+  size_t i = 0;
+  for(; i + RMAGINE_SOA_LANES <= n; i += RMAGINE_SOA_LANES)
+  {
+    for(size_t j=0; j<RMAGINE_SOA_LANES; j++)
+    {
+      acc[j] += a[i + j];
+    }
+  }
+  for(; i < n; i++)
+  {
+    acc[0] += a[i];
+  }
+
+  float res = 0.0;
+  for(size_t j=0; j<RMAGINE_SOA_LANES; j++)
+  {
+    res += acc[j];
+  }
+  return res;
+}
+
+} // namespace rmagine
+
+#endif // RMAGINE_MATH_SOA_H
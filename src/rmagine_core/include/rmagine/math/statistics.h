@@ -127,6 +127,58 @@ CrossStatistics statistics_p2l(
     const PointCloudView_<RAM>& model,
     const UmeyamaReductionConstraints params);
 
+/**
+ * @brief statistics_p2p for point clouds stored as structure of arrays.
+ * 
+ * Correspondences are processed in blocks. Inside a block every step 
+ * (transform, masking, distance check, mean and covariance) runs over 
+ * contiguous floats and is vectorized. The blocks are merged like in 
+ * the AoS version, so the result matches it up to rounding.
+ */
+void statistics_p2p(
+    const Transform& pre_transform,
+    const PointCloudSoAView_<RAM>& dataset,
+    const PointCloudSoAView_<RAM>& model,
+    const UmeyamaReductionConstraints params,
+    MemoryView<CrossStatistics>& stats);
+
+void statistics_p2p(
+    const Transform& pre_transform,
+    const PointCloudSoAView_<RAM>& dataset,
+    const PointCloudSoAView_<RAM>& model,
+    const UmeyamaReductionConstraints params,
+    CrossStatistics& stats);
+
+CrossStatistics statistics_p2p(
+    const Transform& pre_transform,
+    const PointCloudSoAView_<RAM>& dataset,
+    const PointCloudSoAView_<RAM>& model,
+    const UmeyamaReductionConstraints params);
+
+/**
+ * @brief statistics_p2l for point clouds stored as structure of arrays. 
+ * See the SoA statistics_p2p
+ */
+void statistics_p2l(
+    const Transform& pre_transform,
+    const PointCloudSoAView_<RAM>& dataset,
+    const PointCloudSoAView_<RAM>& model,
+    const UmeyamaReductionConstraints params,
+    MemoryView<CrossStatistics>& stats);
+
+void statistics_p2l(
+    const Transform& pre_transform,
+    const PointCloudSoAView_<RAM>& dataset,
+    const PointCloudSoAView_<RAM>& model,
+    const UmeyamaReductionConstraints params,
+    CrossStatistics& stats);
+
+CrossStatistics statistics_p2l(
+    const Transform& pre_transform,
+    const PointCloudSoAView_<RAM>& dataset,
+    const PointCloudSoAView_<RAM>& model,
+    const UmeyamaReductionConstraints params);
+
 /**
  * @brief Find out cross statistics between dataset and model, where the model consists of several objects (intances or geometries)
  * 
@@ -142,10 +194,14 @@ CrossStatistics statistics_p2l(
  * [-,-,-,0,2,-,-,-,1,-,-,-,-,3] -> requires 3 memory
  * but not like this
  * [-,-,-,1000,-,1] -> requires 1000 memory
+ * Measurements with model ids >= stats.size() (e.g. misses) are skipped.
  * 
- * @param pre_transform
- * @param dataset 
- * @param model 
+ * The measurements are reduced in parallel into one array of partial statistics per thread, 
+ * which are merged at the end. 
+ * 
+ * @param dataset          dataset points, optional mask and ids (filtered by params.dataset_id)
+ * @param model            model points, normals and object ids (required). Optional mask
+ * @param model_pretransforms  one transform per object, applied to the model points and normals
  * @param params 
  * @param[out] stats A list of stats
  */
@@ -163,17 +219,38 @@ void statistics_p2l_ow(
  * It returns one cross statistic per object id. Which can be used to deform the scene in a computationally efficient manner.
  * See: "Mesh-based Object Tracking for Dynamic Semantic 3D Scene Graphs via Ray Tracing"
  * 
- * @param pre_transform
+ * Sparse variant for arbitrary object ids: contains only objects with at least one correspondence.
+ * Measurements with the id std::numeric_limits<unsigned int>::max() (no object hit) are skipped.
+ * 
+ * @param pre_transform    applied to the dataset points
  * @param dataset 
- * @param model 
+ * @param model            model points, normals and object ids (required). Optional mask
  * @param params 
  * @return std::unordered_map<unsigned int, CrossStatistics> 
  */
-// std::unordered_map<unsigned int, CrossStatistics> statistics_p2l_ow(
-//     const PointCloudView_<RAM>& dataset,
-//     const Transform& pre_transform,
-//     const PointCloudView_<RAM>& model,
-//     const UmeyamaReductionConstraints params);
+std::unordered_map<unsigned int, CrossStatistics> statistics_p2l_ow(
+    const Transform& pre_transform,
+    const PointCloudView_<RAM>& dataset,
+    const PointCloudView_<RAM>& model,
+    const UmeyamaReductionConstraints params);
+
+/**
+ * @brief CPU version of the CUDA statistics_objectwise_p2l. 
+ * 
+ * The dataset and model are organized images of width x height. 
+ * For every object b the measurements inside the image region bboxes[b] (x: columns, y: rows, max exclusive) 
+ * are reduced to stats[b], using pre_transforms[b] and params[b]. 
+ * Objects are processed in parallel, large regions are split over several threads.
+ */
+void statistics_objectwise_p2l(
+    const MemoryView<Transform, RAM>& pre_transforms,
+    const PointCloudView_<RAM>& dataset,
+    const PointCloudView_<RAM>& model,
+    const unsigned int& width,
+    const unsigned int& height,
+    const MemoryView<UmeyamaReductionConstraints, RAM>& params,
+    const MemoryView<AABB, RAM>& bboxes,
+    MemoryView<CrossStatistics, RAM>& stats);
 
 } // namespace rmagine
 
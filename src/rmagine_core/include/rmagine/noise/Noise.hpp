@@ -43,6 +43,8 @@
 
 #include <rmagine/types/Memory.hpp>
 #include <memory>
+#include <cstdint>
+#include <atomic>
 
 namespace rmagine
 {
@@ -57,11 +59,60 @@ public:
 
     Noise(Options options = {42, 10000.0});
 
+    /**
+     * @brief Applies the noise to all ranges in parallel. 
+     * The noise of range i only depends on the seed, i and the number of
+     * previous calls, so results are identical for any number of threads.
+     */
     virtual void apply(MemoryView<float, RAM>& ranges) = 0;
+
+    /**
+     * @brief Applies the noise to a single range 
+     * 
+     * @param range   range to disturb
+     * @param id      index of the range, e.g. in the scan buffer
+     * @param stream  the n-th draw for this id
+     * @return disturbed range
+     */
+    virtual float applyAt(float range, uint64_t id, uint32_t stream) const = 0;
+
+    /**
+     * @brief Claim the stream for the next draw, as apply(ranges) does. 
+     * Used to apply the noise with applyAt, e.g. per ray while simulating. 
+     * Thread-safe
+     */
+    inline uint32_t nextStream()
+    {
+        return m_stream++;
+    }
+
+    /**
+     * @brief Stream that is used by the next call of apply(ranges)
+     */
+    inline uint32_t stream() const 
+    {
+        return m_stream;
+    }
+
+    /**
+     * @brief Restart the noise, so the next call of apply(ranges) 
+     * reproduces the noise of the first call
+     */
+    inline void reset(uint32_t stream = 0)
+    {
+        m_stream = stream;
+    }
+
 protected:
     Options m_options;
+
+    // incremented by every call of apply(ranges) or nextStream()
+    std::atomic<uint32_t> m_stream{0};
 };
 
+// ranges per task of the parallel noise kernels
+#define RMAGINE_NOISE_BLOCK_SIZE 4096
+
 using NoisePtr = std::shared_ptr<Noise>;
 
 } // namespace rmagine
@@ -42,7 +42,6 @@
 #define RMAGINE_NOISE_REL_GAUSSIAN_NOISE_HPP
 
 #include "Noise.hpp"
-#include <random>
 
 namespace rmagine
 {
@@ -57,15 +56,12 @@ public:
         Noise::Options opt = {});
 
     void apply(MemoryView<float, RAM>& ranges);
+
+    float applyAt(float range, uint64_t id, uint32_t stream) const;
 private:
     float m_mean;
     float m_stddev;
     float m_range_exp;
-
-    std::random_device rd{};
-    std::mt19937 gen{rd()};
-    // std::default_random_engine gen;
-    std::normal_distribution<float> m_distr;
 };
 
 using RelGaussianNoisePtr = std::shared_ptr<RelGaussianNoise>;
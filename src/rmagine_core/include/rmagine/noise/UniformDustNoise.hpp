@@ -42,7 +42,6 @@
 #define RMAGINE_NOISE_UNIFORM_DUST_NOISE_HPP
 
 #include "Noise.hpp"
-#include <random>
 
 namespace rmagine
 {
@@ -57,16 +56,11 @@ public:
 
     void apply(MemoryView<float, RAM>& ranges);
 
+    float applyAt(float range, uint64_t id, uint32_t stream) const;
+
 private:
     float m_hit_prob;
     float m_ret_prob;
-
-    std::random_device rd{};
-    std::mt19937 gen{rd()};
-    // std::default_random_engine gen;
-
-    std::uniform_real_distribution<float> m_distr;
-
 };
 
 using UniformDustNoisePtr = std::shared_ptr<UniformDustNoise>;
@@ -0,0 +1,333 @@
+/*
+ * Copyright (c) 2025, University Osnabrück
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *     * Redistributions of source code must retain the above copyright
+ *       notice, this list of conditions and the following disclaimer.
+ *     * Redistributions in binary form must reproduce the above copyright
+ *       notice, this list of conditions and the following disclaimer in the
+ *       documentation and/or other materials provided with the distribution.
+ *     * Neither the name of the University Osnabrück nor the
+ *       names of its contributors may be used to endorse or promote products
+ *       derived from this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND
+ * ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+ * WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+ * DISCLAIMED. IN NO EVENT SHALL University Osnabrück BE LIABLE FOR ANY
+ * DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES
+ * (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+ * LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND
+ * ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ * (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS
+ * SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+/**
+ * @file
+ * 
+ * @brief Counter-based random numbers (Philox4x32-10)
+ * 
+ * Philox maps a 128 bit counter and a 64 bit key to 128 random bits. 
+ * There is no state: the random numbers of an element only depend on 
+ * the key (seed) and the counter (e.g. element index), so they can be 
+ * generated in any order, by any number of threads, on CPU and GPU.
+ * 
+ * See: Salmon et al., "Parallel Random Numbers: As Easy as 1, 2, 3", SC11
+ *
+ * @copyright Copyright (c) 2025, University Osnabrück. All rights reserved.
+ * This project is released under the 3-Clause BSD License.
+ * 
+ */
+
+#ifndef RMAGINE_NOISE_PHILOX_H
+#define RMAGINE_NOISE_PHILOX_H
+
+#include <rmagine/types/shared_functions.h>
+#include <cstdint>
+#include <cstring>
+#include <cmath>
+
+namespace rmagine
+{
+
+/**
+ * @brief Philox4x32 with 10 rounds. Writes 4 random 32 bit words to out
+ */
+RMAGINE_INLINE_FUNCTION
+void philox4x32_10(
+    const uint32_t ctr[4],
+    const uint32_t key[2],
+    uint32_t out[4])
+{
+  constexpr uint32_t M0 = 0xD2511F53;
+  constexpr uint32_t M1 = 0xCD9E8D57;
+  constexpr uint32_t W0 = 0x9E3779B9;
+  constexpr uint32_t W1 = 0xBB67AE85;
+
+  uint32_t c0 = ctr[0], c1 = ctr[1], c2 = ctr[2], c3 = ctr[3];
+  uint32_t k0 = key[0], k1 = key[1];
+
+  for(unsigned int r=0; r<10; r++)
+  {
+    const uint64_t p0 = static_cast<uint64_t>(M0) * c0;
+    const uint64_t p1 = static_cast<uint64_t>(M1) * c2;
+    
+    const uint32_t n0 = static_cast<uint32_t>(p1 >> 32) ^ c1 ^ k0;
+    const uint32_t n1 = static_cast<uint32_t>(p1);
+    const uint32_t n2 = static_cast<uint32_t>(p0 >> 32) ^ c3 ^ k1;
+    const uint32_t n3 = static_cast<uint32_t>(p0);
+    c0 = n0; c1 = n1; c2 = n2; c3 = n3;
+
+    k0 += W0;
+    k1 += W1;
+  }
+
+  out[0] = c0; out[1] = c1; out[2] = c2; out[3] = c3;
+}
+
+/**
+ * @brief 4 random words of element id in stream. 
+ * 
+ * @param seed     user seed, e.g. Noise::Options::seed
+ * @param id       element index
+ * @param stream   distinguishes several draws for the same elements (e.g. the n-th call of apply)
+ * @param salt     distinguishes different users of the same seed (e.g. noise models)
+ */
+RMAGINE_INLINE_FUNCTION
+void philox_random(
+    const uint32_t seed,
+    const uint64_t id,
+    const uint32_t stream,
+    const uint32_t salt,
+    uint32_t out[4])
+{
+  const uint32_t ctr[4] = {
+    static_cast<uint32_t>(id), 
+    static_cast<uint32_t>(id >> 32), 
+    stream, 
+    salt};
+  const uint32_t key[2] = {seed, 0x5EED5EED};
+  philox4x32_10(ctr, key, out);
+}
+
+/**
+ * @brief Random word to uniform float in (0, 1]
+ */
+RMAGINE_INLINE_FUNCTION
+float uniform_float(const uint32_t x)
+{
+  // 24 significant bits
+  // through int32, which converts faster than uint32 and vectorizes
+  return static_cast<float>(static_cast<int32_t>((x >> 8) + 1)) * (1.0f / 16777216.0f);
+}
+
+// Branch-free float approximations (Cephes polynomials, ~1 ulp). 
+// Unlike libm they vectorize and give the same bits on every platform, 
+// which keeps generated noise reproducible across machines.
+
+/**
+ * @brief Natural logarithm for positive, normal x
+ */
+RMAGINE_INLINE_FUNCTION
+float philox_logf(const float x)
+{
+  uint32_t bits;
+  memcpy(&bits, &x, sizeof(float));
+  // x = 2^k * m with m in [sqrt(0.5), sqrt(2)). 
+  // Integer ops only, selects would keep the compiler from vectorizing
+  const int32_t k = static_cast<int32_t>(bits - 0x3F3504F3) >> 23;
+  bits -= static_cast<uint32_t>(k) << 23;
+  float m;
+  memcpy(&m, &bits, sizeof(float));
+  const float e = static_cast<float>(k);
+
+  const float t = m - 1.0f;
+  const float z = t * t;
+  float p = 7.0376836292e-2f;
+  p = p * t - 1.1514610310e-1f;
+  p = p * t + 1.1676998740e-1f;
+  p = p * t - 1.2420140846e-1f;
+  p = p * t + 1.4249322787e-1f;
+  p = p * t - 1.6668057665e-1f;
+  p = p * t + 2.0000714765e-1f;
+  p = p * t - 2.4999993993e-1f;
+  p = p * t + 3.3333331174e-1f;
+  
+  float y = t * z * p;
+  y += e * -2.12194440e-4f;
+  y += -0.5f * z;
+  return t + y + e * 0.693359375f;
+}
+
+/**
+ * @brief Exponential function for finite x. Clamps x to [-87, 88]
+ */
+RMAGINE_INLINE_FUNCTION
+float philox_expf(const float x_in)
+{
+  // clamp to [-87, 88]. Blended, since selects followed by 
+  // arithmetic are turned into branches that do not vectorize
+  const float lo = (x_in < -87.0f) ? 1.0f : 0.0f;
+  const float hi = (x_in > 88.0f) ? 1.0f : 0.0f;
+  const float x = x_in + lo * (-87.0f - x_in) + hi * (88.0f - x_in);
+  // x = n * ln2 + r. floor via truncation, which vectorizes without SSE4.1
+  const float v = x * 1.44269504088896341f + 0.5f;
+  int ni = static_cast<int>(v);
+  ni -= (static_cast<float>(ni) > v) ? 1 : 0;
+  const float n = static_cast<float>(ni);
+  float r = x - n * 0.693359375f;
+  r = r + n * 2.12194440e-4f;
+
+  float p = 1.9875691500e-4f;
+  p = p * r + 1.3981999507e-3f;
+  p = p * r + 8.3334519073e-3f;
+  p = p * r + 4.1665795894e-2f;
+  p = p * r + 1.6666665459e-1f;
+  p = p * r + 5.0000001201e-1f;
+  const float y = p * r * r + r + 1.0f;
+
+  // scale by 2^n
+  const uint32_t bits = static_cast<uint32_t>(ni + 127) << 23;
+  float scale;
+  memcpy(&scale, &bits, sizeof(float));
+  return y * scale;
+}
+
+/**
+ * @brief sin(2 pi u) and cos(2 pi u) for u in [0, 1]
+ */
+RMAGINE_INLINE_FUNCTION
+void philox_sincos_2pi(const float u, float& s, float& c)
+{
+  // nearest quarter turn q, remaining angle x in [-pi/4, pi/4]
+  const float t = u * 4.0f;
+  // t >= 0: truncation is floor
+  const int qi = static_cast<int>(t + 0.5f);
+  const float x = (t - static_cast<float>(qi)) * 1.57079632679489662f;
+  const float z = x * x;
+
+  float ps = -1.9515295891e-4f;
+  ps = ps * z + 8.3321608736e-3f;
+  ps = ps * z - 1.6666654611e-1f;
+  const float sx = x + x * z * ps;
+
+  float pc = 2.443315711809948e-5f;
+  pc = pc * z - 1.388731625493765e-3f;
+  pc = pc * z + 4.166664568298827e-2f;
+  const float cx = 1.0f - 0.5f * z + z * z * pc;
+
+  // rotate by q quarter turns
+  const int quadrant = qi & 3;
+  const float s1 = (quadrant & 1) ? cx : sx;
+  const float c1 = (quadrant & 1) ? sx : cx;
+  s = (quadrant & 2) ? -s1 : s1;
+  c = ((quadrant + 1) & 2) ? -c1 : c1;
+}
+
+/**
+ * @brief 4 standard normal distributed floats from one Philox call 
+ * (Box-Muller on both pairs of random words, using sine and cosine)
+ */
+RMAGINE_INLINE_FUNCTION
+void philox_normal4(
+    const uint32_t seed,
+    const uint64_t group,
+    const uint32_t stream,
+    const uint32_t salt,
+    float out[4])
+{
+  uint32_t r[4];
+  philox_random(seed, group, stream, salt, r);
+
+  const float rad0 = sqrtf(-2.0f * philox_logf(uniform_float(r[0])));
+  const float rad1 = sqrtf(-2.0f * philox_logf(uniform_float(r[2])));
+  float s0, c0, s1, c1;
+  philox_sincos_2pi(uniform_float(r[1]), s0, c0);
+  philox_sincos_2pi(uniform_float(r[3]), s1, c1);
+
+  out[0] = rad0 * c0;
+  out[1] = rad0 * s0;
+  out[2] = rad1 * c1;
+  out[3] = rad1 * s1;
+}
+
+/**
+ * @brief Standard normal distributed float of element id. 
+ * The elements 4k, ..., 4k+3 share one Philox call (see philox_normal4)
+ */
+RMAGINE_INLINE_FUNCTION
+float philox_normal(
+    const uint32_t seed,
+    const uint64_t id,
+    const uint32_t stream,
+    const uint32_t salt)
+{
+  float n[4];
+  philox_normal4(seed, id / 4, stream, salt, n);
+  return n[id % 4];
+}
+
+// groups of 4 normals that philox_normals processes at once
+#define RMAGINE_PHILOX_NORMAL_BLOCK 64
+
+/**
+ * @brief Standard normal floats of the groups [group_begin, group_begin + n_groups)
+ * to out[0, 4 * n_groups). Same values as philox_normal4, computed stage by 
+ * stage over the whole block so that the compiler vectorizes every stage. 
+ * 
+ * @param n_groups  at most RMAGINE_PHILOX_NORMAL_BLOCK
+ */
+inline void philox_normals(
+    const uint32_t seed,
+    const uint64_t group_begin,
+    const unsigned int n_groups,
+    const uint32_t stream,
+    const uint32_t salt,
+    float* out)
+{
+  constexpr unsigned int B = RMAGINE_PHILOX_NORMAL_BLOCK;
+  uint32_t w[4][B];
+  float rad[2][B];
+  float s[2][B];
+  float c[2][B];
+
+  for(unsigned int j=0; j<n_groups; j++)
+  {
+    uint32_t r[4];
+    philox_random(seed, group_begin + j, stream, salt, r);
+    w[0][j] = r[0]; w[1][j] = r[1]; w[2][j] = r[2]; w[3][j] = r[3];
+  }
+
+  for(unsigned int j=0; j<n_groups; j++)
+  {
+    rad[0][j] = -2.0f * philox_logf(uniform_float(w[0][j]));
+    rad[1][j] = -2.0f * philox_logf(uniform_float(w[2][j]));
+  }
+
+  for(unsigned int j=0; j<n_groups; j++)
+  {
+    rad[0][j] = sqrtf(rad[0][j]);
+    rad[1][j] = sqrtf(rad[1][j]);
+  }
+
+  for(unsigned int j=0; j<n_groups; j++)
+  {
+    philox_sincos_2pi(uniform_float(w[1][j]), s[0][j], c[0][j]);
+    philox_sincos_2pi(uniform_float(w[3][j]), s[1][j], c[1][j]);
+  }
+
+  for(unsigned int j=0; j<n_groups; j++)
+  {
+    out[4 * j + 0] = rad[0][j] * c[0][j];
+    out[4 * j + 1] = rad[0][j] * s[0][j];
+    out[4 * j + 2] = rad[1][j] * c[1][j];
+    out[4 * j + 3] = rad[1][j] * s[1][j];
+  }
+}
+
+} // namespace rmagine
+
+#endif // RMAGINE_NOISE_PHILOX_H
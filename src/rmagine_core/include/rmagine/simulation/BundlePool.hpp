@@ -0,0 +1,203 @@
+/*
+ * Copyright (c) 2025, University Osnabrück. 
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *     * Redistributions of source code must retain the above copyright
+ *       notice, this list of conditions and the following disclaimer.
+ *     * Redistributions in binary form must reproduce the above copyright
+ *       notice, this list of conditions and the following disclaimer in the
+ *       documentation and/or other materials provided with the distribution.
+ *     * Neither the name of the University Osnabrück nor the
+ *       names of its contributors may be used to endorse or promote products
+ *       derived from this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND
+ * ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+ * WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+ * DISCLAIMED. IN NO EVENT SHALL University Osnabrück BE LIABLE FOR ANY
+ * DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES
+ * (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+ * LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND
+ * ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ * (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS
+ * SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+/**
+ * @file
+ * 
+ * @brief Fixed set of preallocated result bundles that are handed out 
+ * to simulation calls and given back automatically
+ *
+ * @copyright Copyright (c) 2025, University Osnabrück. All rights reserved.
+ * This project is released under the 3-Clause BSD License.
+ */
+
+#ifndef RMAGINE_SIMULATION_BUNDLE_POOL_HPP
+#define RMAGINE_SIMULATION_BUNDLE_POOL_HPP
+
+#include <rmagine/simulation/SimulationResults.hpp>
+#include <rmagine/util/exceptions.h>
+
+#include <memory>
+#include <mutex>
+#include <condition_variable>
+#include <vector>
+
+namespace rmagine
+{
+
+/**
+ * @brief Pool of result bundles of equal size. With the default of two 
+ * buffers a consumer can read the results of one simulation while the 
+ * next one is written to the other buffer (double buffering).
+ * 
+ * Buffers are allocated once with resize_memory_bundle. acquire() blocks 
+ * until a buffer is free, which limits the number of simulations in flight.
+ * A buffer is returned to the pool as soon as the last copy of its handle 
+ * is destroyed. Handles may outlive the pool.
+ * 
+ * acquire() may be called from several threads at once.
+ * 
+ * @code{cpp}
+ * using ResT = Bundle<Ranges<RAM> >;
+ * BundlePool<ResT> pool(model.getWidth(), model.getHeight(), Nposes);
+ * 
+ * std::shared_ptr<ResT> res = pool.acquire();
+ * sim.simulate(Tbm, *res);
+ * // res goes back to the pool when it runs out of scope
+ * @endcode
+ * 
+ * @tparam BundleT   Bundle of simulation results
+ * @tparam MemT      memory type of the bundle's attributes
+ */
+template<typename BundleT, typename MemT = RAM>
+class BundlePool
+{
+public:
+    using Handle = std::shared_ptr<BundleT>;
+
+    BundlePool(
+        unsigned int W,
+        unsigned int H,
+        unsigned int N = 1,
+        size_t Nbuffers = 2)
+    :m_state(std::make_shared<State>())
+    ,m_W(W)
+    ,m_H(H)
+    ,m_N(N)
+    ,m_Nbuffers(Nbuffers)
+    {
+        if(Nbuffers == 0)
+        {
+            RM_THROW(Exception, "BundlePool requires at least one buffer");
+        }
+
+        m_state->buffers.resize(Nbuffers);
+        for(size_t i=0; i<Nbuffers; i++)
+        {
+            m_state->buffers[i] = std::make_unique<BundleT>();
+            resize_memory_bundle<MemT>(*m_state->buffers[i], W, H, N);
+        }
+    }
+
+    /**
+     * @brief Take a free buffer out of the pool. Blocks until one is available.
+     */
+    Handle acquire()
+    {
+        std::unique_lock<std::mutex> lock(m_state->mutex);
+        m_state->cond.wait(lock, [this]{ return !m_state->buffers.empty(); });
+        return take_(lock);
+    }
+
+    /**
+     * @brief Non-blocking variant of acquire. Returns nullptr if every buffer is in use.
+     */
+    Handle tryAcquire()
+    {
+        std::unique_lock<std::mutex> lock(m_state->mutex);
+        if(m_state->buffers.empty())
+        {
+            return nullptr;
+        }
+        return take_(lock);
+    }
+
+    /**
+     * @brief Number of buffers that are currently not in use
+     */
+    size_t available() const
+    {
+        std::lock_guard<std::mutex> lock(m_state->mutex);
+        return m_state->buffers.size();
+    }
+
+    inline size_t size() const
+    {
+        return m_Nbuffers;
+    }
+
+    inline unsigned int width() const
+    {
+        return m_W;
+    }
+
+    inline unsigned int height() const
+    {
+        return m_H;
+    }
+
+    inline unsigned int poses() const
+    {
+        return m_N;
+    }
+
+    /**
+     * @brief Number of elements per attribute of one buffer (W*H*N)
+     */
+    inline size_t capacity() const
+    {
+        return static_cast<size_t>(m_W) * m_H * m_N;
+    }
+
+private:
+
+    struct State
+    {
+        std::mutex mutex;
+        std::condition_variable cond;
+        std::vector<std::unique_ptr<BundleT> > buffers;
+    };
+
+    Handle take_(std::unique_lock<std::mutex>& lock)
+    {
+        BundleT* buffer = m_state->buffers.back().release();
+        m_state->buffers.pop_back();
+        lock.unlock();
+
+        // the deleter only keeps the shared state alive, not the pool
+        std::shared_ptr<State> state = m_state;
+        return Handle(buffer, [state](BundleT* b)
+        {
+            {
+                std::lock_guard<std::mutex> lock(state->mutex);
+                state->buffers.emplace_back(b);
+            }
+            state->cond.notify_one();
+        });
+    }
+
+    std::shared_ptr<State> m_state;
+
+    unsigned int m_W;
+    unsigned int m_H;
+    unsigned int m_N;
+    size_t m_Nbuffers;
+};
+
+} // namespace rmagine
+
+#endif // RMAGINE_SIMULATION_BUNDLE_POOL_HPP
@@ -43,6 +43,7 @@
 #include <rmagine/types/Bundle.hpp>
 #include <rmagine/types/Memory.hpp>
 #include <rmagine/math/types.h>
+#include <rmagine/types/VectorSoA.hpp>
 
 namespace rmagine
 {
@@ -87,6 +88,29 @@ struct Normals {
     Memory<Vector, MemT> normals;
 };
 
+/**
+ * @brief Points computed by the simulators, stored as separate x, y and z planes
+ * 
+ * Use instead of Points if the results are processed by vectorized 
+ * code, e.g. the VectorSoAView_ overloads of memory_math and statistics
+ * 
+ * @tparam MemT 
+ */
+template<typename MemT>
+struct PointsSoA {
+    VectorSoA_<MemT> points_soa;
+};
+
+/**
+ * @brief Normals computed by the simulators, stored as separate x, y and z planes
+ * 
+ * @tparam MemT 
+ */
+template<typename MemT>
+struct NormalsSoA {
+    VectorSoA_<MemT> normals_soa;
+};
+
 /**
  * @brief FaceIds computed by the simulators
  * 
@@ -199,6 +223,16 @@ static void resize_memory_bundle(BundleT& res,
         res.Normals<MemT>::normals.resize(W*H*N);
     }
 
+    if constexpr(BundleT::template has<PointsSoA<MemT> >())
+    {
+        res.PointsSoA<MemT>::points_soa.resize(W*H*N);
+    }
+
+    if constexpr(BundleT::template has<NormalsSoA<MemT> >())
+    {
+        res.NormalsSoA<MemT>::normals_soa.resize(W*H*N);
+    }
+
     if constexpr(BundleT::template has<FaceIds<MemT> >())
     {
         res.FaceIds<MemT>::face_ids.resize(W*H*N);
@@ -72,6 +72,10 @@ public:
 
     MemoryView(DataT* mem, size_t N);
 
+    // shallow: the copy views the same memory.
+    // Declared since operator= below copies the data instead
+    MemoryView(const MemoryView<DataT, MemT>& o) = default;
+
     // no virtual: we dont want to destruct memory of a view
     ~MemoryView();
 
@@ -0,0 +1,161 @@
+/**
+ * Copyright (c) 2025, University Osnabrück
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *     * Redistributions of source code must retain the above copyright
+ *       notice, this list of conditions and the following disclaimer.
+ *     * Redistributions in binary form must reproduce the above copyright
+ *       notice, this list of conditions and the following disclaimer in the
+ *       documentation and/or other materials provided with the distribution.
+ *     * Neither the name of the University Osnabrück nor the
+ *       names of its contributors may be used to endorse or promote products
+ *       derived from this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND
+ * ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+ * WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+ * DISCLAIMED. IN NO EVENT SHALL University Osnabrück BE LIABLE FOR ANY
+ * DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES
+ * (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+ * LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND
+ * ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ * (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS
+ * SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+/*
+ * MemoryHuge.hpp
+ */
+
+#ifndef RMAGINE_MEMORY_HUGE_HPP
+#define RMAGINE_MEMORY_HUGE_HPP
+
+#include <rmagine/types/Memory.hpp>
+#include <rmagine/types/MemoryPooled.hpp>
+#include <cstddef>
+#include <cstring>
+
+namespace rmagine
+{
+
+// HUGE PAGE HELPER
+namespace huge
+{
+
+/**
+ * @brief Size of a transparent huge page. Mappings are aligned to 
+ * and rounded up to multiples of this size
+ */
+static constexpr size_t HUGE_PAGE_SIZE = size_t(2) << 20;
+
+/**
+ * @brief Map 'bytes' bytes of anonymous, zero-initialized memory 
+ * backed by transparent huge pages if the system supports them.
+ * 
+ * @return HUGE_PAGE_SIZE aligned memory, nullptr if bytes == 0
+ */
+void* allocate(size_t bytes);
+
+/**
+ * @brief Grow or shrink a mapping. The data is preserved, on Linux 
+ * without copying (mremap). The result is HUGE_PAGE_SIZE aligned as well
+ */
+void* reallocate(void* ptr, size_t bytes_old, size_t bytes_new);
+
+/**
+ * @brief Unmap memory of allocate/reallocate. 'bytes' has to be the 
+ * size passed to them
+ */
+void deallocate(void* ptr, size_t bytes);
+
+/**
+ * @brief Touch the pages of [ptr, ptr + bytes) in parallel so that the 
+ * page faults are paid up front and spread over the TBB workers. 
+ * The range is distributed with a static partitioner: with a first-touch 
+ * NUMA policy each page lands on the node of the worker that will 
+ * write the same part of the buffer in a statically partitioned loop.
+ */
+void prefault(void* ptr, size_t bytes);
+
+/**
+ * @brief Let allocate and reallocate prefault new pages. Default: false 
+ * (pages are faulted in on first write)
+ */
+void set_prefault(bool enable);
+
+bool prefault_enabled();
+
+} // namespace huge
+
+/**
+ * @brief Host memory for very large buffers, e.g. a Bundle of hundreds of 
+ * thousands of simulated scans. Allocated with mmap and advised to use 
+ * transparent huge pages (MADV_HUGEPAGE), which reduces TLB misses 
+ * and the number of page faults on first touch. 
+ * See huge::set_prefault for parallel NUMA-aware first touch.
+ * 
+ * Every allocation occupies at least one huge page, use RAM or RAM_POOLED 
+ * for small buffers.
+ */
+struct RAM_HUGE {
+    
+    template<typename DataT>
+    static DataT* alloc(size_t N);
+
+    template<typename DataT>
+    static DataT* realloc(DataT* mem, size_t Nold, size_t Nnew);
+
+    template<typename DataT>
+    static void free(DataT* mem, size_t N);
+};
+
+// Copy Functions
+template<typename DataT>
+void copy(const MemoryView<DataT, RAM_HUGE>& from, MemoryView<DataT, RAM_HUGE>& to)
+{
+    std::memcpy(to.raw(), from.raw(), sizeof(DataT) * from.size());
+}
+
+template<typename DataT>
+void copy(const MemoryView<DataT, RAM>& from, MemoryView<DataT, RAM_HUGE>& to)
+{
+    std::memcpy(to.raw(), from.raw(), sizeof(DataT) * from.size());
+}
+
+template<typename DataT>
+void copy(const MemoryView<DataT, RAM_HUGE>& from, MemoryView<DataT, RAM>& to)
+{
+    std::memcpy(to.raw(), from.raw(), sizeof(DataT) * from.size());
+}
+
+template<typename DataT>
+void copy(const MemoryView<DataT, RAM_POOLED>& from, MemoryView<DataT, RAM_HUGE>& to)
+{
+    std::memcpy(to.raw(), from.raw(), sizeof(DataT) * from.size());
+}
+
+template<typename DataT>
+void copy(const MemoryView<DataT, RAM_HUGE>& from, MemoryView<DataT, RAM_POOLED>& to)
+{
+    std::memcpy(to.raw(), from.raw(), sizeof(DataT) * from.size());
+}
+
+template<typename DataT>
+void copy(const DataT& from, MemoryView<DataT, RAM_HUGE>& to)
+{
+    std::memcpy(to.raw(), &from, sizeof(DataT));
+}
+
+template<typename DataT>
+void copy(const MemoryView<DataT, RAM_HUGE>& from, DataT& to)
+{
+    std::memcpy(&to, from.raw(), sizeof(DataT));
+}
+
+} // namespace rmagine
+
+#include "MemoryHuge.tcc"
+
+#endif // RMAGINE_MEMORY_HUGE_HPP
@@ -0,0 +1,65 @@
+#include "MemoryHuge.hpp"
+
+namespace rmagine 
+{
+
+/// RAM_HUGE
+template<typename DataT>
+DataT* RAM_HUGE::alloc(size_t N)
+{
+    DataT* ret = static_cast<DataT*>(huge::allocate(N * sizeof(DataT)));
+
+    if constexpr( !std::is_trivially_constructible<DataT>::value )
+    {
+        for(size_t i=0; i<N; i++)
+        {
+            new (&ret[i]) DataT();
+        }
+    }
+
+    return ret;
+}
+
+template<typename DataT>
+DataT* RAM_HUGE::realloc(DataT* mem, size_t Nold, size_t Nnew)
+{
+    if constexpr( !std::is_trivially_destructible<DataT>::value )
+    {
+        // destruct elements that are cut off
+        for(size_t i=Nnew; i<Nold; i++)
+        {
+            mem[i].~DataT();
+        }
+    }
+
+    DataT* ret = static_cast<DataT*>(
+        huge::reallocate(mem, Nold * sizeof(DataT), Nnew * sizeof(DataT)));
+
+    if constexpr( !std::is_trivially_constructible<DataT>::value )
+    {
+        // construct new elements
+        for(size_t i=Nold; i < Nnew; i++)
+        {
+            new (&ret[i]) DataT();
+        }
+    }
+
+    return ret;
+}
+
+template<typename DataT>
+void RAM_HUGE::free(DataT* mem, size_t N)
+{
+    if constexpr( !std::is_trivially_destructible<DataT>::value )
+    {
+        // we need to destruct the elements first
+        for(size_t i=0; i<N; i++)
+        {
+            mem[i].~DataT();
+        }
+    }
+
+    huge::deallocate(mem, N * sizeof(DataT));
+}
+
+} // namespace rmagine
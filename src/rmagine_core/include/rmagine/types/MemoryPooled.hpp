@@ -0,0 +1,155 @@
+/**
+ * Copyright (c) 2025, University Osnabrück
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *     * Redistributions of source code must retain the above copyright
+ *       notice, this list of conditions and the following disclaimer.
+ *     * Redistributions in binary form must reproduce the above copyright
+ *       notice, this list of conditions and the following disclaimer in the
+ *       documentation and/or other materials provided with the distribution.
+ *     * Neither the name of the University Osnabrück nor the
+ *       names of its contributors may be used to endorse or promote products
+ *       derived from this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND
+ * ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+ * WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+ * DISCLAIMED. IN NO EVENT SHALL University Osnabrück BE LIABLE FOR ANY
+ * DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES
+ * (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+ * LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND
+ * ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ * (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS
+ * SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+/*
+ * MemoryPooled.hpp
+ */
+
+#ifndef RMAGINE_MEMORY_POOLED_HPP
+#define RMAGINE_MEMORY_POOLED_HPP
+
+#include <rmagine/types/Memory.hpp>
+#include <cstddef>
+#include <cstring>
+#include <algorithm>
+
+namespace rmagine
+{
+
+// POOL HELPER
+namespace pooled
+{
+
+/**
+ * @brief Alignment of every pooled block: one cache line, one AVX-512 register
+ */
+static constexpr size_t ALIGNMENT = 64;
+
+/**
+ * @brief Take a block of at least 'bytes' bytes from the pool. 
+ * A new block is only requested from the system if the pool has no 
+ * free block of the same size class. Thread-safe.
+ * 
+ * @return 64 byte aligned memory, nullptr if bytes == 0
+ */
+void* allocate(size_t bytes);
+
+/**
+ * @brief Give a block back to the pool. 'bytes' has to be the size 
+ * that was passed to allocate. Thread-safe.
+ */
+void deallocate(void* ptr, size_t bytes);
+
+/**
+ * @brief Size that is actually reserved for a request of 'bytes' bytes.
+ * Blocks of the same size class are interchangeable.
+ */
+size_t size_class(size_t bytes);
+
+/**
+ * @brief Return every cached block to the system
+ */
+void release();
+
+/**
+ * @brief Free blocks beyond this limit are returned to the system 
+ * instead of being cached. Default: 2 GiB
+ */
+void set_cache_limit(size_t bytes);
+
+struct PoolStats 
+{
+    // bytes in free blocks waiting for reuse
+    size_t cached_bytes;
+    // bytes currently handed out
+    size_t used_bytes;
+    // allocations served from the cache
+    size_t hits;
+    // allocations that went to the system
+    size_t misses;
+};
+
+PoolStats stats();
+
+} // namespace pooled
+
+/**
+ * @brief Host memory that is 64 byte aligned and recycled by a 
+ * size-class pool. Freed buffers are kept for reuse, so allocating 
+ * buffers of the same size every frame causes neither allocator 
+ * calls nor page faults after the first frame.
+ * 
+ * Resizing within the same size class keeps the buffer.
+ */
+struct RAM_POOLED {
+    
+    template<typename DataT>
+    static DataT* alloc(size_t N);
+
+    template<typename DataT>
+    static DataT* realloc(DataT* mem, size_t Nold, size_t Nnew);
+
+    template<typename DataT>
+    static void free(DataT* mem, size_t N);
+};
+
+// Copy Functions
+template<typename DataT>
+void copy(const MemoryView<DataT, RAM_POOLED>& from, MemoryView<DataT, RAM_POOLED>& to)
+{
+    std::memcpy(to.raw(), from.raw(), sizeof(DataT) * from.size());
+}
+
+template<typename DataT>
+void copy(const MemoryView<DataT, RAM>& from, MemoryView<DataT, RAM_POOLED>& to)
+{
+    std::memcpy(to.raw(), from.raw(), sizeof(DataT) * from.size());
+}
+
+template<typename DataT>
+void copy(const MemoryView<DataT, RAM_POOLED>& from, MemoryView<DataT, RAM>& to)
+{
+    std::memcpy(to.raw(), from.raw(), sizeof(DataT) * from.size());
+}
+
+template<typename DataT>
+void copy(const DataT& from, MemoryView<DataT, RAM_POOLED>& to)
+{
+    std::memcpy(to.raw(), &from, sizeof(DataT));
+}
+
+template<typename DataT>
+void copy(const MemoryView<DataT, RAM_POOLED>& from, DataT& to)
+{
+    std::memcpy(&to, from.raw(), sizeof(DataT));
+}
+
+} // namespace rmagine
+
+#include "MemoryPooled.tcc"
+
+#endif // RMAGINE_MEMORY_POOLED_HPP
@@ -0,0 +1,63 @@
+#include "MemoryPooled.hpp"
+
+namespace rmagine 
+{
+
+/// RAM_POOLED
+template<typename DataT>
+DataT* RAM_POOLED::alloc(size_t N)
+{
+    DataT* ret = static_cast<DataT*>(pooled::allocate(N * sizeof(DataT)));
+
+    if constexpr( !std::is_trivially_constructible<DataT>::value )
+    {
+        for(size_t i=0; i<N; i++)
+        {
+            new (&ret[i]) DataT();
+        }
+    }
+
+    return ret;
+}
+
+template<typename DataT>
+DataT* RAM_POOLED::realloc(DataT* mem, size_t Nold, size_t Nnew)
+{
+    DataT* ret = mem;
+
+    // the block is large enough as long as the size class does not change
+    if(pooled::size_class(Nold * sizeof(DataT)) != pooled::size_class(Nnew * sizeof(DataT)))
+    {
+        ret = static_cast<DataT*>(pooled::allocate(Nnew * sizeof(DataT)));
+        std::memcpy(ret, mem, sizeof(DataT) * std::min(Nold, Nnew));
+        pooled::deallocate(mem, Nold * sizeof(DataT));
+    }
+
+    if constexpr( !std::is_trivially_constructible<DataT>::value )
+    {
+        // construct new elements
+        for(size_t i=Nold; i < Nnew; i++)
+        {
+            new (&ret[i]) DataT();
+        }
+    }
+
+    return ret;
+}
+
+template<typename DataT>
+void RAM_POOLED::free(DataT* mem, size_t N)
+{
+    if constexpr( !std::is_trivially_destructible<DataT>::value )
+    {
+        // we need to destruct the elements first
+        for(size_t i=0; i<N; i++)
+        {
+            mem[i].~DataT();
+        }
+    }
+
+    pooled::deallocate(mem, N * sizeof(DataT));
+}
+
+} // namespace rmagine
@@ -43,6 +43,7 @@
 
 #include <rmagine/types/Memory.hpp>
 #include <rmagine/math/types.h>
+#include <rmagine/types/VectorSoA.hpp>
 
 namespace rmagine
 {
@@ -72,6 +73,20 @@ struct PointCloudView_
 // default: RAM
 using PointCloudView = PointCloudView_<RAM>;
 
+/**
+ * @brief PointCloudView_ with points and normals stored as structure of arrays
+ */
+template<typename MemT>
+struct PointCloudSoAView_
+{
+  VectorSoAView_<MemT>            points; // required
+  MemoryView<uint8_t, MemT>       mask         = MemoryView<uint8_t, MemT>::Empty();
+  VectorSoAView_<MemT>            normals      = VectorSoAView_<MemT>::Empty();
+  MemoryView<unsigned int, MemT>  ids          = MemoryView<uint32_t, MemT>::Empty();
+};
+
+using PointCloudSoAView = PointCloudSoAView_<RAM>;
+
 template<typename MemTto, typename MemTfrom>
 PointCloud_<MemTto> transfer(const PointCloudView_<MemTfrom>& from)
 {
@@ -0,0 +1,138 @@
+/*
+ * Copyright (c) 2025, University Osnabrück
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *     * Redistributions of source code must retain the above copyright
+ *       notice, this list of conditions and the following disclaimer.
+ *     * Redistributions in binary form must reproduce the above copyright
+ *       notice, this list of conditions and the following disclaimer in the
+ *       documentation and/or other materials provided with the distribution.
+ *     * Neither the name of the University Osnabrück nor the
+ *       names of its contributors may be used to endorse or promote products
+ *       derived from this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND
+ * ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+ * WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+ * DISCLAIMED. IN NO EVENT SHALL University Osnabrück BE LIABLE FOR ANY
+ * DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES
+ * (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+ * LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND
+ * ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ * (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS
+ * SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+/**
+ * @file
+ * 
+ * @brief Structure-of-arrays storage for 3D vectors
+ *
+ * @copyright Copyright (c) 2025, University Osnabrück. All rights reserved.
+ * This project is released under the 3-Clause BSD License.
+ * 
+ */
+
+#ifndef RMAGINE_TYPES_VECTOR_SOA_HPP
+#define RMAGINE_TYPES_VECTOR_SOA_HPP
+
+#include <rmagine/types/Memory.hpp>
+
+namespace rmagine
+{
+
+/**
+ * @brief Non-owning view on the x, y and z planes of a VectorSoA_
+ */
+template<typename MemT>
+struct VectorSoAView_
+{
+  MemoryView<float, MemT> x = MemoryView<float, MemT>::Empty();
+  MemoryView<float, MemT> y = MemoryView<float, MemT>::Empty();
+  MemoryView<float, MemT> z = MemoryView<float, MemT>::Empty();
+
+  static VectorSoAView_<MemT> Empty()
+  {
+    return {};
+  }
+
+  bool empty() const
+  {
+    return x.empty();
+  }
+
+  size_t size() const
+  {
+    return x.size();
+  }
+
+  VectorSoAView_<MemT> slice(size_t idx_start, size_t idx_end) const
+  {
+    return {
+      .x = x.slice(idx_start, idx_end),
+      .y = y.slice(idx_start, idx_end),
+      .z = z.slice(idx_start, idx_end)
+    };
+  }
+
+  VectorSoAView_<MemT> operator()(size_t idx_start, size_t idx_end) const
+  {
+    return slice(idx_start, idx_end);
+  }
+};
+
+using VectorSoAView = VectorSoAView_<RAM>;
+
+/**
+ * @brief N vectors stored as three planes x, y and z. 
+ * In contrast to Memory<Vector, MemT> loops over the elements 
+ * read contiguous floats and can be vectorized at full SIMD width
+ */
+template<typename MemT>
+struct VectorSoA_
+{
+  Memory<float, MemT> x;
+  Memory<float, MemT> y;
+  Memory<float, MemT> z;
+
+  VectorSoA_() = default;
+
+  VectorSoA_(size_t N)
+  :x(N), y(N), z(N)
+  {}
+
+  void resize(size_t N)
+  {
+    x.resize(N);
+    y.resize(N);
+    z.resize(N);
+  }
+
+  size_t size() const
+  {
+    return x.size();
+  }
+
+  operator VectorSoAView_<MemT>() const
+  {
+    return {
+      .x = x.slice(0, x.size()),
+      .y = y.slice(0, y.size()),
+      .z = z.slice(0, z.size())
+    };
+  }
+};
+
+using VectorSoA = VectorSoA_<RAM>;
+
+template<typename MemT>
+VectorSoAView_<MemT> watch(const VectorSoA_<MemT>& from)
+{
+  return from;
+}
+
+} // namespace rmagine
+
+#endif // RMAGINE_TYPES_VECTOR_SOA_HPP
@@ -0,0 +1,481 @@
+#include "rmagine/map/MapFile.hpp"
+
+#include <rmagine/util/exceptions.h>
+
+#include <algorithm>
+#include <cstring>
+#include <fstream>
+#include <type_traits>
+
+#include <tbb/parallel_reduce.h>
+#include <tbb/blocked_range.h>
+
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+namespace rmagine
+{
+
+namespace rmap
+{
+
+// the tables are read in place: their layout must not depend on the compiler
+static_assert(sizeof(GeometryRef) == 16, "rmap::GeometryRef layout changed");
+static_assert(sizeof(Header) == 56, "rmap::Header layout changed");
+static_assert(sizeof(MeshEntry) == 56, "rmap::MeshEntry layout changed");
+static_assert(sizeof(InstanceEntry) == 72, "rmap::InstanceEntry layout changed");
+static_assert(sizeof(Vertex) == 12 && sizeof(Face) == 12,
+    "Vertex and Face have to be 3 packed 32 bit values");
+static_assert(std::is_trivially_copyable<InstanceEntry>::value,
+    "rmap::InstanceEntry has to be trivially copyable");
+
+} // namespace rmap
+
+namespace
+{
+
+inline uint64_t align(uint64_t offset)
+{
+    return (offset + rmap::ALIGNMENT - 1) & ~(rmap::ALIGNMENT - 1);
+}
+
+/**
+ * @brief Sequential writer that keeps track of the file offset
+ */
+class Writer
+{
+public:
+    Writer(const std::string& filename)
+    :m_filename(filename)
+    ,m_out(filename, std::ios::binary | std::ios::trunc)
+    {
+        if(!m_out)
+        {
+            RM_THROW(Exception, "Could not open '" + filename + "' for writing");
+        }
+    }
+
+    void write(const void* data, uint64_t bytes)
+    {
+        m_out.write(reinterpret_cast<const char*>(data), bytes);
+        m_offset += bytes;
+    }
+
+    template<typename T>
+    void write(const T& value)
+    {
+        write(&value, sizeof(T));
+    }
+
+    void pad(uint64_t offset)
+    {
+        static const char zeros[rmap::ALIGNMENT] = {0};
+        while(m_offset < offset)
+        {
+            write(zeros, std::min<uint64_t>(offset - m_offset, rmap::ALIGNMENT));
+        }
+    }
+
+    void finish()
+    {
+        m_out.flush();
+        if(!m_out)
+        {
+            RM_THROW(Exception, "Could not write '" + m_filename + "'");
+        }
+    }
+
+private:
+    std::string m_filename;
+    std::ofstream m_out;
+    uint64_t m_offset = 0;
+};
+
+size_t geom_id_limit(
+    const std::vector<rmap::GeometryRef>& root,
+    const std::vector<MapFileInstance>& instances)
+{
+    size_t num_refs = root.size();
+    for(const MapFileInstance& instance : instances)
+    {
+        num_refs += instance.geometries.size();
+    }
+    return std::max<size_t>(num_refs, rmap::GEOM_ID_LIMIT);
+}
+
+void check_refs(
+    const std::vector<rmap::GeometryRef>& refs,
+    const size_t num_meshes,
+    const size_t num_instances,
+    const size_t max_geom_id,
+    const std::string& where)
+{
+    for(const rmap::GeometryRef& ref : refs)
+    {
+        const size_t n = (ref.type == rmap::GeometryType::MESH) ? num_meshes : num_instances;
+        if((ref.type != rmap::GeometryType::MESH && ref.type != rmap::GeometryType::INSTANCE)
+            || ref.index >= n)
+        {
+            RM_THROW(Exception, "Invalid geometry reference in " + where);
+        }
+        if(ref.geom_id >= max_geom_id)
+        {
+            RM_THROW(Exception, "Geometry id " + std::to_string(ref.geom_id) + " out of range in " + where);
+        }
+    }
+}
+
+// rejects cycles and hierarchies deeper than rmap::MAX_INSTANCE_DEPTH. 
+// Iterative: the hierarchy is not trusted yet. Requires valid references
+void check_instance_depth(
+    const std::vector<MapFileInstance>& instances,
+    const std::string& where)
+{
+    // 0: not visited, 1: on the stack, 2: done
+    std::vector<uint8_t> state(instances.size(), 0);
+    std::vector<uint32_t> depth(instances.size(), 1);
+    // instance and the next of its geometries to visit
+    std::vector<std::pair<uint32_t, size_t> > stack;
+
+    for(uint32_t start=0; start<instances.size(); start++)
+    {
+        if(state[start] != 0)
+        {
+            continue;
+        }
+
+        state[start] = 1;
+        stack.push_back({start, 0});
+        while(!stack.empty())
+        {
+            const uint32_t i = stack.back().first;
+            const std::vector<rmap::GeometryRef>& geometries = instances[i].geometries;
+
+            if(stack.back().second < geometries.size())
+            {
+                const rmap::GeometryRef& ref = geometries[stack.back().second++];
+                if(ref.type != rmap::GeometryType::INSTANCE || state[ref.index] == 2)
+                {
+                    continue;
+                }
+                if(state[ref.index] == 1)
+                {
+                    RM_THROW(Exception, "Instance '" + instances[ref.index].name 
+                        + "' references itself in " + where);
+                }
+                state[ref.index] = 1;
+                stack.push_back({ref.index, 0});
+                continue;
+            }
+
+            for(const rmap::GeometryRef& ref : geometries)
+            {
+                if(ref.type == rmap::GeometryType::INSTANCE)
+                {
+                    depth[i] = std::max(depth[i], depth[ref.index] + 1);
+                }
+            }
+            if(depth[i] > rmap::MAX_INSTANCE_DEPTH)
+            {
+                RM_THROW(Exception, "Instances nested deeper than " 
+                    + std::to_string(rmap::MAX_INSTANCE_DEPTH) + " in " + where);
+            }
+            state[i] = 2;
+            stack.pop_back();
+        }
+    }
+}
+
+bool faces_valid(
+    const MemoryView<Face, RAM>& faces,
+    const size_t num_vertices)
+{
+    const Face* data = faces.raw();
+    return tbb::parallel_reduce(tbb::blocked_range<size_t>(0, faces.size(), 4096), true,
+        [&](const tbb::blocked_range<size_t>& r, bool valid)
+    {
+        for(size_t i=r.begin(); i<r.end() && valid; i++)
+        {
+            valid = data[i].v0 < num_vertices 
+                && data[i].v1 < num_vertices 
+                && data[i].v2 < num_vertices;
+        }
+        return valid;
+    }, [](bool a, bool b) { return a && b; });
+}
+
+} // anonymous namespace
+
+void write_map_file(
+    const std::string& filename,
+    const std::vector<MapFileMesh>& meshes,
+    const std::vector<MapFileInstance>& instances,
+    const std::vector<rmap::GeometryRef>& root)
+{
+    for(const MapFileMesh& mesh : meshes)
+    {
+        if(mesh.face_normals.size() != mesh.faces.size()
+            || (!mesh.vertex_normals.empty() && mesh.vertex_normals.size() != mesh.vertices.size()))
+        {
+            RM_THROW(Exception, "Mesh '" + mesh.name + "': normals do not match vertices or faces");
+        }
+        if(!faces_valid(mesh.faces, mesh.vertices.size()))
+        {
+            RM_THROW(Exception, "Mesh '" + mesh.name + "': face index out of range");
+        }
+    }
+
+    const size_t max_geom_id = geom_id_limit(root, instances);
+    check_refs(root, meshes.size(), instances.size(), max_geom_id, "root scene");
+    for(const MapFileInstance& instance : instances)
+    {
+        check_refs(instance.geometries, meshes.size(), instances.size(), max_geom_id, 
+            "instance '" + instance.name + "'");
+    }
+    check_instance_depth(instances, "'" + filename + "'");
+
+    // 1. layout
+    rmap::Header header = {};
+    header.magic = rmap::MAGIC;
+    header.version = rmap::VERSION;
+    header.num_meshes = meshes.size();
+    header.num_instances = instances.size();
+    header.num_root_geometries = root.size();
+
+    uint64_t offset = sizeof(rmap::Header);
+    header.meshes_offset = offset;
+    offset += sizeof(rmap::MeshEntry) * meshes.size();
+    header.instances_offset = offset;
+    offset += sizeof(rmap::InstanceEntry) * instances.size();
+    header.root_offset = offset;
+    offset += sizeof(rmap::GeometryRef) * root.size();
+
+    std::vector<rmap::InstanceEntry> instance_entries(instances.size());
+    for(size_t i=0; i<instances.size(); i++)
+    {
+        rmap::InstanceEntry& entry = instance_entries[i];
+        entry = {};
+        entry.T = instances[i].T;
+        entry.scale = instances[i].scale;
+        entry.num_geometries = instances[i].geometries.size();
+        entry.geometries_offset = offset;
+        offset += sizeof(rmap::GeometryRef) * instances[i].geometries.size();
+    }
+
+    std::vector<rmap::MeshEntry> mesh_entries(meshes.size());
+    for(size_t i=0; i<meshes.size(); i++)
+    {
+        mesh_entries[i] = {};
+        mesh_entries[i].name_offset = offset;
+        mesh_entries[i].name_length = meshes[i].name.size();
+        offset += meshes[i].name.size();
+    }
+    for(size_t i=0; i<instances.size(); i++)
+    {
+        instance_entries[i].name_offset = offset;
+        instance_entries[i].name_length = instances[i].name.size();
+        offset += instances[i].name.size();
+    }
+
+    for(size_t i=0; i<meshes.size(); i++)
+    {
+        rmap::MeshEntry& entry = mesh_entries[i];
+        entry.num_vertices = meshes[i].vertices.size();
+        entry.num_faces = meshes[i].faces.size();
+        entry.has_vertex_normals = !meshes[i].vertex_normals.empty();
+
+        entry.vertices_offset = align(offset);
+        offset = entry.vertices_offset + sizeof(Vertex) * entry.num_vertices;
+        entry.faces_offset = align(offset);
+        offset = entry.faces_offset + sizeof(Face) * entry.num_faces;
+        entry.face_normals_offset = align(offset);
+        offset = entry.face_normals_offset + sizeof(Vector) * entry.num_faces;
+        if(entry.has_vertex_normals)
+        {
+            entry.vertex_normals_offset = align(offset);
+            offset = entry.vertex_normals_offset + sizeof(Vector) * entry.num_vertices;
+        }
+    }
+
+    // padding behind the last buffer: at least rmap::VERTEX_PADDING
+    header.file_size = align(offset) + rmap::ALIGNMENT;
+
+    // 2. write
+    Writer out(filename);
+    out.write(header);
+    out.write(mesh_entries.data(), sizeof(rmap::MeshEntry) * mesh_entries.size());
+    out.write(instance_entries.data(), sizeof(rmap::InstanceEntry) * instance_entries.size());
+    out.write(root.data(), sizeof(rmap::GeometryRef) * root.size());
+    for(const MapFileInstance& instance : instances)
+    {
+        out.write(instance.geometries.data(), sizeof(rmap::GeometryRef) * instance.geometries.size());
+    }
+    for(const MapFileMesh& mesh : meshes)
+    {
+        out.write(mesh.name.data(), mesh.name.size());
+    }
+    for(const MapFileInstance& instance : instances)
+    {
+        out.write(instance.name.data(), instance.name.size());
+    }
+
+    for(size_t i=0; i<meshes.size(); i++)
+    {
+        const rmap::MeshEntry& entry = mesh_entries[i];
+        out.pad(entry.vertices_offset);
+        out.write(meshes[i].vertices.raw(), sizeof(Vertex) * entry.num_vertices);
+        out.pad(entry.faces_offset);
+        out.write(meshes[i].faces.raw(), sizeof(Face) * entry.num_faces);
+        out.pad(entry.face_normals_offset);
+        out.write(meshes[i].face_normals.raw(), sizeof(Vector) * entry.num_faces);
+        if(entry.has_vertex_normals)
+        {
+            out.pad(entry.vertex_normals_offset);
+            out.write(meshes[i].vertex_normals.raw(), sizeof(Vector) * entry.num_vertices);
+        }
+    }
+    out.pad(header.file_size);
+    out.finish();
+}
+
+MapFile::MapFile(const std::string& filename)
+:m_filename(filename)
+{
+    const int fd = open(filename.c_str(), O_RDONLY);
+    if(fd < 0)
+    {
+        RM_THROW(Exception, "Could not open map file '" + filename + "'");
+    }
+
+    struct stat st;
+    if(fstat(fd, &st) != 0 || static_cast<size_t>(st.st_size) < sizeof(rmap::Header))
+    {
+        close(fd);
+        RM_THROW(Exception, "'" + filename + "' is no rmagine map file");
+    }
+
+    m_bytes = st.st_size;
+    // private: writes to the buffers are copied on write and never reach the file
+    m_data = mmap(nullptr, m_bytes, PROT_READ | PROT_WRITE, MAP_PRIVATE, fd, 0);
+    close(fd);
+
+    if(m_data == MAP_FAILED)
+    {
+        m_data = nullptr;
+        RM_THROW(Exception, "Could not map '" + filename + "'");
+    }
+
+    char* data = static_cast<char*>(m_data);
+
+    // every range of the file is checked before it is used
+    auto check = [&](uint64_t offset, uint64_t bytes, uint64_t alignment)
+    {
+        if(offset > m_bytes || bytes > m_bytes - offset || offset % alignment != 0)
+        {
+            munmap(m_data, m_bytes);
+            m_data = nullptr;
+            RM_THROW(Exception, "'" + filename + "' is corrupted");
+        }
+    };
+
+    rmap::Header header;
+    memcpy(&header, data, sizeof(rmap::Header));
+    if(header.magic != rmap::MAGIC || header.version != rmap::VERSION || header.file_size != m_bytes)
+    {
+        munmap(m_data, m_bytes);
+        m_data = nullptr;
+        RM_THROW(Exception, "'" + filename + "' is no rmagine map file of version "
+            + std::to_string(rmap::VERSION));
+    }
+
+    check(header.meshes_offset, sizeof(rmap::MeshEntry) * uint64_t(header.num_meshes), alignof(rmap::MeshEntry));
+    check(header.instances_offset, sizeof(rmap::InstanceEntry) * uint64_t(header.num_instances), alignof(rmap::InstanceEntry));
+    check(header.root_offset, sizeof(rmap::GeometryRef) * uint64_t(header.num_root_geometries), alignof(rmap::GeometryRef));
+
+    const rmap::MeshEntry* mesh_entries = reinterpret_cast<const rmap::MeshEntry*>(data + header.meshes_offset);
+    const rmap::InstanceEntry* instance_entries = reinterpret_cast<const rmap::InstanceEntry*>(data + header.instances_offset);
+    const rmap::GeometryRef* root = reinterpret_cast<const rmap::GeometryRef*>(data + header.root_offset);
+
+    m_meshes.reserve(header.num_meshes);
+    for(uint32_t i=0; i<header.num_meshes; i++)
+    {
+        const rmap::MeshEntry& e = mesh_entries[i];
+        check(e.name_offset, e.name_length, 1);
+        check(e.vertices_offset, sizeof(Vertex) * uint64_t(e.num_vertices) + rmap::VERTEX_PADDING, rmap::ALIGNMENT);
+        check(e.faces_offset, sizeof(Face) * uint64_t(e.num_faces), rmap::ALIGNMENT);
+        check(e.face_normals_offset, sizeof(Vector) * uint64_t(e.num_faces), rmap::ALIGNMENT);
+        if(e.has_vertex_normals)
+        {
+            check(e.vertex_normals_offset, sizeof(Vector) * uint64_t(e.num_vertices), rmap::ALIGNMENT);
+        }
+
+        Vector* vertex_normals = reinterpret_cast<Vector*>(data + e.vertex_normals_offset);
+        m_meshes.push_back(MapFileMesh{
+            std::string(data + e.name_offset, e.name_length),
+            MemoryView<Vertex, RAM>(reinterpret_cast<Vertex*>(data + e.vertices_offset), e.num_vertices),
+            MemoryView<Face, RAM>(reinterpret_cast<Face*>(data + e.faces_offset), e.num_faces),
+            MemoryView<Vector, RAM>(reinterpret_cast<Vector*>(data + e.face_normals_offset), e.num_faces),
+            e.has_vertex_normals ? MemoryView<Vector, RAM>(vertex_normals, e.num_vertices) 
+                                 : MemoryView<Vector, RAM>::Empty()
+        });
+
+        // the faces are handed to the ray tracers unchecked
+        if(!faces_valid(m_meshes.back().faces, e.num_vertices))
+        {
+            munmap(m_data, m_bytes);
+            m_data = nullptr;
+            RM_THROW(Exception, "'" + filename + "' is corrupted: face index out of range in mesh '" 
+                + m_meshes.back().name + "'");
+        }
+    }
+
+    m_instances.resize(header.num_instances);
+    for(uint32_t i=0; i<header.num_instances; i++)
+    {
+        const rmap::InstanceEntry& e = instance_entries[i];
+        check(e.name_offset, e.name_length, 1);
+        check(e.geometries_offset, sizeof(rmap::GeometryRef) * uint64_t(e.num_geometries), alignof(rmap::GeometryRef));
+
+        const rmap::GeometryRef* refs = reinterpret_cast<const rmap::GeometryRef*>(data + e.geometries_offset);
+        m_instances[i].name.assign(data + e.name_offset, e.name_length);
+        m_instances[i].T = e.T;
+        m_instances[i].scale = e.scale;
+        m_instances[i].geometries.assign(refs, refs + e.num_geometries);
+    }
+
+    m_root.assign(root, root + header.num_root_geometries);
+
+    try {
+        const size_t max_geom_id = geom_id_limit(m_root, m_instances);
+        check_refs(m_root, m_meshes.size(), m_instances.size(), max_geom_id, "'" + filename + "'");
+        for(const MapFileInstance& instance : m_instances)
+        {
+            check_refs(instance.geometries, m_meshes.size(), m_instances.size(), max_geom_id, 
+                "'" + filename + "'");
+        }
+        check_instance_depth(m_instances, "'" + filename + "'");
+    } catch(...) {
+        munmap(m_data, m_bytes);
+        m_data = nullptr;
+        throw;
+    }
+}
+
+MapFile::~MapFile()
+{
+    if(m_data)
+    {
+        munmap(m_data, m_bytes);
+    }
+}
+
+bool is_map_file(const std::string& filename)
+{
+    const std::string ext = ".rmap";
+    return filename.size() >= ext.size()
+        && filename.compare(filename.size() - ext.size(), ext.size(), ext) == 0;
+}
+
+} // namespace rmagine
@@ -0,0 +1,314 @@
+#include "rmagine/math/math_batched.h"
+
+#include <tbb/parallel_for.h>
+#include <tbb/parallel_reduce.h>
+
+// batches larger than this are reduced by several threads
+#define RMAGINE_MATH_BATCHED_BLOCK_SIZE 4096
+
+namespace rmagine
+{
+
+/**
+ * @brief Reduces the elements [begin, end) with acc_f(acc, i).
+ * Splits the range over several threads if it is large
+ */
+template<typename T, typename AccF>
+T reduce_range(
+  const size_t begin,
+  const size_t end,
+  const T& zero,
+  const AccF& acc_f)
+{
+  if(end - begin <= RMAGINE_MATH_BATCHED_BLOCK_SIZE)
+  {
+    T acc = zero;
+    for(size_t i=begin; i<end; i++)
+    {
+      acc_f(acc, i);
+    }
+    return acc;
+  }
+
+  return tbb::parallel_reduce(
+    tbb::blocked_range<size_t>(begin, end, RMAGINE_MATH_BATCHED_BLOCK_SIZE), zero,
+    [&](const tbb::blocked_range<size_t>& r, T acc)
+    {
+      for(size_t i=r.begin(); i<r.end(); i++)
+      {
+        acc_f(acc, i);
+      }
+      return acc;
+    },
+    [](const T& a, const T& b)
+    {
+      return a + b;
+    });
+}
+
+/**
+ * @brief Reduces every batch of Nelements / res.size() consecutive elements to res[b]
+ */
+template<typename T, typename AccF>
+void reduce_batched(
+  const size_t Nelements,
+  const T& zero,
+  const AccF& acc_f,
+  MemoryView<T, RAM>& res)
+{
+  const size_t Nbatches = res.size();
+  if(Nbatches == 0)
+  {
+    return;
+  }
+  const size_t batchSize = Nelements / Nbatches;
+
+  tbb::parallel_for(tbb::blocked_range<size_t>(0, Nbatches),
+    [&](const tbb::blocked_range<size_t>& r)
+  {
+    for(size_t b=r.begin(); b<r.end(); b++)
+    {
+      res[b] = reduce_range(b * batchSize, (b + 1) * batchSize, zero, acc_f);
+    }
+  });
+}
+
+template<typename T>
+void sum_batched_generic(
+  const MemoryView<T, RAM>& data,
+  const T& zero,
+  MemoryView<T, RAM>& sums)
+{
+  reduce_batched(data.size(), zero, [&](T& acc, const size_t i)
+  {
+    acc += data[i];
+  }, sums);
+}
+
+template<typename T, typename MaskT>
+void sum_batched_masked_generic(
+  const MemoryView<T, RAM>& data,
+  const MemoryView<MaskT, RAM>& mask,
+  const T& zero,
+  MemoryView<T, RAM>& sums)
+{
+  reduce_batched(data.size(), zero, [&](T& acc, const size_t i)
+  {
+    if(mask[i] > 0)
+    {
+      acc += data[i];
+    }
+  }, sums);
+}
+
+//////////
+// #sumBatched
+void sumBatched(
+    const MemoryView<Vector, RAM>& data,
+    MemoryView<Vector, RAM>& sums)
+{
+  sum_batched_generic(data, Vector::Zeros(), sums);
+}
+
+Memory<Vector, RAM> sumBatched(
+    const MemoryView<Vector, RAM>& data,
+    size_t batchSize)
+{
+  Memory<Vector, RAM> sums(data.size() / batchSize);
+  sumBatched(data, sums);
+  return sums;
+}
+
+void sumBatched(
+    const MemoryView<Matrix3x3, RAM>& data,
+    MemoryView<Matrix3x3, RAM>& sums)
+{
+  sum_batched_generic(data, Matrix3x3::Zeros(), sums);
+}
+
+Memory<Matrix3x3, RAM> sumBatched(
+    const MemoryView<Matrix3x3, RAM>& data,
+    size_t batchSize)
+{
+  Memory<Matrix3x3, RAM> sums(data.size() / batchSize);
+  sumBatched(data, sums);
+  return sums;
+}
+
+void sumBatched(
+    const MemoryView<float, RAM>& data,
+    MemoryView<float, RAM>& sums)
+{
+  sum_batched_generic(data, 0.0f, sums);
+}
+
+Memory<float, RAM> sumBatched(
+    const MemoryView<float, RAM>& data,
+    size_t batchSize)
+{
+  Memory<float, RAM> sums(data.size() / batchSize);
+  sumBatched(data, sums);
+  return sums;
+}
+
+void sumBatched(
+    const MemoryView<unsigned int, RAM>& data,
+    MemoryView<unsigned int, RAM>& sums)
+{
+  sum_batched_generic(data, 0u, sums);
+}
+
+Memory<unsigned int, RAM> sumBatched(
+    const MemoryView<unsigned int, RAM>& data,
+    size_t batchSize)
+{
+  Memory<unsigned int, RAM> sums(data.size() / batchSize);
+  sumBatched(data, sums);
+  return sums;
+}
+
+//////////
+// #sumBatched masked
+void sumBatched(
+    const MemoryView<Vector, RAM>& data,
+    const MemoryView<bool, RAM>& mask,
+    MemoryView<Vector, RAM>& sums)
+{
+  sum_batched_masked_generic(data, mask, Vector::Zeros(), sums);
+}
+
+Memory<Vector, RAM> sumBatched(
+    const MemoryView<Vector, RAM>& data,
+    const MemoryView<bool, RAM>& mask,
+    size_t batchSize)
+{
+  Memory<Vector, RAM> sums(data.size() / batchSize);
+  sumBatched(data, mask, sums);
+  return sums;
+}
+
+void sumBatched(
+    const MemoryView<Vector, RAM>& data,
+    const MemoryView<unsigned int, RAM>& mask,
+    MemoryView<Vector, RAM>& sums)
+{
+  sum_batched_masked_generic(data, mask, Vector::Zeros(), sums);
+}
+
+Memory<Vector, RAM> sumBatched(
+    const MemoryView<Vector, RAM>& data,
+    const MemoryView<unsigned int, RAM>& mask,
+    size_t batchSize)
+{
+  Memory<Vector, RAM> sums(data.size() / batchSize);
+  sumBatched(data, mask, sums);
+  return sums;
+}
+
+void sumBatched(
+    const MemoryView<Vector, RAM>& data,
+    const MemoryView<uint8_t, RAM>& mask,
+    MemoryView<Vector, RAM>& sums)
+{
+  sum_batched_masked_generic(data, mask, Vector::Zeros(), sums);
+}
+
+Memory<Vector, RAM> sumBatched(
+    const MemoryView<Vector, RAM>& data,
+    const MemoryView<uint8_t, RAM>& mask,
+    size_t batchSize)
+{
+  Memory<Vector, RAM> sums(data.size() / batchSize);
+  sumBatched(data, mask, sums);
+  return sums;
+}
+
+////////
+// #covBatched
+// the outer products are accumulated directly.
+// Unlike the CUDA version no buffer of per-element matrices is needed
+inline void add_outer(
+  Matrix3x3& S,
+  const Vector& a,
+  const Vector& b)
+{
+  S(0,0) += a.x * b.x;
+  S(1,0) += a.x * b.y;
+  S(2,0) += a.x * b.z;
+  S(0,1) += a.y * b.x;
+  S(1,1) += a.y * b.y;
+  S(2,1) += a.y * b.z;
+  S(0,2) += a.z * b.x;
+  S(1,2) += a.z * b.y;
+  S(2,2) += a.z * b.z;
+}
+
+void covBatched(
+    const MemoryView<Vector, RAM>& m1,
+    const MemoryView<Vector, RAM>& m2,
+    MemoryView<Matrix3x3, RAM>& covs)
+{
+  reduce_batched(m1.size(), Matrix3x3::Zeros(), [&](Matrix3x3& S, const size_t i)
+  {
+    add_outer(S, m1[i], m2[i]);
+  }, covs);
+
+  if(covs.size() == 0)
+  {
+    return;
+  }
+
+  const float batchSize = static_cast<float>(m1.size() / covs.size());
+  for(size_t b=0; b<covs.size(); b++)
+  {
+    covs[b] /= batchSize;
+  }
+}
+
+Memory<Matrix3x3, RAM> covBatched(
+    const MemoryView<Vector, RAM>& m1,
+    const MemoryView<Vector, RAM>& m2,
+    unsigned int batchSize)
+{
+  Memory<Matrix3x3, RAM> covs(m1.size() / batchSize);
+  covBatched(m1, m2, covs);
+  return covs;
+}
+
+void covBatched(
+    const MemoryView<Vector, RAM>& m1,
+    const MemoryView<Vector, RAM>& m2,
+    const MemoryView<bool, RAM>& corr,
+    const MemoryView<unsigned int, RAM>& ncorr,
+    MemoryView<Matrix3x3, RAM>& covs)
+{
+  reduce_batched(m1.size(), Matrix3x3::Zeros(), [&](Matrix3x3& S, const size_t i)
+  {
+    if(corr[i])
+    {
+      add_outer(S, m1[i], m2[i]);
+    }
+  }, covs);
+
+  for(size_t b=0; b<covs.size(); b++)
+  {
+    if(ncorr[b] > 0)
+    {
+      covs[b] /= static_cast<float>(ncorr[b]);
+    }
+  }
+}
+
+Memory<Matrix3x3, RAM> covBatched(
+    const MemoryView<Vector, RAM>& m1,
+    const MemoryView<Vector, RAM>& m2,
+    const MemoryView<bool, RAM>& corr,
+    const MemoryView<unsigned int, RAM>& ncorr,
+    unsigned int batchSize)
+{
+  Memory<Matrix3x3, RAM> covs(m1.size() / batchSize);
+  covBatched(m1, m2, corr, ncorr, covs);
+  return covs;
+}
+
+} // namespace rmagine
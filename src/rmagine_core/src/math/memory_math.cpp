@@ -7,11 +7,16 @@
 #include <rmagine/math/linalg.h>
 #include <rmagine/math/lie.h>
 #include <rmagine/math/optimization.h>
+#include <rmagine/math/soa.h>
+#include <rmagine/math/simd.h>
 
 #include <tbb/parallel_for.h>
+#include <tbb/parallel_reduce.h>
 
 // BLOCK SIZE USED FOR THE WHOLE FILE
 #define RMAGINE_MEMORY_MATH_BLOCK_SIZE 512
+// matrices per call of simd::svd3, a multiple of every lane count
+#define RMAGINE_MEMORY_MATH_SVD_LANES 64
 
 namespace rmagine {
 
@@ -157,6 +162,21 @@ void invert_generic(
   });
 }
 
+// C[i] = R * X[i] + t with the SIMD kernels. 
+// Larger blocks than the generic functions: the kernels run at memory bandwidth
+static void transform_points_parallel(
+    const Matrix3x3& R,
+    const Vector& t,
+    const MemoryView<Vector, RAM>& X,
+    MemoryView<Vector, RAM>& C)
+{
+  tbb::parallel_for( tbb::blocked_range<size_t>(0, X.size(), 8 * RMAGINE_MEMORY_MATH_BLOCK_SIZE),
+                       [&](const tbb::blocked_range<size_t>& r)
+  {
+    simd::transform_points(R, t, X.raw() + r.begin(), C.raw() + r.begin(), r.size());
+  });
+}
+
 /////////////
 // #multNxN
 ////////
@@ -392,7 +412,13 @@ void mult1xN(
     const MemoryView<Vector, RAM>& B, 
     MemoryView<Vector, RAM>& C)
 {
-  mult1xN_generic(a, B, C);
+  if(simd_level() != SimdLevel::SCALAR)
+  {
+    const Matrix3x3 R = a[0];
+    transform_points_parallel(R, {0.0, 0.0, 0.0}, B, C);
+  } else {
+    mult1xN_generic(a, B, C);
+  }
 }
 
 Memory<Vector, RAM> mult1xN(
@@ -426,7 +452,13 @@ void mult1xN(
     const MemoryView<Vector, RAM>& X,
     MemoryView<Vector, RAM>& C)
 {
-  mult1xN_generic(t, X, C);
+  if(simd_level() != SimdLevel::SCALAR)
+  {
+    const Matrix3x3 R = t[0].R;
+    transform_points_parallel(R, t[0].t, X, C);
+  } else {
+    mult1xN_generic(t, X, C);
+  }
 }
 
 Memory<Vector, RAM> mult1xN(
@@ -460,7 +492,12 @@ void mult1xN(
     const MemoryView<Vector, RAM>& X,
     MemoryView<Vector, RAM>& C)
 {
-  mult1xN_generic(m, X, C);
+  if(simd_level() != SimdLevel::SCALAR)
+  {
+    transform_points_parallel(m[0], {0.0, 0.0, 0.0}, X, C);
+  } else {
+    mult1xN_generic(m, X, C);
+  }
 }
 
 Memory<Vector, RAM> mult1xN(
@@ -733,6 +770,319 @@ Memory<Matrix3x3, RAM> cov(
   return C;
 }
 
+///////
+// #soa
+void to_soa(
+    const MemoryView<Vector, RAM>& A,
+    VectorSoAView_<RAM> B)
+{
+  tbb::parallel_for( tbb::blocked_range<size_t>(0, A.size(), RMAGINE_MEMORY_MATH_BLOCK_SIZE),
+                       [&](const tbb::blocked_range<size_t>& r)
+  {
+    for(size_t i=r.begin(); i<r.end(); ++i)
+    {
+      B.x[i] = A[i].x;
+      B.y[i] = A[i].y;
+      B.z[i] = A[i].z;
+    }
+  });
+}
+
+VectorSoA_<RAM> to_soa(
+    const MemoryView<Vector, RAM>& A)
+{
+  VectorSoA_<RAM> B(A.size());
+  to_soa(A, B);
+  return B;
+}
+
+void to_aos(
+    const VectorSoAView_<RAM>& A,
+    MemoryView<Vector, RAM>& B)
+{
+  tbb::parallel_for( tbb::blocked_range<size_t>(0, A.size(), RMAGINE_MEMORY_MATH_BLOCK_SIZE),
+                       [&](const tbb::blocked_range<size_t>& r)
+  {
+    for(size_t i=r.begin(); i<r.end(); ++i)
+    {
+      B[i] = {A.x[i], A.y[i], A.z[i]};
+    }
+  });
+}
+
+Memory<Vector, RAM> to_aos(
+    const VectorSoAView_<RAM>& A)
+{
+  Memory<Vector, RAM> B(A.size());
+  to_aos(A, B);
+  return B;
+}
+
+// C = M * X + t
+static void affine_soa(
+    const Matrix3x3& M,
+    const Vector& t,
+    const VectorSoAView_<RAM>& X,
+    VectorSoAView_<RAM>& C)
+{
+  const float m00 = M(0,0), m01 = M(0,1), m02 = M(0,2);
+  const float m10 = M(1,0), m11 = M(1,1), m12 = M(1,2);
+  const float m20 = M(2,0), m21 = M(2,1), m22 = M(2,2);
+
+  tbb::parallel_for( tbb::blocked_range<size_t>(0, X.size(), RMAGINE_MEMORY_MATH_BLOCK_SIZE),
+                       [&](const tbb::blocked_range<size_t>& r)
+  {
+    const float* xx = X.x.raw();
+    const float* xy = X.y.raw();
+    const float* xz = X.z.raw();
+    float* cx = C.x.raw();
+    float* cy = C.y.raw();
+    float* cz = C.z.raw();
+
+    for(size_t i=r.begin(); i<r.end(); ++i)
+    {
+      // read all components first: X and C may be the same
+      const float px = xx[i], py = xy[i], pz = xz[i];
+      cx[i] = m00 * px + m01 * py + m02 * pz + t.x;
+      cy[i] = m10 * px + m11 * py + m12 * pz + t.y;
+      cz[i] = m20 * px + m21 * py + m22 * pz + t.z;
+    }
+  });
+}
+
+void mult1xN(
+    const MemoryView<Transform, RAM>& t,
+    const VectorSoAView_<RAM>& X,
+    VectorSoAView_<RAM> C)
+{
+  const Matrix3x3 R = t[0].R;
+  affine_soa(R, t[0].t, X, C);
+}
+
+VectorSoA_<RAM> mult1xN(
+    const MemoryView<Transform, RAM>& t,
+    const VectorSoAView_<RAM>& X)
+{
+  VectorSoA_<RAM> C(X.size());
+  mult1xN(t, X, C);
+  return C;
+}
+
+void mult1xN(
+    const MemoryView<Matrix3x3, RAM>& m,
+    const VectorSoAView_<RAM>& X,
+    VectorSoAView_<RAM> C)
+{
+  affine_soa(m[0], {0.0, 0.0, 0.0}, X, C);
+}
+
+VectorSoA_<RAM> mult1xN(
+    const MemoryView<Matrix3x3, RAM>& m,
+    const VectorSoAView_<RAM>& X)
+{
+  VectorSoA_<RAM> C(X.size());
+  mult1xN(m, X, C);
+  return C;
+}
+
+template<typename Op>
+static void elementwise_soa(
+    const VectorSoAView_<RAM>& A,
+    const VectorSoAView_<RAM>& B,
+    VectorSoAView_<RAM>& C,
+    Op op)
+{
+  tbb::parallel_for( tbb::blocked_range<size_t>(0, A.size(), RMAGINE_MEMORY_MATH_BLOCK_SIZE),
+                       [&](const tbb::blocked_range<size_t>& r)
+  {
+    const float* ax = A.x.raw(); const float* bx = B.x.raw(); float* cx = C.x.raw();
+    const float* ay = A.y.raw(); const float* by = B.y.raw(); float* cy = C.y.raw();
+    const float* az = A.z.raw(); const float* bz = B.z.raw(); float* cz = C.z.raw();
+
+    for(size_t i=r.begin(); i<r.end(); ++i)
+    {
+      cx[i] = op(ax[i], bx[i]);
+    }
+    for(size_t i=r.begin(); i<r.end(); ++i)
+    {
+      cy[i] = op(ay[i], by[i]);
+    }
+    for(size_t i=r.begin(); i<r.end(); ++i)
+    {
+      cz[i] = op(az[i], bz[i]);
+    }
+  });
+}
+
+void addNxN(
+    const VectorSoAView_<RAM>& A,
+    const VectorSoAView_<RAM>& B,
+    VectorSoAView_<RAM> C)
+{
+  elementwise_soa(A, B, C, std::plus<float>());
+}
+
+VectorSoA_<RAM> addNxN(
+    const VectorSoAView_<RAM>& A,
+    const VectorSoAView_<RAM>& B)
+{
+  VectorSoA_<RAM> C(A.size());
+  addNxN(A, B, C);
+  return C;
+}
+
+void subNxN(
+    const VectorSoAView_<RAM>& A,
+    const VectorSoAView_<RAM>& B,
+    VectorSoAView_<RAM> C)
+{
+  elementwise_soa(A, B, C, std::minus<float>());
+}
+
+VectorSoA_<RAM> subNxN(
+    const VectorSoAView_<RAM>& A,
+    const VectorSoAView_<RAM>& B)
+{
+  VectorSoA_<RAM> C(A.size());
+  subNxN(A, B, C);
+  return C;
+}
+
+void sub(
+    const VectorSoAView_<RAM>& A,
+    const Vector& b,
+    VectorSoAView_<RAM> C)
+{
+  Matrix3x3 I;
+  I.setIdentity();
+  affine_soa(I, -b, A, C);
+}
+
+VectorSoA_<RAM> sub(
+    const VectorSoAView_<RAM>& A,
+    const Vector& b)
+{
+  VectorSoA_<RAM> C(A.size());
+  sub(A, b, C);
+  return C;
+}
+
+void sum(
+    const VectorSoAView_<RAM>& X, 
+    MemoryView<Vector, RAM>& res)
+{
+  res[0] = tbb::parallel_reduce(
+    tbb::blocked_range<size_t>(0, X.size(), 4096),
+    Vector{0.0, 0.0, 0.0},
+    [&](const tbb::blocked_range<size_t>& r, Vector acc)
+    {
+      const size_t n = r.end() - r.begin();
+      acc.x += soa_sum(X.x.raw() + r.begin(), n);
+      acc.y += soa_sum(X.y.raw() + r.begin(), n);
+      acc.z += soa_sum(X.z.raw() + r.begin(), n);
+      return acc;
+    },
+    std::plus<Vector>()
+  );
+}
+
+Memory<Vector, RAM> sum(
+    const VectorSoAView_<RAM>& X)
+{
+  Memory<Vector, RAM> res(1);
+  sum(X, res);
+  return res;
+}
+
+void mean(
+    const VectorSoAView_<RAM>& X,
+    MemoryView<Vector, RAM>& res)
+{
+  sum(X, res);
+  res[0] /= static_cast<float>(X.size());
+}
+
+Memory<Vector, RAM> mean(
+    const VectorSoAView_<RAM>& X)
+{
+  Memory<Vector, RAM> res(1);
+  mean(X, res);
+  return res;
+}
+
+void cov(
+    const VectorSoAView_<RAM>& v1,
+    const VectorSoAView_<RAM>& v2,
+    MemoryView<Matrix3x3, RAM>& C)
+{
+  Matrix3x3 Z;
+  Z.setZeros();
+
+  // same layout as the AoS version: S(j,i) = sum v1_i * v2_j
+  const Matrix3x3 S = tbb::parallel_reduce(
+    tbb::blocked_range<size_t>(0, v1.size(), 4096),
+    Z,
+    [&](const tbb::blocked_range<size_t>& r, Matrix3x3 acc)
+    {
+      const size_t n = r.end() - r.begin();
+      const float* a[3] = {v1.x.raw() + r.begin(), v1.y.raw() + r.begin(), v1.z.raw() + r.begin()};
+      const float* b[3] = {v2.x.raw() + r.begin(), v2.y.raw() + r.begin(), v2.z.raw() + r.begin()};
+      for(size_t i=0; i<3; i++)
+      {
+        for(size_t j=0; j<3; j++)
+        {
+          acc(j,i) += soa_dot(a[i], b[j], n);
+        }
+      }
+      return acc;
+    },
+    [](const Matrix3x3& A, const Matrix3x3& B)
+    {
+      return A + B;
+    }
+  );
+
+  C[0] = S / static_cast<float>(v1.size());
+}
+
+Memory<Matrix3x3, RAM> cov(
+    const VectorSoAView_<RAM>& v1,
+    const VectorSoAView_<RAM>& v2)
+{
+  Memory<Matrix3x3, RAM> C(1);
+  cov(v1, v2, C);
+  return C;
+}
+
+/**
+ * @brief Decomposes As with simd::svd3 in parallel blocks, 
+ * RMAGINE_MEMORY_MATH_SVD_LANES matrices per call, and passes 
+ * every result to f(i, U, s, V)
+ */
+template<typename F>
+void svd3_batched(
+    const MemoryView<Matrix3x3, RAM>& As,
+    const F& f)
+{
+  tbb::parallel_for( tbb::blocked_range<size_t>(0, As.size(), RMAGINE_MEMORY_MATH_BLOCK_SIZE),
+                       [&](const tbb::blocked_range<size_t>& r)
+  {
+    Matrix3x3 U[RMAGINE_MEMORY_MATH_SVD_LANES];
+    Matrix3x3 V[RMAGINE_MEMORY_MATH_SVD_LANES];
+    Vector3 s[RMAGINE_MEMORY_MATH_SVD_LANES];
+
+    for(size_t b=r.begin(); b<r.end(); b += RMAGINE_MEMORY_MATH_SVD_LANES)
+    {
+      const size_t n = std::min<size_t>(RMAGINE_MEMORY_MATH_SVD_LANES, r.end() - b);
+      simd::svd3(As.raw() + b, U, s, V, n);
+      for(size_t k=0; k<n; k++)
+      {
+        f(b + k, U[k], s[k], V[k]);
+      }
+    }
+  });
+}
+
 /**
  * @brief decompose A = UWV* using singular value decomposition
  */
@@ -742,13 +1092,21 @@ void svd(
     MemoryView<Matrix3x3, RAM>& Ws,
     MemoryView<Matrix3x3, RAM>& Vs)
 {
-  tbb::parallel_for( tbb::blocked_range<size_t>(0, As.size(), RMAGINE_MEMORY_MATH_BLOCK_SIZE),
-                       [&](const tbb::blocked_range<size_t>& r)
+  svd3_batched(As, [&](const size_t i, const Matrix3x3& U, const Vector3& s, const Matrix3x3& V)
   {
-    for(size_t i=r.begin(); i<r.end(); ++i)
+    // same convention as the single svd: W >= 0
+    Us[i] = U;
+    Ws[i].setZeros();
+    Ws[i](0,0) = s.x;
+    Ws[i](1,1) = s.y;
+    Ws[i](2,2) = fabs(s.z);
+    if(s.z < 0.0)
     {
-      svd(As[i], Us[i], Ws[i], Vs[i]);
+      Us[i](0,2) = -U(0,2);
+      Us[i](1,2) = -U(1,2);
+      Us[i](2,2) = -U(2,2);
     }
+    Vs[i] = V;
   });
 }
 
@@ -763,13 +1121,17 @@ void svd(
     MemoryView<Vector3, RAM>& ws,
     MemoryView<Matrix3x3, RAM>& Vs)
 {
-  tbb::parallel_for( tbb::blocked_range<size_t>(0, As.size()),
-                       [&](const tbb::blocked_range<size_t>& r)
+  svd3_batched(As, [&](const size_t i, const Matrix3x3& U, const Vector3& s, const Matrix3x3& V)
   {
-    for(size_t i=r.begin(); i<r.end(); ++i)
+    Us[i] = U;
+    ws[i] = {s.x, s.y, fabs(s.z)};
+    if(s.z < 0.0)
     {
-      svd(As[i], Us[i], ws[i], Vs[i]);
+      Us[i](0,2) = -U(0,2);
+      Us[i](1,2) = -U(1,2);
+      Us[i](2,2) = -U(2,2);
     }
+    Vs[i] = V;
   });
 }
 
@@ -781,13 +1143,9 @@ void umeyama_transform(
     const MemoryView<Matrix3x3, RAM>& Cs,
     const MemoryView<unsigned int, RAM>& n_meas)
 {
-  tbb::parallel_for( tbb::blocked_range<size_t>(0, Cs.size(), RMAGINE_MEMORY_MATH_BLOCK_SIZE),
-                       [&](const tbb::blocked_range<size_t>& r)
+  svd3_batched(Cs, [&](const size_t i, const Matrix3x3& U, const Vector3&, const Matrix3x3& V)
   {
-    for(size_t i=r.begin(); i<r.end(); ++i)
-    {
-      Ts[i] = umeyama_transform(ds[i], ms[i], Cs[i], n_meas[i]);
-    }
+    Ts[i] = umeyama_transform_svd(ds[i], ms[i], U, V, n_meas[i]);
   });
 }
 
@@ -808,13 +1166,9 @@ void umeyama_transform(
     const MemoryView<Vector3, RAM>& ms,
     const MemoryView<Matrix3x3, RAM>& Cs)
 {
-  tbb::parallel_for( tbb::blocked_range<size_t>(0, Cs.size(), RMAGINE_MEMORY_MATH_BLOCK_SIZE),
-                       [&](const tbb::blocked_range<size_t>& r)
+  svd3_batched(Cs, [&](const size_t i, const Matrix3x3& U, const Vector3&, const Matrix3x3& V)
   {
-    for(size_t i=r.begin(); i<r.end(); ++i)
-    {
-      Ts[i] = umeyama_transform(ds[i], ms[i], Cs[i]);
-    }
+    Ts[i] = umeyama_transform_svd(ds[i], ms[i], U, V);
   });
 }
 
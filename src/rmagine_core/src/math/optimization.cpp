@@ -1,4 +1,11 @@
 #include "rmagine/math/optimization.h"
+#include "rmagine/math/simd.h"
+
+#include <tbb/blocked_range.h>
+#include <tbb/parallel_reduce.h>
+
+// correspondences per task of the Gauss-Newton reductions
+#define RMAGINE_OPTIMIZATION_BLOCK_SIZE 1024
 
 namespace rmagine
 {
@@ -9,32 +16,23 @@ bool check(const Quaternion& q)
   return std::isfinite(q.x) && std::isfinite(q.y) && std::isfinite(q.z) && std::isfinite(q.w);
 }
 
-Transform umeyama_transform(
+Transform umeyama_transform_svd(
     const Vector3& d,
     const Vector3& m,
-    const Matrix3x3& C,
+    const Matrix3x3& U,
+    const Matrix3x3& V,
     const unsigned int n_meas)
 {
   Transform ret;
 
   if(n_meas > 0)
   {
-    // intermediate storage needed (yet)
-    Matrix3x3 U, S, V;
-    svd(C, U, S, V);
-    S.setIdentity();
-    if(U.det() * V.det() < 0)
-    {
-      S(2, 2) = -1;
-    }
-    ret.R.set(U * S * V.transpose());
+    // U and V are rotations, the reflection is moved to the last 
+    // singular value: the det(U) * det(V) correction reduces to U * V^T
+    ret.R.set(U * V.transpose());
     ret.R.normalizeInplace();
     
-    // There are still situations where SVD results in an invalid result.
-    // I assume there are numerical issues inside the rm::svd function.
-    // TODO: Take an evening and check if we can write rm::svd more stable
-    // or if we can detect situations earlier and skip a lot of computations
-    // This is a suboptimal workaround that covers some issues:
+    // degenerated covariances, e.g. NaN
     if(!check(ret.R))
     {
       ret.R.setIdentity();
@@ -48,10 +46,262 @@ Transform umeyama_transform(
   return ret;
 }
 
+Transform umeyama_transform(
+    const Vector3& d,
+    const Vector3& m,
+    const Matrix3x3& C,
+    const unsigned int n_meas)
+{
+  if(n_meas == 0)
+  {
+    return Transform::Identity();
+  }
+
+  Matrix3x3 U, V;
+  Vector3 s;
+  simd::svd3(C, U, s, V);
+  return umeyama_transform_svd(d, m, U, V, n_meas);
+}
+
 Transform umeyama_transform(
     const CrossStatistics& stats)
 {
   return umeyama_transform(stats.dataset_mean, stats.model_mean, stats.covariance, stats.n_meas);
 }
 
-} // namespace rmagine
\ No newline at end of file
+
+/**
+ * @brief Partial Gauss-Newton system of a range of correspondences. 
+ * Only the upper triangle of JTwJ is accumulated
+ */
+struct LinearSystem6
+{
+  Matrix_<float, 6, 6> JTwJ;
+  Matrix_<float, 6, 1> JTwr;
+  unsigned int n_meas;
+
+  static LinearSystem6 Zero()
+  {
+    LinearSystem6 ret;
+    ret.JTwJ.setZeros();
+    ret.JTwr.setZeros();
+    ret.n_meas = 0;
+    return ret;
+  }
+
+  inline void add(const float* J, const float w, const float r)
+  {
+    for(unsigned int i=0; i<6; i++)
+    {
+      const float wJi = w * J[i];
+      for(unsigned int j=i; j<6; j++)
+      {
+        JTwJ(i,j) += wJi * J[j];
+      }
+      JTwr(i,0) += wJi * r;
+    }
+  }
+
+  LinearSystem6 operator+(const LinearSystem6& o) const
+  {
+    LinearSystem6 ret;
+    ret.JTwJ = JTwJ + o.JTwJ;
+    ret.JTwr = JTwr + o.JTwr;
+    ret.n_meas = n_meas + o.n_meas;
+    return ret;
+  }
+
+  void write(
+    Matrix_<float, 6, 6>& JTwJ_out,
+    Matrix_<float, 6, 1>& JTwr_out) const
+  {
+    for(unsigned int i=0; i<6; i++)
+    {
+      for(unsigned int j=i; j<6; j++)
+      {
+        JTwJ_out(i,j) = JTwJ(i,j);
+        JTwJ_out(j,i) = JTwJ(i,j);
+      }
+    }
+    JTwr_out = JTwr;
+  }
+};
+
+/**
+ * @brief Reduces all valid correspondences with acc_f(sys, Di, i)
+ */
+template<typename AccF>
+LinearSystem6 reduce_linear_system(
+    const Transform& pre_transform,
+    const PointCloudView_<RAM>& dataset,
+    const PointCloudView_<RAM>& model,
+    const UmeyamaReductionConstraints params,
+    const AccF& acc_f)
+{
+  return tbb::parallel_reduce(
+    tbb::blocked_range<size_t>(0, dataset.points.size(), RMAGINE_OPTIMIZATION_BLOCK_SIZE),
+    LinearSystem6::Zero(),
+    [&](const tbb::blocked_range<size_t>& r, LinearSystem6 sys)
+    {
+      for(size_t i = r.begin(); i != r.end(); ++i)
+      {
+        if(    (dataset.mask.empty() || dataset.mask[i] > 0)
+            && (model.mask.empty()   || model.mask[i]   > 0)
+            && (dataset.ids.empty()  || dataset.ids[i] == params.dataset_id)
+            && (model.ids.empty()    || model.ids[i]   == params.model_id)
+            )
+        {
+          acc_f(sys, pre_transform * dataset.points[i], i);
+        }
+      }
+      return sys;
+    },
+    std::plus<LinearSystem6>()
+  );
+}
+
+unsigned int build_linear_system_p2p(
+    const Transform& pre_transform,
+    const PointCloudView_<RAM>& dataset,
+    const PointCloudView_<RAM>& model,
+    const UmeyamaReductionConstraints params,
+    const RobustKernel kernel,
+    Matrix_<float, 6, 6>& JTwJ,
+    Matrix_<float, 6, 1>& JTwr)
+{
+  const LinearSystem6 sys = reduce_linear_system(pre_transform, dataset, model, params, 
+    [&](LinearSystem6& sys, const Vector& Di, const size_t i)
+  {
+    Matrix_<float, 3, 6> J;
+    Matrix_<float, 3, 1> r;
+    jacobian_and_residual_p2p(J, r, model.points[i], Di);
+
+    const float residual2 = sqr(r(0,0)) + sqr(r(1,0)) + sqr(r(2,0));
+    if(residual2 < sqr(params.max_dist))
+    {
+      const float w = kernel.weight(residual2);
+      for(unsigned int k=0; k<3; k++)
+      {
+        const float Jk[6] = {J(k,0), J(k,1), J(k,2), J(k,3), J(k,4), J(k,5)};
+        sys.add(Jk, w, r(k,0));
+      }
+      sys.n_meas++;
+    }
+  });
+
+  sys.write(JTwJ, JTwr);
+  return sys.n_meas;
+}
+
+unsigned int build_linear_system_p2l(
+    const Transform& pre_transform,
+    const PointCloudView_<RAM>& dataset,
+    const PointCloudView_<RAM>& model,
+    const UmeyamaReductionConstraints params,
+    const RobustKernel kernel,
+    Matrix_<float, 6, 6>& JTwJ,
+    Matrix_<float, 6, 1>& JTwr)
+{
+  const LinearSystem6 sys = reduce_linear_system(pre_transform, dataset, model, params, 
+    [&](LinearSystem6& sys, const Vector& Di, const size_t i)
+  {
+    Matrix_<float, 1, 6> J;
+    float r;
+    jacobian_and_residual_p2l(J, r, model.points[i], model.normals[i], Di);
+
+    if(fabs(r) < params.max_dist)
+    {
+      const float Jk[6] = {J(0,0), J(0,1), J(0,2), J(0,3), J(0,4), J(0,5)};
+      sys.add(Jk, kernel.weight(sqr(r)), r);
+      sys.n_meas++;
+    }
+  });
+
+  sys.write(JTwJ, JTwr);
+  return sys.n_meas;
+}
+
+Transform gauss_newton_step(
+    const Matrix_<float, 6, 6>& JTwJ,
+    const Matrix_<float, 6, 1>& JTwr)
+{
+  Matrix_<float, 6, 6> L;
+  chol(JTwJ, L);
+
+  // pivots below this threshold belong to unconstrained directions
+  float max_diag = 0.0;
+  for(unsigned int i=0; i<6; i++)
+  {
+    max_diag = std::max(max_diag, JTwJ(i,i));
+  }
+  const float eps = sqrtf(max_diag) * 1e-3f;
+
+  // L * y = -JTwr
+  float y[6];
+  for(int i=0; i<6; i++)
+  {
+    float s = -JTwr(i,0);
+    for(int k=0; k<i; k++)
+    {
+      s -= L(i,k) * y[k];
+    }
+    y[i] = (L(i,i) > eps) ? s / L(i,i) : 0.0f;
+  }
+
+  // L^T * x = y
+  float x[6];
+  for(int i=5; i>=0; i--)
+  {
+    float s = y[i];
+    for(int k=i+1; k<6; k++)
+    {
+      s -= L(k,i) * x[k];
+    }
+    x[i] = (L(i,i) > eps) ? s / L(i,i) : 0.0f;
+  }
+
+  const Vector3 w = {x[0], x[1], x[2]};
+  const Vector3 v = {x[3], x[4], x[5]};
+  
+  Transform ret = se3_exp(v, w);
+  if(!check(ret.R) || !std::isfinite(ret.t.x) || !std::isfinite(ret.t.y) || !std::isfinite(ret.t.z))
+  {
+    ret.setIdentity();
+  }
+  return ret;
+}
+
+Transform gauss_newton_p2l(
+    const Transform& Tinit,
+    const PointCloudView_<RAM>& dataset,
+    const PointCloudView_<RAM>& model,
+    const UmeyamaReductionConstraints params,
+    const RobustKernel kernel,
+    const unsigned int n_iterations)
+{
+  Transform T = Tinit;
+
+  for(unsigned int i=0; i<n_iterations; i++)
+  {
+    Matrix_<float, 6, 6> JTwJ;
+    Matrix_<float, 6, 1> JTwr;
+    const unsigned int n_meas = build_linear_system_p2l(T, dataset, model, params, kernel, JTwJ, JTwr);
+    if(n_meas < 6)
+    {
+      break;
+    }
+
+    const Transform dT = gauss_newton_step(JTwJ, JTwr);
+    T = dT * T;
+
+    // converged
+    if(dT.t.l2norm() < 1e-6 && Vector3{dT.R.x, dT.R.y, dT.R.z}.l2norm() < 1e-6)
+    {
+      break;
+    }
+  }
+
+  return T;
+}
+
+} // namespace rmagine
@@ -0,0 +1,897 @@
+#include "rmagine/math/simd.h"
+
+#include <atomic>
+#include <cstdint>
+#include <cstring>
+#include <cmath>
+#include <type_traits>
+
+#if defined(__x86_64__) || defined(__i386__)
+#define RMAGINE_SIMD_X86
+#include <immintrin.h>
+#endif // x86
+
+namespace rmagine
+{
+
+namespace
+{
+
+SimdLevel detect_simd_level()
+{
+#ifdef RMAGINE_SIMD_X86
+    __builtin_cpu_init();
+    if(__builtin_cpu_supports("avx512f"))
+    {
+        return SimdLevel::AVX512;
+    }
+    if(__builtin_cpu_supports("avx2") && __builtin_cpu_supports("fma"))
+    {
+        return SimdLevel::AVX2;
+    }
+    if(__builtin_cpu_supports("sse4.1"))
+    {
+        return SimdLevel::SSE4;
+    }
+#endif // RMAGINE_SIMD_X86
+    return SimdLevel::SCALAR;
+}
+
+std::atomic<SimdLevel>& current_level()
+{
+    static std::atomic<SimdLevel> level{simd_level_supported()};
+    return level;
+}
+
+void transform_points_scalar(
+    const Matrix3x3& R,
+    const Vector& t,
+    const Vector* in,
+    Vector* out,
+    size_t begin,
+    size_t end)
+{
+    for(size_t i=begin; i<end; i++)
+    {
+        const Vector p = in[i];
+        out[i].x = R(0,0) * p.x + R(0,1) * p.y + R(0,2) * p.z + t.x;
+        out[i].y = R(1,0) * p.x + R(1,1) * p.y + R(1,2) * p.z + t.y;
+        out[i].z = R(2,0) * p.x + R(2,1) * p.y + R(2,2) * p.z + t.z;
+    }
+}
+
+
+///////
+// #svd3
+// Closed-form 3x3 SVD after McAdams et al., "Computing the Singular Value 
+// Decomposition of 3x3 matrices with minimal branching and elementary 
+// floating point operations" (2011): 
+// 1. Jacobi eigenanalysis of A^T A with a fixed number of sweeps. 
+//    The rotations are accumulated in a quaternion -> V
+// 2. B = A V, columns sorted by decreasing norm
+// 3. QR decomposition of B with Givens rotations -> U, diagonal of R
+// 
+// The kernel is written once for a lane type V (float or a GCC vector of 
+// 4, 8, 16 floats) with masks VI. Selects instead of branches, so every lane 
+// runs the same instructions. It is force-inlined into the ISA specific 
+// functions below, which decide the instruction set. 
+// Vectors are only passed by reference: no ABI dependency on the ISA.
+
+#define RMAGINE_SVD3_INLINE __attribute__((always_inline)) inline
+
+constexpr unsigned int SVD3_JACOBI_SWEEPS = 6;
+constexpr float SVD3_GAMMA = 5.828427124746190f; // 3 + 2 sqrt(2)
+constexpr float SVD3_CSTAR = 0.923879532511287f; // cos(pi/8)
+constexpr float SVD3_SSTAR = 0.382683432365090f; // sin(pi/8)
+constexpr float SVD3_EPS = 1e-6f;
+// below float precision of the scaled S = A^T A (entries <= 3)
+constexpr float SVD3_TINY = 1e-30f;
+constexpr float SVD3_CONVERGED = 1e-18f;
+
+typedef float v4sf __attribute__((vector_size(16)));
+typedef int32_t v4si __attribute__((vector_size(16)));
+typedef float v8sf __attribute__((vector_size(32)));
+typedef int32_t v8si __attribute__((vector_size(32)));
+typedef float v16sf __attribute__((vector_size(64)));
+typedef int32_t v16si __attribute__((vector_size(64)));
+
+/**
+ * @brief y = 1 / sqrt(x). Bit trick and three Newton steps, ~1 ulp. 
+ * Finite for x = 0
+ */
+template<typename V, typename VI>
+RMAGINE_SVD3_INLINE void svd3_rsqrt(const V& x, V& y)
+{
+    VI i;
+    memcpy(&i, &x, sizeof(V));
+    i = 0x5F375A86 - (i >> 1);
+    memcpy(&y, &i, sizeof(V));
+    const V half_x = x * 0.5f;
+    y = y * (1.5f - half_x * y * y);
+    y = y * (1.5f - half_x * y * y);
+    y = y * (1.5f - half_x * y * y);
+}
+
+/**
+ * @brief Scalar lanes: hardware square root, shorter dependency chain 
+ * than the Newton steps. Finite for x = 0
+ */
+template<>
+RMAGINE_SVD3_INLINE void svd3_rsqrt<float, int32_t>(const float& x, float& y)
+{
+    y = 1.0f / sqrtf(x > SVD3_TINY ? x : SVD3_TINY);
+}
+
+/**
+ * @brief q = q * (ch, sh * e_k)
+ */
+template<typename V>
+RMAGINE_SVD3_INLINE void svd3_quat_rotate(V q[4], const unsigned int k, const V& ch, const V& sh)
+{
+    const unsigned int i = 1 + (k + 1) % 3;
+    const unsigned int j = 1 + (k + 2) % 3;
+    const V w = q[0];
+    const V qk = q[1 + k];
+    const V qi = q[i];
+    const V qj = q[j];
+    q[0] = w * ch - qk * sh;
+    q[1 + k] = w * sh + qk * ch;
+    q[i] = qi * ch + qj * sh;
+    q[j] = qj * ch - qi * sh;
+}
+
+/**
+ * @brief One Jacobi step on the symmetric S: S = Q^T S Q, 
+ * with Q a rotation about axis k in the (p,q) plane. (p, q, k) is cyclic
+ */
+template<typename V, typename VI>
+RMAGINE_SVD3_INLINE void svd3_jacobi_conjugate(
+    V S[3][3], V q[4],
+    const unsigned int p, const unsigned int r, const unsigned int k)
+{
+    const V a = S[p][p];
+    const V d = S[r][r];
+    const V b = S[p][r];
+
+    if constexpr(std::is_same<V, float>::value)
+    {
+        // scalar lane: skip converged rotations. Their products would 
+        // be denormals, which are slow without FTZ/DAZ
+        if(fabsf(b) < SVD3_CONVERGED)
+        {
+            return;
+        }
+    }
+
+    // approximate Givens quaternion. Fixed angle of pi/4 if the approximation is poor
+    V ch = (a - d) * 2.0f;
+    V sh = b;
+    const VI use_approx = (sh * sh * SVD3_GAMMA) < (ch * ch);
+    V w;
+    svd3_rsqrt<V, VI>(ch * ch + sh * sh, w);
+    const V cstar = V{} + SVD3_CSTAR;
+    const V sstar = V{} + SVD3_SSTAR;
+    ch = use_approx ? w * ch : cstar;
+    sh = use_approx ? w * sh : sstar;
+
+    const V c = ch * ch - sh * sh;
+    const V s = ch * sh * 2.0f;
+    const V cc = c * c;
+    const V ss = s * s;
+    const V cs = c * s;
+
+    S[p][p] = cc * a + cs * b * 2.0f + ss * d;
+    S[r][r] = ss * a - cs * b * 2.0f + cc * d;
+    S[p][r] = (cc - ss) * b - cs * (a - d);
+    S[r][p] = S[p][r];
+
+    const V spk = S[p][k];
+    const V srk = S[r][k];
+    S[p][k] = c * spk + s * srk;
+    S[r][k] = c * srk - s * spk;
+    S[k][p] = S[p][k];
+    S[k][r] = S[r][k];
+
+    svd3_quat_rotate(q, k, ch, sh);
+}
+
+/**
+ * @brief Rotation matrix of a normalized quaternion (w, x, y, z)
+ */
+template<typename V>
+RMAGINE_SVD3_INLINE void svd3_quat_to_matrix(const V q[4], V M[3][3])
+{
+    const V w = q[0], x = q[1], y = q[2], z = q[3];
+    M[0][0] = 1.0f - (y * y + z * z) * 2.0f;
+    M[0][1] = (x * y - w * z) * 2.0f;
+    M[0][2] = (x * z + w * y) * 2.0f;
+    M[1][0] = (x * y + w * z) * 2.0f;
+    M[1][1] = 1.0f - (x * x + z * z) * 2.0f;
+    M[1][2] = (y * z - w * x) * 2.0f;
+    M[2][0] = (x * z - w * y) * 2.0f;
+    M[2][1] = (y * z + w * x) * 2.0f;
+    M[2][2] = 1.0f - (x * x + y * y) * 2.0f;
+}
+
+template<typename V, typename VI>
+RMAGINE_SVD3_INLINE void svd3_quat_normalize(V q[4])
+{
+    V n;
+    svd3_rsqrt<V, VI>(q[0] * q[0] + q[1] * q[1] + q[2] * q[2] + q[3] * q[3], n);
+    for(unsigned int i=0; i<4; i++)
+    {
+        q[i] = q[i] * n;
+    }
+}
+
+/**
+ * @brief Swap the columns i and j of B and V if column i of B is shorter. 
+ * One column is negated, so V stays a rotation
+ */
+template<typename V, typename VI>
+RMAGINE_SVD3_INLINE void svd3_cond_swap(
+    V B[3][3], V Vm[3][3], V rho[3],
+    const unsigned int i, const unsigned int j)
+{
+    const VI swap = rho[i] < rho[j];
+    for(unsigned int r=0; r<3; r++)
+    {
+        const V bi = B[r][i];
+        const V bj = B[r][j];
+        B[r][i] = swap ? bj : bi;
+        B[r][j] = swap ? -bi : bj;
+
+        const V vi = Vm[r][i];
+        const V vj = Vm[r][j];
+        Vm[r][i] = swap ? vj : vi;
+        Vm[r][j] = swap ? -vi : vj;
+    }
+    const V ri = rho[i];
+    rho[i] = swap ? rho[j] : ri;
+    rho[j] = swap ? ri : rho[j];
+}
+
+/**
+ * @brief Givens rotation on the rows p and r of B that zeroes B[r][p]. 
+ * Accumulated in u. axis_sign: +1 if (p, r, k) is cyclic
+ */
+template<typename V, typename VI>
+RMAGINE_SVD3_INLINE void svd3_qr_givens(
+    V B[3][3], V u[4],
+    const unsigned int p, const unsigned int r, const unsigned int k,
+    const float axis_sign)
+{
+    const V zero = V{};
+    const V eps = zero + SVD3_EPS;
+    const V a1 = B[p][p];
+    const V a2 = B[r][p];
+
+    const V rho2 = a1 * a1 + a2 * a2;
+    V rho_inv;
+    svd3_rsqrt<V, VI>(rho2, rho_inv);
+    const V rho = rho2 * rho_inv;
+
+    V sh = (rho > eps) ? a2 : zero;
+    const V abs_a1 = (a1 < zero) ? -a1 : a1;
+    V ch = abs_a1 + ((rho > eps) ? rho : eps);
+    const VI neg = a1 < zero;
+    const V ch_ = ch;
+    ch = neg ? sh : ch;
+    sh = neg ? ch_ : sh;
+
+    V w;
+    svd3_rsqrt<V, VI>(ch * ch + sh * sh, w);
+    ch = ch * w;
+    sh = sh * w;
+
+    const V c = ch * ch - sh * sh;
+    const V s = ch * sh * 2.0f;
+    for(unsigned int col=0; col<3; col++)
+    {
+        const V bp = B[p][col];
+        const V br = B[r][col];
+        B[p][col] = c * bp + s * br;
+        B[r][col] = c * br - s * bp;
+    }
+
+    svd3_quat_rotate(u, k, ch, sh * axis_sign);
+}
+
+/**
+ * @brief A = U * diag(s) * V^T for one lane pack. Row-major 3x3 arrays
+ */
+template<typename V, typename VI>
+RMAGINE_SVD3_INLINE void svd3_lanes(
+    const V A_in[3][3], V U[3][3], V s[3], V Vm[3][3])
+{
+    const V zero = V{};
+
+    // scale to max |a_ij| = 1: keeps the absolute epsilons meaningful
+    V scale = zero;
+    for(unsigned int i=0; i<3; i++)
+    {
+        for(unsigned int j=0; j<3; j++)
+        {
+            const V a = (A_in[i][j] < zero) ? -A_in[i][j] : A_in[i][j];
+            scale = (a > scale) ? a : scale;
+        }
+    }
+    const VI nonzero = scale > zero;
+    const V scale_inv = nonzero ? (1.0f / (nonzero ? scale : zero + 1.0f)) : zero + 1.0f;
+
+    V A[3][3];
+    for(unsigned int i=0; i<3; i++)
+    {
+        for(unsigned int j=0; j<3; j++)
+        {
+            A[i][j] = A_in[i][j] * scale_inv;
+        }
+    }
+
+    // 1. S = A^T A
+    V S[3][3];
+    for(unsigned int i=0; i<3; i++)
+    {
+        for(unsigned int j=i; j<3; j++)
+        {
+            S[i][j] = A[0][i] * A[0][j] + A[1][i] * A[1][j] + A[2][i] * A[2][j];
+            S[j][i] = S[i][j];
+        }
+    }
+
+    V q[4] = {zero + 1.0f, zero, zero, zero};
+    for(unsigned int sweep=0; sweep<SVD3_JACOBI_SWEEPS; sweep++)
+    {
+        svd3_jacobi_conjugate<V, VI>(S, q, 0, 1, 2);
+        svd3_jacobi_conjugate<V, VI>(S, q, 1, 2, 0);
+        svd3_jacobi_conjugate<V, VI>(S, q, 2, 0, 1);
+    }
+    svd3_quat_normalize<V, VI>(q);
+    svd3_quat_to_matrix(q, Vm);
+
+    // 2. B = A V, sorted
+    V B[3][3];
+    for(unsigned int i=0; i<3; i++)
+    {
+        for(unsigned int j=0; j<3; j++)
+        {
+            B[i][j] = A[i][0] * Vm[0][j] + A[i][1] * Vm[1][j] + A[i][2] * Vm[2][j];
+        }
+    }
+
+    V rho[3];
+    for(unsigned int j=0; j<3; j++)
+    {
+        rho[j] = B[0][j] * B[0][j] + B[1][j] * B[1][j] + B[2][j] * B[2][j];
+    }
+    svd3_cond_swap<V, VI>(B, Vm, rho, 0, 1);
+    svd3_cond_swap<V, VI>(B, Vm, rho, 0, 2);
+    svd3_cond_swap<V, VI>(B, Vm, rho, 1, 2);
+
+    // 3. B = U R
+    V u[4] = {zero + 1.0f, zero, zero, zero};
+    svd3_qr_givens<V, VI>(B, u, 0, 1, 2, 1.0f);
+    svd3_qr_givens<V, VI>(B, u, 0, 2, 1, -1.0f);
+    svd3_qr_givens<V, VI>(B, u, 1, 2, 0, 1.0f);
+    svd3_quat_normalize<V, VI>(u);
+    svd3_quat_to_matrix(u, U);
+
+    s[0] = B[0][0];
+    s[1] = B[1][1];
+    s[2] = B[2][2];
+
+    // s[0], s[1] >= 0. Negating two columns of U keeps it a rotation
+    for(unsigned int i=0; i<2; i++)
+    {
+        const VI neg = s[i] < zero;
+        s[i] = neg ? -s[i] : s[i];
+        s[2] = neg ? -s[2] : s[2];
+        for(unsigned int r=0; r<3; r++)
+        {
+            U[r][i] = neg ? -U[r][i] : U[r][i];
+            U[r][2] = neg ? -U[r][2] : U[r][2];
+        }
+    }
+
+    for(unsigned int i=0; i<3; i++)
+    {
+        s[i] = s[i] * (nonzero ? scale : zero);
+    }
+}
+
+/**
+ * @brief svd3_lanes for a single matrix
+ */
+RMAGINE_SVD3_INLINE void svd3_one(
+    const Matrix3x3& A,
+    Matrix3x3& U,
+    Vector3& s,
+    Matrix3x3& V)
+{
+    float a[3][3], u[3][3], w[3], v[3][3];
+    for(unsigned int i=0; i<3; i++)
+    {
+        for(unsigned int j=0; j<3; j++)
+        {
+            a[i][j] = A(i, j);
+        }
+    }
+
+    svd3_lanes<float, int32_t>(a, u, w, v);
+
+    for(unsigned int i=0; i<3; i++)
+    {
+        for(unsigned int j=0; j<3; j++)
+        {
+            U(i, j) = u[i][j];
+            V(i, j) = v[i][j];
+        }
+    }
+    s.x = w[0];
+    s.y = w[1];
+    s.z = w[2];
+}
+
+/**
+ * @brief Runs svd3_lanes on packs of L matrices, the rest one by one
+ */
+template<typename V, typename VI, size_t L>
+RMAGINE_SVD3_INLINE void svd3_packed(
+    const Matrix3x3* A,
+    Matrix3x3* U,
+    Vector3* s,
+    Matrix3x3* V_out,
+    size_t N)
+{
+    size_t b = 0;
+    for(; b + L <= N; b += L)
+    {
+        // transposed to lanes in plain floats: 
+        // writing single lanes of V triggers false maybe-uninitialized warnings
+        float a_lanes[3][3][L];
+        for(size_t l=0; l<L; l++)
+        {
+            for(unsigned int i=0; i<3; i++)
+            {
+                for(unsigned int j=0; j<3; j++)
+                {
+                    a_lanes[i][j][l] = A[b + l](i, j);
+                }
+            }
+        }
+
+        V a[3][3], u[3][3], w[3], v[3][3];
+        memcpy(a, a_lanes, sizeof(a));
+
+        svd3_lanes<V, VI>(a, u, w, v);
+
+        for(size_t l=0; l<L; l++)
+        {
+            for(unsigned int i=0; i<3; i++)
+            {
+                for(unsigned int j=0; j<3; j++)
+                {
+                    U[b + l](i, j) = u[i][j][l];
+                    V_out[b + l](i, j) = v[i][j][l];
+                }
+            }
+            s[b + l].x = w[0][l];
+            s[b + l].y = w[1][l];
+            s[b + l].z = w[2][l];
+        }
+    }
+
+    for(; b < N; b++)
+    {
+        svd3_one(A[b], U[b], s[b], V_out[b]);
+    }
+}
+
+void svd3_scalar(
+    const Matrix3x3* A,
+    Matrix3x3* U,
+    Vector3* s,
+    Matrix3x3* V,
+    size_t N)
+{
+    for(size_t i=0; i<N; i++)
+    {
+        svd3_one(A[i], U[i], s[i], V[i]);
+    }
+}
+
+#ifdef RMAGINE_SIMD_X86
+
+/**
+ * Vector transform on interleaved xyz data without shuffles:
+ * 
+ * A block of L vectors is 3 registers of L floats. A lane holding 
+ * component c of a vector finds the x, y and z of the same vector at 
+ * the offsets -c, -c+1, -c+2. The kernels load the block at the 
+ * offsets -2 .. +2 and select per lane (blend, not multiply by zero: 
+ * the neighbors can be NaN). Rotation row and translation are per lane 
+ * constants. 
+ * 
+ * Every register reads at most 2 floats before and after itself. Only 
+ * floats of the register's own vectors are selected, but the reads have to 
+ * stay in bounds: the first vector and the tail are done in scalar code. 
+ * A block is loaded completely before it is stored, so in and out may alias.
+ */
+template<size_t L>
+struct LaneConstants
+{
+    float r0[L];
+    float r1[L];
+    float r2[L];
+    float t[L];
+    int32_t m1[L]; // lane holds y
+    int32_t m2[L]; // lane holds z
+};
+
+template<size_t L>
+void make_lane_constants(
+    const Matrix3x3& R,
+    const Vector& t,
+    size_t offset,
+    LaneConstants<L>& c)
+{
+    const float tc[3] = {t.x, t.y, t.z};
+    for(size_t l=0; l<L; l++)
+    {
+        const size_t comp = (offset + l) % 3;
+        c.r0[l] = R(comp, 0);
+        c.r1[l] = R(comp, 1);
+        c.r2[l] = R(comp, 2);
+        c.t[l] = tc[comp];
+        c.m1[l] = (comp == 1) ? -1 : 0;
+        c.m2[l] = (comp == 2) ? -1 : 0;
+    }
+}
+
+__attribute__((target("sse4.1")))
+void transform_points_sse4(
+    const Matrix3x3& R,
+    const Vector& t,
+    const Vector* in,
+    Vector* out,
+    size_t N)
+{
+    constexpr size_t L = 4;
+    if(N < L + 2)
+    {
+        transform_points_scalar(R, t, in, out, 0, N);
+        return;
+    }
+
+    __m128 r0[3], r1[3], r2[3], tt[3], m1[3], m2[3];
+    for(size_t r=0; r<3; r++)
+    {
+        LaneConstants<L> c;
+        make_lane_constants(R, t, r * L, c);
+        r0[r] = _mm_loadu_ps(c.r0);
+        r1[r] = _mm_loadu_ps(c.r1);
+        r2[r] = _mm_loadu_ps(c.r2);
+        tt[r] = _mm_loadu_ps(c.t);
+        m1[r] = _mm_castsi128_ps(_mm_loadu_si128(reinterpret_cast<const __m128i*>(c.m1)));
+        m2[r] = _mm_castsi128_ps(_mm_loadu_si128(reinterpret_cast<const __m128i*>(c.m2)));
+    }
+
+    transform_points_scalar(R, t, in, out, 0, 1);
+
+    const size_t Nblocks = (N - 2) / L;
+    const float* src = reinterpret_cast<const float*>(in + 1);
+    float* dst = reinterpret_cast<float*>(out + 1);
+
+    for(size_t b=0; b<Nblocks; b++)
+    {
+        __m128 res[3];
+        for(size_t r=0; r<3; r++)
+        {
+            const float* p = src + (b * 3 + r) * L;
+            const __m128 lm2 = _mm_loadu_ps(p - 2);
+            const __m128 lm1 = _mm_loadu_ps(p - 1);
+            const __m128 l0  = _mm_loadu_ps(p);
+            const __m128 l1  = _mm_loadu_ps(p + 1);
+            const __m128 l2  = _mm_loadu_ps(p + 2);
+
+            const __m128 X = _mm_blendv_ps(_mm_blendv_ps(l0, lm1, m1[r]), lm2, m2[r]);
+            const __m128 Y = _mm_blendv_ps(_mm_blendv_ps(l1, l0, m1[r]), lm1, m2[r]);
+            const __m128 Z = _mm_blendv_ps(_mm_blendv_ps(l2, l1, m1[r]), l0, m2[r]);
+
+            res[r] = _mm_add_ps(
+                _mm_add_ps(_mm_mul_ps(r0[r], X), _mm_mul_ps(r1[r], Y)),
+                _mm_add_ps(_mm_mul_ps(r2[r], Z), tt[r]));
+        }
+
+        for(size_t r=0; r<3; r++)
+        {
+            _mm_storeu_ps(dst + (b * 3 + r) * L, res[r]);
+        }
+    }
+
+    transform_points_scalar(R, t, in, out, 1 + Nblocks * L, N);
+}
+
+__attribute__((target("avx2,fma")))
+void transform_points_avx2(
+    const Matrix3x3& R,
+    const Vector& t,
+    const Vector* in,
+    Vector* out,
+    size_t N)
+{
+    constexpr size_t L = 8;
+    if(N < L + 2)
+    {
+        transform_points_scalar(R, t, in, out, 0, N);
+        return;
+    }
+
+    __m256 r0[3], r1[3], r2[3], tt[3], m1[3], m2[3];
+    for(size_t r=0; r<3; r++)
+    {
+        LaneConstants<L> c;
+        make_lane_constants(R, t, r * L, c);
+        r0[r] = _mm256_loadu_ps(c.r0);
+        r1[r] = _mm256_loadu_ps(c.r1);
+        r2[r] = _mm256_loadu_ps(c.r2);
+        tt[r] = _mm256_loadu_ps(c.t);
+        m1[r] = _mm256_castsi256_ps(_mm256_loadu_si256(reinterpret_cast<const __m256i*>(c.m1)));
+        m2[r] = _mm256_castsi256_ps(_mm256_loadu_si256(reinterpret_cast<const __m256i*>(c.m2)));
+    }
+
+    transform_points_scalar(R, t, in, out, 0, 1);
+
+    const size_t Nblocks = (N - 2) / L;
+    const float* src = reinterpret_cast<const float*>(in + 1);
+    float* dst = reinterpret_cast<float*>(out + 1);
+
+    for(size_t b=0; b<Nblocks; b++)
+    {
+        __m256 res[3];
+        for(size_t r=0; r<3; r++)
+        {
+            const float* p = src + (b * 3 + r) * L;
+            const __m256 lm2 = _mm256_loadu_ps(p - 2);
+            const __m256 lm1 = _mm256_loadu_ps(p - 1);
+            const __m256 l0  = _mm256_loadu_ps(p);
+            const __m256 l1  = _mm256_loadu_ps(p + 1);
+            const __m256 l2  = _mm256_loadu_ps(p + 2);
+
+            const __m256 X = _mm256_blendv_ps(_mm256_blendv_ps(l0, lm1, m1[r]), lm2, m2[r]);
+            const __m256 Y = _mm256_blendv_ps(_mm256_blendv_ps(l1, l0, m1[r]), lm1, m2[r]);
+            const __m256 Z = _mm256_blendv_ps(_mm256_blendv_ps(l2, l1, m1[r]), l0, m2[r]);
+
+            res[r] = _mm256_fmadd_ps(r0[r], X, 
+                     _mm256_fmadd_ps(r1[r], Y, 
+                     _mm256_fmadd_ps(r2[r], Z, tt[r])));
+        }
+
+        for(size_t r=0; r<3; r++)
+        {
+            _mm256_storeu_ps(dst + (b * 3 + r) * L, res[r]);
+        }
+    }
+
+    transform_points_scalar(R, t, in, out, 1 + Nblocks * L, N);
+}
+
+__attribute__((target("avx512f")))
+void transform_points_avx512(
+    const Matrix3x3& R,
+    const Vector& t,
+    const Vector* in,
+    Vector* out,
+    size_t N)
+{
+    constexpr size_t L = 16;
+    if(N < L + 2)
+    {
+        transform_points_scalar(R, t, in, out, 0, N);
+        return;
+    }
+
+    __m512 r0[3], r1[3], r2[3], tt[3];
+    __mmask16 m1[3], m2[3];
+    for(size_t r=0; r<3; r++)
+    {
+        LaneConstants<L> c;
+        make_lane_constants(R, t, r * L, c);
+        r0[r] = _mm512_loadu_ps(c.r0);
+        r1[r] = _mm512_loadu_ps(c.r1);
+        r2[r] = _mm512_loadu_ps(c.r2);
+        tt[r] = _mm512_loadu_ps(c.t);
+        m1[r] = 0;
+        m2[r] = 0;
+        for(size_t l=0; l<L; l++)
+        {
+            m1[r] |= (c.m1[l] ? (1u << l) : 0u);
+            m2[r] |= (c.m2[l] ? (1u << l) : 0u);
+        }
+    }
+
+    transform_points_scalar(R, t, in, out, 0, 1);
+
+    const size_t Nblocks = (N - 2) / L;
+    const float* src = reinterpret_cast<const float*>(in + 1);
+    float* dst = reinterpret_cast<float*>(out + 1);
+
+    for(size_t b=0; b<Nblocks; b++)
+    {
+        __m512 res[3];
+        for(size_t r=0; r<3; r++)
+        {
+            const float* p = src + (b * 3 + r) * L;
+            const __m512 lm2 = _mm512_loadu_ps(p - 2);
+            const __m512 lm1 = _mm512_loadu_ps(p - 1);
+            const __m512 l0  = _mm512_loadu_ps(p);
+            const __m512 l1  = _mm512_loadu_ps(p + 1);
+            const __m512 l2  = _mm512_loadu_ps(p + 2);
+
+            // _mm512_mask_blend_ps(k, a, b): k ? b : a
+            const __m512 X = _mm512_mask_blend_ps(m2[r], _mm512_mask_blend_ps(m1[r], l0, lm1), lm2);
+            const __m512 Y = _mm512_mask_blend_ps(m2[r], _mm512_mask_blend_ps(m1[r], l1, l0), lm1);
+            const __m512 Z = _mm512_mask_blend_ps(m2[r], _mm512_mask_blend_ps(m1[r], l2, l1), l0);
+
+            res[r] = _mm512_fmadd_ps(r0[r], X, 
+                     _mm512_fmadd_ps(r1[r], Y, 
+                     _mm512_fmadd_ps(r2[r], Z, tt[r])));
+        }
+
+        for(size_t r=0; r<3; r++)
+        {
+            _mm512_storeu_ps(dst + (b * 3 + r) * L, res[r]);
+        }
+    }
+
+    transform_points_scalar(R, t, in, out, 1 + Nblocks * L, N);
+}
+
+__attribute__((target("sse4.1")))
+void svd3_sse4(
+    const Matrix3x3* A,
+    Matrix3x3* U,
+    Vector3* s,
+    Matrix3x3* V,
+    size_t N)
+{
+    svd3_packed<v4sf, v4si, 4>(A, U, s, V, N);
+}
+
+__attribute__((target("avx2,fma")))
+void svd3_avx2(
+    const Matrix3x3* A,
+    Matrix3x3* U,
+    Vector3* s,
+    Matrix3x3* V,
+    size_t N)
+{
+    svd3_packed<v8sf, v8si, 8>(A, U, s, V, N);
+}
+
+__attribute__((target("avx512f")))
+void svd3_avx512(
+    const Matrix3x3* A,
+    Matrix3x3* U,
+    Vector3* s,
+    Matrix3x3* V,
+    size_t N)
+{
+    svd3_packed<v16sf, v16si, 16>(A, U, s, V, N);
+}
+
+#endif // RMAGINE_SIMD_X86
+
+} // anonymous namespace
+
+SimdLevel simd_level_supported()
+{
+    static const SimdLevel supported = detect_simd_level();
+    return supported;
+}
+
+SimdLevel simd_level()
+{
+    return current_level().load(std::memory_order_relaxed);
+}
+
+void set_simd_level(SimdLevel level)
+{
+    if(level > simd_level_supported())
+    {
+        level = simd_level_supported();
+    }
+    current_level().store(level, std::memory_order_relaxed);
+}
+
+const char* simd_level_name(SimdLevel level)
+{
+    switch(level)
+    {
+        case SimdLevel::SSE4:   return "SSE4.1";
+        case SimdLevel::AVX2:   return "AVX2";
+        case SimdLevel::AVX512: return "AVX-512";
+        default:                return "scalar";
+    }
+}
+
+namespace simd
+{
+
+void transform_points(
+    const Matrix3x3& R,
+    const Vector& t,
+    const Vector* in,
+    Vector* out,
+    size_t N)
+{
+    static_assert(sizeof(Vector) == 3 * sizeof(float), "Vector has to be 3 packed floats");
+
+    switch(simd_level())
+    {
+#ifdef RMAGINE_SIMD_X86
+        case SimdLevel::AVX512:
+            transform_points_avx512(R, t, in, out, N);
+            break;
+        case SimdLevel::AVX2:
+            transform_points_avx2(R, t, in, out, N);
+            break;
+        case SimdLevel::SSE4:
+            transform_points_sse4(R, t, in, out, N);
+            break;
+#endif // RMAGINE_SIMD_X86
+        default:
+            transform_points_scalar(R, t, in, out, 0, N);
+            break;
+    }
+}
+
+void svd3(
+    const Matrix3x3& A,
+    Matrix3x3& U,
+    Vector3& s,
+    Matrix3x3& V)
+{
+    svd3_one(A, U, s, V);
+}
+
+void svd3(
+    const Matrix3x3* A,
+    Matrix3x3* U,
+    Vector3* s,
+    Matrix3x3* V,
+    size_t N)
+{
+#ifdef RMAGINE_SIMD_X86
+    // the off-diagonals of the converged Jacobi sweeps underflow. 
+    // Denormal arithmetic would slow down the kernel by an order of magnitude
+    const unsigned int csr = _mm_getcsr();
+    _mm_setcsr(csr | _MM_FLUSH_ZERO_ON | _MM_DENORMALS_ZERO_ON);
+#endif // RMAGINE_SIMD_X86
+
+    switch(simd_level())
+    {
+#ifdef RMAGINE_SIMD_X86
+        case SimdLevel::AVX512:
+            svd3_avx512(A, U, s, V, N);
+            break;
+        case SimdLevel::AVX2:
+            svd3_avx2(A, U, s, V, N);
+            break;
+        case SimdLevel::SSE4:
+            svd3_sse4(A, U, s, V, N);
+            break;
+#endif // RMAGINE_SIMD_X86
+        default:
+            svd3_scalar(A, U, s, V, N);
+            break;
+    }
+
+#ifdef RMAGINE_SIMD_X86
+    _mm_setcsr(csr);
+#endif // RMAGINE_SIMD_X86
+}
+
+} // namespace simd
+
+} // namespace rmagine
@@ -4,13 +4,20 @@
 #include <assert.h>
 
 #include "rmagine/math/math.h"
+#include "rmagine/math/soa.h"
 
 #include <rmagine/util/prints.h>
+#include <rmagine/util/exceptions.h>
 
 #include <numeric>
+#include <algorithm>
+#include <cmath>
+#include <limits>
 
 #include <tbb/blocked_range.h>
 #include <tbb/parallel_reduce.h>
+#include <tbb/parallel_for.h>
+#include <tbb/enumerable_thread_specific.h>
 
 
 namespace rmagine
@@ -150,65 +157,488 @@ CrossStatistics statistics_p2l(
   return ret;
 }
 
+// number of correspondences processed at once by the SoA kernels. 
+// The block buffers stay in L1
+#define RMAGINE_STATISTICS_SOA_BLOCK 256
+
+// measurements per task of the object-wise reductions
+#define RMAGINE_STATISTICS_OW_BLOCK 1024
+
+/**
+ * @brief Reduce the correspondences [begin, begin + n) to a CrossStatistics.
+ * n <= RMAGINE_STATISTICS_SOA_BLOCK
+ */
+template<bool P2L>
+static CrossStatistics statistics_soa_block(
+    const Matrix3x3& R,
+    const Vector& t,
+    const PointCloudSoAView_<RAM>& dataset,
+    const PointCloudSoAView_<RAM>& model,
+    const UmeyamaReductionConstraints& params,
+    const size_t begin,
+    const size_t n)
+{
+  alignas(64) float dx[RMAGINE_STATISTICS_SOA_BLOCK];
+  alignas(64) float dy[RMAGINE_STATISTICS_SOA_BLOCK];
+  alignas(64) float dz[RMAGINE_STATISTICS_SOA_BLOCK];
+  alignas(64) float mx[RMAGINE_STATISTICS_SOA_BLOCK];
+  alignas(64) float my[RMAGINE_STATISTICS_SOA_BLOCK];
+  alignas(64) float mz[RMAGINE_STATISTICS_SOA_BLOCK];
+  alignas(64) float w[RMAGINE_STATISTICS_SOA_BLOCK];
+
+  const float* Dx = dataset.points.x.raw() + begin;
+  const float* Dy = dataset.points.y.raw() + begin;
+  const float* Dz = dataset.points.z.raw() + begin;
+  const float* Mx = model.points.x.raw() + begin;
+  const float* My = model.points.y.raw() + begin;
+  const float* Mz = model.points.z.raw() + begin;
+
+  const float r00 = R(0,0), r01 = R(0,1), r02 = R(0,2);
+  const float r10 = R(1,0), r11 = R(1,1), r12 = R(1,2);
+  const float r20 = R(2,0), r21 = R(2,1), r22 = R(2,2);
+  const float max_dist = params.max_dist;
+
+  // 1. pre transform dataset, find model correspondence, check distance
+  for(size_t k=0; k<n; k++)
+  {
+    dx[k] = r00 * Dx[k] + r01 * Dy[k] + r02 * Dz[k] + t.x;
+    dy[k] = r10 * Dx[k] + r11 * Dy[k] + r12 * Dz[k] + t.y;
+    dz[k] = r20 * Dx[k] + r21 * Dy[k] + r22 * Dz[k] + t.z;
+  }
+
+  if constexpr(P2L)
+  {
+    const float* Nx = model.normals.x.raw() + begin;
+    const float* Ny = model.normals.y.raw() + begin;
+    const float* Nz = model.normals.z.raw() + begin;
+
+    for(size_t k=0; k<n; k++)
+    {
+      // project dataset point on plane -> model point
+      const float signed_plane_dist = (Mx[k] - dx[k]) * Nx[k] 
+                                    + (My[k] - dy[k]) * Ny[k] 
+                                    + (Mz[k] - dz[k]) * Nz[k];
+      mx[k] = dx[k] + Nx[k] * signed_plane_dist;
+      my[k] = dy[k] + Ny[k] * signed_plane_dist;
+      mz[k] = dz[k] + Nz[k] * signed_plane_dist;
+      // false for NaN (no hit)
+      w[k] = (fabsf(signed_plane_dist) < max_dist) ? 1.0f : 0.0f;
+    }
+  } else {
+    for(size_t k=0; k<n; k++)
+    {
+      mx[k] = Mx[k];
+      my[k] = My[k];
+      mz[k] = Mz[k];
+      const float ex = mx[k] - dx[k];
+      const float ey = my[k] - dy[k];
+      const float ez = mz[k] - dz[k];
+      w[k] = (sqrtf(ex * ex + ey * ey + ez * ez) < max_dist) ? 1.0f : 0.0f;
+    }
+  }
+
+  // 2. masks and ids. Separate loops: each one is branch free
+  if(!dataset.mask.empty())
+  {
+    const uint8_t* mask = dataset.mask.raw() + begin;
+    for(size_t k=0; k<n; k++)
+    {
+      w[k] = (mask[k] > 0) ? w[k] : 0.0f;
+    }
+  }
+
+  if(!model.mask.empty())
+  {
+    const uint8_t* mask = model.mask.raw() + begin;
+    for(size_t k=0; k<n; k++)
+    {
+      w[k] = (mask[k] > 0) ? w[k] : 0.0f;
+    }
+  }
+
+  if(!dataset.ids.empty())
+  {
+    const unsigned int* ids = dataset.ids.raw() + begin;
+    for(size_t k=0; k<n; k++)
+    {
+      w[k] = (ids[k] == params.dataset_id) ? w[k] : 0.0f;
+    }
+  }
+
+  if(!model.ids.empty())
+  {
+    const unsigned int* ids = model.ids.raw() + begin;
+    for(size_t k=0; k<n; k++)
+    {
+      w[k] = (ids[k] == params.model_id) ? w[k] : 0.0f;
+    }
+  }
+
+  // 3. zero rejected correspondences. They can be NaN
+  for(size_t k=0; k<n; k++)
+  {
+    const bool valid = (w[k] > 0.0f);
+    dx[k] = valid ? dx[k] : 0.0f;
+    dy[k] = valid ? dy[k] : 0.0f;
+    dz[k] = valid ? dz[k] : 0.0f;
+    mx[k] = valid ? mx[k] : 0.0f;
+    my[k] = valid ? my[k] : 0.0f;
+    mz[k] = valid ? mz[k] : 0.0f;
+  }
+
+  const float n_valid = soa_sum(w, n);
+  if(n_valid == 0.0f)
+  {
+    return CrossStatistics::Identity();
+  }
+
+  CrossStatistics ret;
+  ret.n_meas = static_cast<unsigned int>(n_valid);
+  ret.dataset_mean = Vector{soa_sum(dx, n), soa_sum(dy, n), soa_sum(dz, n)} / n_valid;
+  ret.model_mean = Vector{soa_sum(mx, n), soa_sum(my, n), soa_sum(mz, n)} / n_valid;
+
+  // 4. center. Two passes over the block keep the covariance accurate 
+  // far away from the origin
+  const Vector dm = ret.dataset_mean;
+  const Vector mm = ret.model_mean;
+  for(size_t k=0; k<n; k++)
+  {
+    dx[k] = (dx[k] - dm.x) * w[k];
+    dy[k] = (dy[k] - dm.y) * w[k];
+    dz[k] = (dz[k] - dm.z) * w[k];
+    mx[k] = (mx[k] - mm.x) * w[k];
+    my[k] = (my[k] - mm.y) * w[k];
+    mz[k] = (mz[k] - mm.z) * w[k];
+  }
+
+  // 5. covariance = sum (m - mm) * (d - dm)^T / n
+  const float* m[3] = {mx, my, mz};
+  const float* d[3] = {dx, dy, dz};
+  for(size_t i=0; i<3; i++)
+  {
+    for(size_t j=0; j<3; j++)
+    {
+      ret.covariance(i,j) = soa_dot(m[i], d[j], n) / n_valid;
+    }
+  }
+
+  return ret;
+}
+
+template<bool P2L>
+static CrossStatistics statistics_soa(
+    const Transform& pre_transform,
+    const PointCloudSoAView_<RAM>& dataset,
+    const PointCloudSoAView_<RAM>& model,
+    const UmeyamaReductionConstraints& params)
+{
+  const Matrix3x3 R = pre_transform.R;
+  const Vector t = pre_transform.t;
+
+  return tbb::parallel_reduce(
+    tbb::blocked_range<size_t>(0, dataset.points.size(), 4 * RMAGINE_STATISTICS_SOA_BLOCK),
+    CrossStatistics::Identity(),
+    [&](const tbb::blocked_range<size_t>& r, CrossStatistics acc) 
+    {
+      for(size_t b = r.begin(); b < r.end(); b += RMAGINE_STATISTICS_SOA_BLOCK)
+      {
+        const size_t n = std::min(r.end() - b, static_cast<size_t>(RMAGINE_STATISTICS_SOA_BLOCK));
+        acc += statistics_soa_block<P2L>(R, t, dataset, model, params, b, n);
+      }
+      return acc;
+    },
+    std::plus<CrossStatistics>()
+  );
+}
+
+RMAGINE_HOST_FUNCTION
+void statistics_p2p(
+    const Transform& pre_transform,
+    const PointCloudSoAView_<RAM>& dataset,
+    const PointCloudSoAView_<RAM>& model,
+    const UmeyamaReductionConstraints params,
+    MemoryView<CrossStatistics>& stats)
+{
+  stats[0] = statistics_soa<false>(pre_transform, dataset, model, params);
+}
+
+RMAGINE_HOST_FUNCTION
+void statistics_p2p(
+    const Transform& pre_transform,
+    const PointCloudSoAView_<RAM>& dataset,
+    const PointCloudSoAView_<RAM>& model,
+    const UmeyamaReductionConstraints params,
+    CrossStatistics& stats)
+{
+  stats = statistics_soa<false>(pre_transform, dataset, model, params);
+}
+
+RMAGINE_HOST_FUNCTION
+CrossStatistics statistics_p2p(
+    const Transform& pre_transform,
+    const PointCloudSoAView_<RAM>& dataset,
+    const PointCloudSoAView_<RAM>& model,
+    const UmeyamaReductionConstraints params)
+{
+  return statistics_soa<false>(pre_transform, dataset, model, params);
+}
+
+RMAGINE_HOST_FUNCTION
+void statistics_p2l(
+    const Transform& pre_transform,
+    const PointCloudSoAView_<RAM>& dataset,
+    const PointCloudSoAView_<RAM>& model,
+    const UmeyamaReductionConstraints params,
+    MemoryView<CrossStatistics>& stats)
+{
+  stats[0] = statistics_soa<true>(pre_transform, dataset, model, params);
+}
+
+RMAGINE_HOST_FUNCTION
+void statistics_p2l(
+    const Transform& pre_transform,
+    const PointCloudSoAView_<RAM>& dataset,
+    const PointCloudSoAView_<RAM>& model,
+    const UmeyamaReductionConstraints params,
+    CrossStatistics& stats)
+{
+  stats = statistics_soa<true>(pre_transform, dataset, model, params);
+}
+
+RMAGINE_HOST_FUNCTION
+CrossStatistics statistics_p2l(
+    const Transform& pre_transform,
+    const PointCloudSoAView_<RAM>& dataset,
+    const PointCloudSoAView_<RAM>& model,
+    const UmeyamaReductionConstraints params)
+{
+  return statistics_soa<true>(pre_transform, dataset, model, params);
+}
+
+/**
+ * @brief Point to plane correspondence of dataset point Di and model point Ii with normal Ni.
+ * 
+ * @return false if the plane is farther than max_dist from Di
+ */
+inline bool p2l_correspondence(
+  const Vector& Di, 
+  const Vector& Ii, 
+  const Vector& Ni,
+  const float max_dist,
+  Vector& Mi)
+{
+  const float signed_plane_dist = (Ii - Di).dot(Ni);
+  if(fabs(signed_plane_dist) < max_dist)
+  {
+    // nearest point on model
+    Mi = Di + Ni * signed_plane_dist;
+    return true;
+  }
+  return false;
+}
+
 RMAGINE_HOST_FUNCTION
 void statistics_p2l_ow(
     const PointCloudView_<RAM>& dataset,
     const PointCloudView_<RAM>& model,
-    const MemoryView<Transform>& model_pretransforms, // we would need more pre_transforms here
+    const MemoryView<Transform>& model_pretransforms,
     const UmeyamaReductionConstraints params,
     MemoryView<CrossStatistics>& stats)
 {
-  // TODO: test this function!
-  unsigned int n_measurements = dataset.points.size();
-  unsigned int n_objects = stats.size();
+  const size_t n_measurements = dataset.points.size();
+  const size_t n_objects = stats.size();
+
+  if(model.ids.empty())
+  {
+    RM_THROW(Exception, "statistics_p2l_ow: model ids required");
+  }
 
-  // initialize all partitions
-  for(size_t i=0; i<n_objects; i++)
+  if(model_pretransforms.size() < n_objects)
   {
-    stats[i] = CrossStatistics::Identity();
+    RM_THROW(Exception, "statistics_p2l_ow: one model pre-transform per object required");
   }
 
-  for(size_t i=0; i<n_measurements; i++)
+  // Every thread accumulates into its own array of partial statistics.
+  // Allocated lazily: threads that never run a chunk don't pay for it
+  tbb::enumerable_thread_specific<std::vector<CrossStatistics> > partials(
+    [n_objects]() { 
+      return std::vector<CrossStatistics>(n_objects, CrossStatistics::Identity()); 
+    });
+
+  tbb::parallel_for(
+    tbb::blocked_range<size_t>(0, n_measurements, RMAGINE_STATISTICS_OW_BLOCK), 
+    [&](const tbb::blocked_range<size_t>& r)
   {
-    if(    (dataset.mask.empty() || dataset.mask[i] > 0)
-        && (model.mask.empty()   || model.mask[i]   > 0)
-        )
+    std::vector<CrossStatistics>& local = partials.local();
+    for(size_t i = r.begin(); i != r.end(); ++i)
     {
       const unsigned int Oi = model.ids[i];
-      const Transform Tmodel = model_pretransforms[Oi];
+      if(    Oi < n_objects // no object hit, or object without statistics
+          && (dataset.mask.empty() || dataset.mask[i] > 0)
+          && (model.mask.empty()   || model.mask[i]   > 0)
+          && (dataset.ids.empty()  || dataset.ids[i] == params.dataset_id)
+          )
+      {
+        const Transform Tmodel = model_pretransforms[Oi];
+
+        const Vector Di = dataset.points[i];
+        const Vector Ii = Tmodel * model.points[i];
+        const Vector Ni = Tmodel.R * model.normals[i];
+
+        Vector Mi;
+        if(p2l_correspondence(Di, Ii, Ni, params.max_dist, Mi))
+        {
+          // Or Mi -> Di here? since our model is going to matched to our dataset - reversed to localization
+          local[Oi] += CrossStatistics::Init(Di, Mi);
+        }
+      }
+    }
+  });
 
-      // 1. read a few things we need to make a iterative
-      const Vector Di   = dataset.points[i];
-      const Vector Ii   = Tmodel * model.points[i];
-      const Vector Ni   = Tmodel.R * model.normals[i];
+  // merge the partial statistics, object-wise in parallel
+  tbb::parallel_for(tbb::blocked_range<size_t>(0, n_objects, 64), 
+    [&](const tbb::blocked_range<size_t>& r)
+  {
+    for(size_t Oi = r.begin(); Oi != r.end(); ++Oi)
+    {
+      CrossStatistics acc = CrossStatistics::Identity();
+      for(const std::vector<CrossStatistics>& local : partials)
+      {
+        acc += local[Oi];
+      }
+      stats[Oi] = acc;
+    }
+  });
+}
 
-      // 2. project new dataset point on plane -> new model point
-      const float signed_plane_dist = (Ii - Di).dot(Ni);
-      if(fabs(signed_plane_dist) < params.max_dist)
+RMAGINE_HOST_FUNCTION
+std::unordered_map<unsigned int, CrossStatistics> statistics_p2l_ow(
+    const Transform& pre_transform,
+    const PointCloudView_<RAM>& dataset,
+    const PointCloudView_<RAM>& model,
+    const UmeyamaReductionConstraints params)
+{
+  if(model.ids.empty())
+  {
+    RM_THROW(Exception, "statistics_p2l_ow: model ids required");
+  }
+
+  using StatsMap = std::unordered_map<unsigned int, CrossStatistics>;
+  
+  // sparse variant: thread local maps only contain the objects seen by that thread
+  tbb::enumerable_thread_specific<StatsMap> partials;
+
+  tbb::parallel_for(
+    tbb::blocked_range<size_t>(0, dataset.points.size(), RMAGINE_STATISTICS_OW_BLOCK), 
+    [&](const tbb::blocked_range<size_t>& r)
+  {
+    StatsMap& local = partials.local();
+    for(size_t i = r.begin(); i != r.end(); ++i)
+    {
+      const unsigned int Oi = model.ids[i];
+      if(    Oi != std::numeric_limits<unsigned int>::max() // no object hit
+          && (dataset.mask.empty() || dataset.mask[i] > 0)
+          && (model.mask.empty()   || model.mask[i]   > 0)
+          && (dataset.ids.empty()  || dataset.ids[i] == params.dataset_id)
+          )
       {
-        // nearest point on model
-        const Vector Mi = Di + Ni * signed_plane_dist;
-        // Or Mi -> Di here? since our model is going to matched to our dataset - reversed to localization
-        stats[Oi] += CrossStatistics::Init(Di, Mi);
+        const Vector Di = pre_transform * dataset.points[i];
+
+        Vector Mi;
+        if(p2l_correspondence(Di, model.points[i], model.normals[i], params.max_dist, Mi))
+        {
+          auto it = local.try_emplace(Oi, CrossStatistics::Identity()).first;
+          it->second += CrossStatistics::Init(Di, Mi);
+        }
       }
     }
+  });
+
+  StatsMap ret;
+  for(const StatsMap& local : partials)
+  {
+    for(const auto& [Oi, stats] : local)
+    {
+      auto it = ret.try_emplace(Oi, CrossStatistics::Identity()).first;
+      it->second += stats;
+    }
   }
+  return ret;
 }
 
-// RMAGINE_HOST_FUNCTION
-// std::unordered_map<unsigned int, CrossStatistics> statistics_p2l_ow(
-//     const Transform& pre_transform,
-//     const PointCloudView_<RAM>& dataset,
-//     const PointCloudView_<RAM>& model,
-//     const UmeyamaReductionConstraints params)
-// {
-//     std::unordered_map<unsigned int, CrossStatistics> ret;
+RMAGINE_HOST_FUNCTION
+void statistics_objectwise_p2l(
+    const MemoryView<Transform, RAM>& pre_transforms,
+    const PointCloudView_<RAM>& dataset,
+    const PointCloudView_<RAM>& model,
+    const unsigned int& width,
+    const unsigned int& height,
+    const MemoryView<UmeyamaReductionConstraints, RAM>& params,
+    const MemoryView<AABB, RAM>& bboxes,
+    MemoryView<CrossStatistics, RAM>& stats)
+{
+  const size_t N = dataset.points.size();
+
+  // objects in parallel, rows of large bounding boxes as well
+  tbb::parallel_for(tbb::blocked_range<size_t>(0, stats.size()), 
+    [&](const tbb::blocked_range<size_t>& ro)
+  {
+    for(size_t bid = ro.begin(); bid != ro.end(); ++bid)
+    {
+      const AABB bb = bboxes[bid];
+      const unsigned int min_col = bb.min[0];
+      const unsigned int min_row = bb.min[1];
+      const unsigned int max_col = std::min(static_cast<unsigned int>(bb.max[0]), width);
+      const unsigned int max_row = std::min(static_cast<unsigned int>(bb.max[1]), height);
+      
+      const Transform pre_transform = pre_transforms[bid];
+      const UmeyamaReductionConstraints param = params[bid];
 
-//     // TODO
-//     throw std::runtime_error("TODO");
+      if(min_row >= max_row || min_col >= max_col)
+      {
+        stats[bid] = CrossStatistics::Identity();
+        continue;
+      }
 
-//     return ret;
-// }
+      stats[bid] = tbb::parallel_reduce(
+        tbb::blocked_range<unsigned int>(min_row, max_row, 
+          std::max(1u, RMAGINE_STATISTICS_OW_BLOCK / (max_col - min_col))),
+        CrossStatistics::Identity(),
+        [&](const tbb::blocked_range<unsigned int>& rr, CrossStatistics acc) 
+        {
+          for(unsigned int row = rr.begin(); row != rr.end(); ++row)
+          {
+            for(unsigned int col = min_col; col < max_col; ++col)
+            {
+              // width is the stride from row to row
+              const size_t i = static_cast<size_t>(row) * width + col;
+              if(i >= N)
+              {
+                break;
+              }
+
+              if(    (dataset.mask.empty() || dataset.mask[i] > 0)
+                  && (model.mask.empty()   || model.mask[i]   > 0)
+                  && (dataset.ids.empty()  || dataset.ids[i] == param.dataset_id)
+                  && (model.ids.empty()    || model.ids[i]   == param.model_id)
+                  )
+              {
+                const Vector Di = pre_transform * dataset.points[i];
 
+                Vector Mi;
+                if(p2l_correspondence(Di, model.points[i], model.normals[i], param.max_dist, Mi))
+                {
+                  acc += CrossStatistics::Init(Di, Mi);
+                }
+              }
+            }
+          }
+          return acc;
+        },
+        std::plus<CrossStatistics>()
+      );
+    }
+  });
+}
 
 } // namespace rmagine 
\ No newline at end of file
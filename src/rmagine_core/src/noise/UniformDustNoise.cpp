@@ -1,10 +1,56 @@
 #include "rmagine/noise/UniformDustNoise.hpp"
+#include "rmagine/noise/philox.h"
 
-#include <random>
+#include <tbb/parallel_for.h>
+
+#include <algorithm>
+#include <limits>
+#include <cmath>
 
 namespace rmagine
 {
 
+// separates the random numbers of the noise models for equal seeds
+static constexpr uint32_t UNIFORM_DUST_NOISE_SALT = 3;
+
+/**
+ * @param log_miss_prob  log(1 - hit_prob)
+ * @param log_ret_prob   log(ret_prob)
+ */
+inline float uniform_dust_noise(
+    const float range_in,
+    const float log_miss_prob,
+    const float log_ret_prob,
+    const float max_range,
+    const uint32_t seed,
+    const uint64_t id,
+    const uint32_t stream)
+{
+    uint32_t r[4];
+    philox_random(seed, id, stream, UNIFORM_DUST_NOISE_SALT, r);
+
+    const float range = (range_in > max_range) ? max_range : range_in;
+    const float new_range = uniform_float(r[1]) * range;
+
+    // total hit probability from hit probability per meter with actual range:
+    //   u < 1 - (1 - hit_prob)^range  <=>  log(1 - u) > range * log(1 - hit_prob)
+    // the return probability is ret_prob^new_range:
+    //   u < ret_prob^new_range        <=>  log(u) < new_range * log(ret_prob)
+    // 1 - u is uniform as well, so both sides use a random number in (0, 1]
+    const bool hit = philox_logf(uniform_float(r[0])) > range * log_miss_prob;
+    const bool ret = philox_logf(uniform_float(r[2])) < new_range * log_ret_prob;
+
+    return (hit && ret) ? new_range : range_in;
+}
+
+/**
+ * @brief log(p) limited to a finite value, so that 0 * log(0) is not NaN
+ */
+inline float log_prob(const float p)
+{
+    return std::max(logf(p), -std::numeric_limits<float>::max());
+}
+
 UniformDustNoise::UniformDustNoise(
     float hit_prob, 
     float ret_prob, 
@@ -12,41 +58,33 @@ UniformDustNoise::UniformDustNoise(
 :Noise(options)
 ,m_hit_prob(hit_prob)
 ,m_ret_prob(ret_prob)
-,m_distr(0.0, 1.0)
 {
 
 }
 
 void UniformDustNoise::apply(MemoryView<float, RAM>& ranges)
 {
+    const uint32_t stream = nextStream();
+    const float log_miss_prob = log_prob(1.0f - m_hit_prob);
+    const float log_ret_prob = log_prob(m_ret_prob);
     const float max_range = m_options.max_range;
-    for(size_t i=0; i<ranges.size(); i++)
-    {
-        float range = ranges[i];
+    const uint32_t seed = m_options.seed;
+    float* data = ranges.raw();
 
-        if(range > max_range)
+    tbb::parallel_for(tbb::blocked_range<size_t>(0, ranges.size(), RMAGINE_NOISE_BLOCK_SIZE),
+        [=](const tbb::blocked_range<size_t>& r)
+    {
+        for(size_t i=r.begin(); i<r.end(); i++)
         {
-            range = max_range;
+            data[i] = uniform_dust_noise(data[i], log_miss_prob, log_ret_prob, max_range, seed, i, stream);
         }
+    }, tbb::simple_partitioner());
+}
 
-        // compute total probability
-        // from hit probability per meter with actual range
-        const float p_hit = 1.0 - powf(1.0 - m_hit_prob, range);
-        const float p_hit_rand = m_distr(gen);
-
-        if(p_hit_rand < p_hit)
-        {
-            const float new_range = m_distr(gen) * range;
-            const float p_return = powf(m_ret_prob, new_range);
-
-            const float p_return_rand = m_distr(gen);
-
-            if(p_return_rand < p_return)
-            {
-                ranges[i] = new_range;
-            }
-        }
-    }
+float UniformDustNoise::applyAt(float range, uint64_t id, uint32_t stream) const
+{
+    return uniform_dust_noise(range, log_prob(1.0f - m_hit_prob), log_prob(m_ret_prob), 
+        m_options.max_range, m_options.seed, id, stream);
 }
 
 } // namespace rmagine
\ No newline at end of file
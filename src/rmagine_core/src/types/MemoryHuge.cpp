@@ -0,0 +1,188 @@
+#include "rmagine/types/MemoryHuge.hpp"
+
+#include <algorithm>
+#include <atomic>
+#include <cstdint>
+#include <cstring>
+#include <new>
+
+#include <sys/mman.h>
+#include <unistd.h>
+
+#include <tbb/parallel_for.h>
+#include <tbb/blocked_range.h>
+#include <tbb/partitioner.h>
+
+namespace rmagine
+{
+
+namespace huge
+{
+
+namespace
+{
+
+std::atomic<bool> g_prefault{false};
+
+inline size_t mapped_size(size_t bytes)
+{
+    return (bytes + HUGE_PAGE_SIZE - 1) & ~(HUGE_PAGE_SIZE - 1);
+}
+
+inline void advise(void* ptr, size_t len)
+{
+#ifdef MADV_HUGEPAGE
+    // only a hint: fails silently if THP is disabled
+    madvise(ptr, len, MADV_HUGEPAGE);
+#endif // MADV_HUGEPAGE
+}
+
+// HUGE_PAGE_SIZE aligned anonymous mapping of len bytes
+void* map_aligned(size_t len)
+{
+    // map one page more to be able to align the start to a huge page
+    void* raw = mmap(nullptr, len + HUGE_PAGE_SIZE, PROT_READ | PROT_WRITE, 
+        MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+    if(raw == MAP_FAILED)
+    {
+        throw std::bad_alloc();
+    }
+
+    const uintptr_t raw_addr = reinterpret_cast<uintptr_t>(raw);
+    const uintptr_t addr = (raw_addr + HUGE_PAGE_SIZE - 1) & ~(HUGE_PAGE_SIZE - 1);
+    const size_t head = addr - raw_addr;
+    const size_t tail = HUGE_PAGE_SIZE - head;
+
+    if(head > 0)
+    {
+        munmap(raw, head);
+    }
+
+    if(tail > 0)
+    {
+        munmap(reinterpret_cast<void*>(addr + len), tail);
+    }
+
+    return reinterpret_cast<void*>(addr);
+}
+
+} // anonymous namespace
+
+void* allocate(size_t bytes)
+{
+    if(bytes == 0)
+    {
+        return nullptr;
+    }
+
+    const size_t len = mapped_size(bytes);
+    void* ptr = map_aligned(len);
+    advise(ptr, len);
+
+    if(g_prefault)
+    {
+        prefault(ptr, bytes);
+    }
+
+    return ptr;
+}
+
+void* reallocate(void* ptr, size_t bytes_old, size_t bytes_new)
+{
+    if(!ptr)
+    {
+        return allocate(bytes_new);
+    }
+
+    if(bytes_new == 0)
+    {
+        deallocate(ptr, bytes_old);
+        return nullptr;
+    }
+
+    const size_t len_old = mapped_size(bytes_old);
+    const size_t len_new = mapped_size(bytes_new);
+
+    if(len_old == len_new)
+    {
+        return ptr;
+    }
+
+#if defined(MREMAP_MAYMOVE) && defined(MREMAP_FIXED)
+    // shrinking, or growing into free address space behind the mapping: 
+    // the start and therefore the alignment stay the same
+    void* ret = mremap(ptr, len_old, len_new, 0);
+    if(ret == MAP_FAILED)
+    {
+        // move the page table entries into a new aligned region. 
+        // No data is copied. The region is replaced by the moved mapping
+        void* dst = map_aligned(len_new);
+        ret = mremap(ptr, len_old, len_new, MREMAP_MAYMOVE | MREMAP_FIXED, dst);
+        if(ret == MAP_FAILED)
+        {
+            munmap(dst, len_new);
+            throw std::bad_alloc();
+        }
+    }
+    advise(ret, len_new);
+#else
+    void* ret = allocate(bytes_new);
+    std::memcpy(ret, ptr, std::min(bytes_old, bytes_new));
+    deallocate(ptr, bytes_old);
+#endif // MREMAP_MAYMOVE
+
+    if(g_prefault && bytes_new > bytes_old)
+    {
+        prefault(static_cast<char*>(ret) + bytes_old, bytes_new - bytes_old);
+    }
+
+    return ret;
+}
+
+void deallocate(void* ptr, size_t bytes)
+{
+    if(!ptr)
+    {
+        return;
+    }
+
+    munmap(ptr, mapped_size(bytes));
+}
+
+void prefault(void* ptr, size_t bytes)
+{
+    if(!ptr || bytes == 0)
+    {
+        return;
+    }
+
+    static const size_t sys_page_size = sysconf(_SC_PAGESIZE);
+
+    volatile char* mem = static_cast<char*>(ptr);
+    const size_t Npages = (bytes + sys_page_size - 1) / sys_page_size;
+
+    tbb::parallel_for(tbb::blocked_range<size_t>(0, Npages), 
+        [&](const tbb::blocked_range<size_t>& r)
+    {
+        for(size_t i = r.begin(); i < r.end(); i++)
+        {
+            // write without changing the content
+            volatile char* page = mem + i * sys_page_size;
+            *page = *page;
+        }
+    }, tbb::static_partitioner());
+}
+
+void set_prefault(bool enable)
+{
+    g_prefault = enable;
+}
+
+bool prefault_enabled()
+{
+    return g_prefault;
+}
+
+} // namespace huge
+
+} // namespace rmagine
@@ -0,0 +1,217 @@
+#include "rmagine/types/MemoryPooled.hpp"
+
+#include <array>
+#include <atomic>
+#include <cstdlib>
+#include <mutex>
+#include <new>
+#include <vector>
+
+namespace rmagine
+{
+
+namespace pooled
+{
+
+namespace 
+{
+
+// 4 size classes per power of two: at most 25% of a block is unused
+static constexpr size_t SUBCLASSES_LOG2 = 2;
+static constexpr size_t MIN_BLOCK_LOG2 = 6;
+static constexpr size_t NUM_CLASSES = (64 - MIN_BLOCK_LOG2) * (1 << SUBCLASSES_LOG2) + 1;
+
+inline size_t floor_log2(size_t x)
+{
+    return 63 - __builtin_clzll(x);
+}
+
+inline size_t class_index(size_t block_size)
+{
+    if(block_size <= (1 << MIN_BLOCK_LOG2))
+    {
+        return 0;
+    }
+
+    const size_t hb = floor_log2(block_size - 1);
+    const size_t step = size_t(1) << (hb - SUBCLASSES_LOG2);
+    const size_t sub = (block_size - 1) / step - (1 << SUBCLASSES_LOG2);
+    return (hb - MIN_BLOCK_LOG2) * (1 << SUBCLASSES_LOG2) + sub + 1;
+}
+
+inline size_t class_block_size(size_t index)
+{
+    if(index == 0)
+    {
+        return 1 << MIN_BLOCK_LOG2;
+    }
+
+    const size_t hb = (index - 1) / (1 << SUBCLASSES_LOG2) + MIN_BLOCK_LOG2;
+    const size_t sub = (index - 1) % (1 << SUBCLASSES_LOG2);
+    const size_t step = size_t(1) << (hb - SUBCLASSES_LOG2);
+    return ((1 << SUBCLASSES_LOG2) + sub + 1) * step;
+}
+
+struct SizeClass
+{
+    size_t block_size;
+    std::mutex mutex;
+    std::vector<void*> free_blocks;
+};
+
+struct Pool
+{
+    std::array<SizeClass, NUM_CLASSES> classes;
+    std::atomic<size_t> cached_bytes{0};
+    std::atomic<size_t> used_bytes{0};
+    std::atomic<size_t> hits{0};
+    std::atomic<size_t> misses{0};
+    std::atomic<size_t> cache_limit{size_t(2) << 30};
+
+    Pool()
+    {
+        for(size_t i=0; i<NUM_CLASSES; i++)
+        {
+            classes[i].block_size = class_block_size(i);
+        }
+    }
+};
+
+Pool& pool()
+{
+    // never destroyed: buffers with static storage duration may 
+    // still be returned to the pool during program exit
+    static Pool* p = new Pool;
+    return *p;
+}
+
+} // anonymous namespace
+
+size_t size_class(size_t bytes)
+{
+    if(bytes == 0)
+    {
+        return 0;
+    }
+
+    if(bytes <= (1 << MIN_BLOCK_LOG2))
+    {
+        return 1 << MIN_BLOCK_LOG2;
+    }
+
+    const size_t hb = floor_log2(bytes - 1);
+    const size_t step = size_t(1) << (hb - SUBCLASSES_LOG2);
+    return ((bytes - 1) / step + 1) * step;
+}
+
+void* allocate(size_t bytes)
+{
+    if(bytes == 0)
+    {
+        return nullptr;
+    }
+
+    Pool& p = pool();
+    const size_t block_size = size_class(bytes);
+    SizeClass& sc = p.classes[class_index(block_size)];
+
+    void* ptr = nullptr;
+    {
+        std::lock_guard<std::mutex> lock(sc.mutex);
+        if(!sc.free_blocks.empty())
+        {
+            ptr = sc.free_blocks.back();
+            sc.free_blocks.pop_back();
+            p.cached_bytes -= block_size;
+        }
+    }
+
+    if(ptr)
+    {
+        p.hits++;
+    } else {
+        // aligned_alloc requires a multiple of the alignment
+        const size_t alloc_size = (block_size + ALIGNMENT - 1) & ~(ALIGNMENT - 1);
+        ptr = std::aligned_alloc(ALIGNMENT, alloc_size);
+        if(!ptr)
+        {
+            // release the cache and try once more
+            release();
+            ptr = std::aligned_alloc(ALIGNMENT, alloc_size);
+        }
+
+        if(!ptr)
+        {
+            throw std::bad_alloc();
+        }
+        p.misses++;
+    }
+
+    p.used_bytes += block_size;
+    return ptr;
+}
+
+void deallocate(void* ptr, size_t bytes)
+{
+    if(!ptr)
+    {
+        return;
+    }
+
+    Pool& p = pool();
+    const size_t block_size = size_class(bytes);
+    p.used_bytes -= block_size;
+
+    if(p.cached_bytes + block_size > p.cache_limit)
+    {
+        std::free(ptr);
+        return;
+    }
+
+    SizeClass& sc = p.classes[class_index(block_size)];
+    {
+        std::lock_guard<std::mutex> lock(sc.mutex);
+        sc.free_blocks.push_back(ptr);
+        p.cached_bytes += block_size;
+    }
+}
+
+void release()
+{
+    Pool& p = pool();
+    for(SizeClass& sc : p.classes)
+    {
+        std::vector<void*> blocks;
+        {
+            std::lock_guard<std::mutex> lock(sc.mutex);
+            blocks.swap(sc.free_blocks);
+        }
+
+        for(void* ptr : blocks)
+        {
+            std::free(ptr);
+        }
+
+        p.cached_bytes -= blocks.size() * sc.block_size;
+    }
+}
+
+void set_cache_limit(size_t bytes)
+{
+    pool().cache_limit = bytes;
+}
+
+PoolStats stats()
+{
+    Pool& p = pool();
+    PoolStats ret;
+    ret.cached_bytes = p.cached_bytes;
+    ret.used_bytes = p.used_bytes;
+    ret.hits = p.hits;
+    ret.misses = p.misses;
+    return ret;
+}
+
+} // namespace pooled
+
+} // namespace rmagine
@@ -57,6 +57,7 @@
 #include <rmagine/types/sensor_models.h>
 #include <rmagine/math/assimp_conversions.h>
 #include <rmagine/map/AssimpIO.hpp>
+#include <rmagine/map/MapFile.hpp>
 
 #include "embree/EmbreeDevice.hpp"
 #include "embree/EmbreeScene.hpp"
@@ -79,6 +80,17 @@ public:
     const Point& qp, 
     const float& max_distance = std::numeric_limits<float>::max());
 
+  /**
+   * @brief Closest points of many query points at once, computed in parallel
+   */
+  Memory<EmbreeClosestPointResult, RAM> closestPoints(
+    const MemoryView<const Point, RAM>& qps,
+    const float& max_distance = std::numeric_limits<float>::max()) const;
+
+  Memory<EmbreeClosestPointResult, RAM> closestPoints(
+    const MemoryView<Point, RAM>& qps,
+    const float& max_distance = std::numeric_limits<float>::max()) const;
+
   EmbreeDevicePtr device;
   EmbreeScenePtr scene;
 
@@ -91,10 +103,26 @@ public:
 
 using EmbreeMapPtr = std::shared_ptr<EmbreeMap>;
 
+/**
+ * @brief Load a map from a mesh file or a .rmap file
+ * 
+ * @param settings  settings of the scenes. Use settings.compact for 
+ *                  large static maps: reduces the memory of meshes and BVHs
+ */
 static EmbreeMapPtr import_embree_map(
     const std::string& meshfile,
-    EmbreeDevicePtr device = embree_default_device())
+    EmbreeDevicePtr device = embree_default_device(),
+    EmbreeSceneSettings settings = {})
 {
+    if(is_map_file(meshfile))
+    {
+        // stored after freeze: buffers are used as they are
+        MapFilePtr file = std::make_shared<MapFile>(meshfile);
+        EmbreeScenePtr scene = make_embree_scene(file, device, settings);
+        scene->commit();
+        return std::make_shared<EmbreeMap>(scene);
+    }
+
     AssimpIO io;
 
     // aiProcess_GenNormals does not work!
@@ -110,7 +138,7 @@ static EmbreeMapPtr import_embree_map(
         std::cerr << "[RMagine - Error] importEmbreeMap() - file '" << meshfile << "' contains no meshes" << std::endl;
     }
 
-    EmbreeScenePtr scene = make_embree_scene(ascene, device);
+    EmbreeScenePtr scene = make_embree_scene(ascene, device, settings);
     scene->freeze();
     scene->commit();
     return std::make_shared<EmbreeMap>(scene);
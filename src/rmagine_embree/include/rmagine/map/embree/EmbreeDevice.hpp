@@ -42,6 +42,9 @@
 #define RMAGINE_MAP_EMBREE_DEVICE_HPP
 
 #include <memory>
+#include <string>
+#include <atomic>
+#include <cstdint>
 
 // forward declare embree type
 struct RTCDeviceTy;
@@ -49,25 +52,112 @@ struct RTCDeviceTy;
 namespace rmagine
 {
 
+/**
+ * @brief Settings that are forwarded to the config string of rtcNewDevice.
+ * Empty/zero values keep Embree's defaults
+ */
+struct EmbreeDeviceSettings
+{
+    /**
+     * @brief number of build threads. 0: all hardware threads
+     */
+    unsigned int threads = 0;
+
+    /**
+     * @brief ISA to use, e.g. "sse4.2", "avx", "avx2", "avx512". Empty: best available
+     */
+    std::string isa = "";
+
+    /**
+     * @brief pin Embree's worker threads to hardware threads
+     */
+    bool set_affinity = false;
+
+    /**
+     * @brief "simd128", "simd256" or "simd512": highest ISA frequency level 
+     * Embree may use. Restricting it avoids AVX-512 frequency drops 
+     * that also slow down other threads on the same core. Empty: Embree default
+     */
+    std::string frequency_level = "";
+
+    /**
+     * @brief further options, appended verbatim (e.g. "verbose=1")
+     */
+    std::string config = "";
+
+    /**
+     * @brief Config string as passed to rtcNewDevice
+     */
+    std::string toConfigString() const;
+};
+
 class EmbreeDevice
 {
 public:
     EmbreeDevice();
 
+    EmbreeDevice(const EmbreeDeviceSettings& settings);
+
     ~EmbreeDevice();
 
     RTCDeviceTy* handle();
 
+    inline const EmbreeDeviceSettings& settings() const
+    {
+        return m_settings;
+    }
+
+    /**
+     * @brief Widest ray packet (16, 8, 4) that is natively supported 
+     * by the ISA Embree selected for this device. 1 if packets are not supported
+     */
+    unsigned int nativePacketSize() const;
+
+    /**
+     * @brief Bytes currently allocated by Embree for this device: 
+     * BVHs, internal geometry data and build buffers. Buffers shared 
+     * with Embree (e.g. mesh vertices) are not included, 
+     * see EmbreeGeometry::bytes()
+     */
+    size_t bytes() const;
+
+    /**
+     * @brief Maximum of bytes() since construction or the last resetBytesPeak()
+     */
+    size_t bytesPeak() const;
+
+    void resetBytesPeak();
+
 private:
+    // installed as embree memory monitor function
+    friend struct EmbreeMemoryMonitor;
+    // allocation (bytes > 0) or free (bytes < 0)
+    void trackBytes(int64_t bytes);
+
     RTCDeviceTy* m_device;
+    EmbreeDeviceSettings m_settings;
+    unsigned int m_native_packet_size;
+
+    std::atomic<int64_t> m_bytes{0};
+    std::atomic<int64_t> m_bytes_peak{0};
 };
 
 using EmbreeDevicePtr = std::shared_ptr<EmbreeDevice>;
 
+/**
+ * @brief Device that is used if no other device is passed to maps, 
+ * scenes and geometries. Created on first use.
+ */
 EmbreeDevicePtr embree_default_device();
 
 void embree_default_device_reset();
 
+/**
+ * @brief Set the settings of the default device. A default device that 
+ * already exists is replaced. Objects created before keep their device.
+ */
+void embree_default_device_configure(const EmbreeDeviceSettings& settings);
+
 } // namespace rmagine
 
 #endif // RMAGINE_MAP_EMBREE_DEVICE_HPP
\ No newline at end of file
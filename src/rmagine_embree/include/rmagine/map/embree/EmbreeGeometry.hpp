@@ -63,13 +63,18 @@ struct EmbreeClosestPointResult
       : d(std::numeric_limits<float>::max())
       , primID(RTC_INVALID_GEOMETRY_ID)
       , geomID(RTC_INVALID_GEOMETRY_ID)
+      , instID(RTC_INVALID_GEOMETRY_ID)
   {}
 
   float d;
   Point p;
   Vector n;
   unsigned int primID;
+  // geometry id inside of the (instanced) scene the closest mesh belongs to
   unsigned int geomID;
+  // id of the top-level instance the closest mesh was found in. 
+  // RTC_INVALID_GEOMETRY_ID if the mesh is not instanced
+  unsigned int instID;
 };
 
 struct EmbreePointQueryUserData 
@@ -129,6 +134,15 @@ public:
 
     virtual EmbreeGeometryType type() const = 0;
 
+    /**
+     * @brief Bytes of the buffers held by rmagine for this geometry. 
+     * Embree's own memory (BVH) is tracked by EmbreeDevice::bytes()
+     */
+    virtual size_t bytes() const
+    {
+        return 0;
+    }
+
     EmbreeScenePtr makeScene();
 
     EmbreeInstancePtr instantiate();
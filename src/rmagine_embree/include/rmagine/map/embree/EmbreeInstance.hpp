@@ -78,6 +78,14 @@ public:
     void set(EmbreeScenePtr scene);
     EmbreeScenePtr scene();
 
+    /**
+     * @brief Instanced scene without reference counting. Used inside of point query callbacks
+     */
+    inline const EmbreeScene* sceneRaw() const
+    {
+        return m_scene.get();
+    }
+
     // Make this more comfortable to use
     // - functions as: setMesh(), or addMesh() ?
     // - translate rotate scale? 
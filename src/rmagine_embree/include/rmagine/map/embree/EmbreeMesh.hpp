@@ -48,8 +48,10 @@
 
 #include <rmagine/math/types.h>
 #include <rmagine/types/mesh_types.h>
+#include <rmagine/map/MapFile.hpp>
 
 #include <memory>
+#include <optional>
 
 #include "EmbreeDevice.hpp"
 #include "EmbreeGeometry.hpp"
@@ -82,11 +84,55 @@ public:
     EmbreeMesh( const aiMesh* amesh,
                 EmbreeDevicePtr device = embree_default_device());
 
+    EmbreeMesh( const MapFileMesh& mesh,
+                MapFilePtr file,
+                EmbreeDevicePtr device = embree_default_device());
+
     virtual ~EmbreeMesh();
 
     void init(unsigned int Nvertices, unsigned int Nfaces);
     void init(const aiMesh* amesh);
 
+    /**
+     * @brief Use the buffers of a memory mapped map file without copying. 
+     * Embree traces the file's vertex and index buffers directly.
+     * The mesh keeps the file mapped.
+     * 
+     * Setting a transform or scale other than identity copies the 
+     * buffers to the mesh on the next apply()
+     */
+    void init(const MapFileMesh& mesh, MapFilePtr file);
+
+    /**
+     * @brief true if the buffers are shared with a map file
+     */
+    inline bool mapped() const
+    {
+        return static_cast<bool>(m_file);
+    }
+
+    /**
+     * @brief Memory-lean storage for static meshes
+     * 
+     * Bakes the current transform into the buffers and resets it to identity. 
+     * Afterwards a single vertex buffer is shared with embree, the 
+     * untransformed copies and the face normals are released. 
+     * Face normals are recomputed on demand (closest point queries) 
+     * or by calling computeFaceNormals().
+     * 
+     * Setting a transform other than identity allocates a 
+     * transformed vertex buffer again on the next apply()
+     */
+    void compact();
+
+    /**
+     * @brief true if compact() was called and the mesh is still untransformed
+     */
+    inline bool compacted() const
+    {
+        return m_compact;
+    }
+
     void initVertexNormals();
 
     // PUBLIC ATTRIBUTES
@@ -97,6 +143,7 @@ public:
     
     MemoryView<const Vertex, RAM> verticesTransformed() const;
     MemoryView<const Vector, RAM> faceNormalsTransformed() const;
+    MemoryView<const Vector, RAM> vertexNormalsTransformed() const;
     
     void computeFaceNormals();
 
@@ -111,6 +158,12 @@ public:
         return EmbreeGeometryType::MESH;
     }
 
+    /**
+     * @brief Bytes of the vertex, face and normal buffers. 
+     * Buffers of a memory mapped map file are not counted
+     */
+    virtual size_t bytes() const;
+
     // embree constructed buffers
 protected:
     unsigned int m_num_vertices = 0;
@@ -123,6 +176,24 @@ protected:
     Memory<Vector, RAM> m_face_normals;
 
 private:
+    /**
+     * @brief Copy the buffers of the map file to the mesh and release the file
+     */
+    void unmap();
+
+    /**
+     * @brief Allocate the transformed vertex buffer of a compacted mesh 
+     * and recompute its face normals
+     */
+    void expand();
+
+    // m_vertices is the buffer shared with embree. Identity transform
+    bool m_compact = false;
+
+    // shared buffers if initialized from a map file. Identity transform
+    MapFilePtr m_file;
+    std::optional<MapFileMesh> m_mapped;
+
     // after transform
     // Vertex* m_vertices_transformed;
     Memory<Vector, RAM> m_vertices_transformed;
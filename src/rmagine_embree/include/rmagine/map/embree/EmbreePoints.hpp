@@ -92,6 +92,11 @@ public:
       return EmbreeGeometryType::POINTS;
     }
 
+    virtual size_t bytes() const
+    {
+      return (m_points.size() + m_points_transformed.size()) * sizeof(PointWithRadius);
+    }
+
 protected:
     unsigned int m_num_points;
     Memory<PointWithRadius> m_points;
@@ -47,9 +47,12 @@
 #include <memory>
 #include <unordered_map>
 #include <optional>
+#include <vector>
 #include <assimp/scene.h>
 
 #include <rmagine/math/types/Vector3.hpp>
+#include <rmagine/types/Memory.hpp>
+#include <rmagine/map/MapFile.hpp>
 
 #include <embree4/rtcore.h>
 
@@ -80,6 +83,24 @@ struct EmbreeSceneSettings
    * - RTC_SCENE_FLAG_CONTEXT_FILTER_FUNCTION
    */
   RTCSceneFlags flags = RTCSceneFlags::RTC_SCENE_FLAG_NONE;
+
+  /**
+   * @brief memory-lean static scene: adds RTC_SCENE_FLAG_COMPACT 
+   * to flags and compacts all meshes on freeze() (see EmbreeMesh::compact)
+   */
+  bool compact = false;
+};
+
+/**
+ * @brief Timings of the BVH builds of a scene. The memory of the BVHs
+ * is tracked per device (EmbreeDevice::bytes())
+ */
+struct EmbreeCommitStats
+{
+  size_t commits = 0;
+  // seconds
+  double last_time = 0.0;
+  double total_time = 0.0;
 };
 
 /**
@@ -104,6 +125,14 @@ public:
   void setFlags(RTCSceneFlags flags);
 
   unsigned int add(EmbreeGeometryPtr geom);
+
+  /**
+   * @brief Add a geometry with a given geometry id, 
+   * e.g. to restore the ids of a stored scene
+   * 
+   * @throws EmbreeException if the id is already in use or RTC_INVALID_GEOMETRY_ID
+   */
+  unsigned int add(EmbreeGeometryPtr geom, unsigned int geom_id);
   std::optional<unsigned int> getOpt(const EmbreeGeometryPtr geom) const;
   std::optional<unsigned int> getOpt(const std::shared_ptr<const EmbreeGeometry> geom) const;
   
@@ -131,6 +160,18 @@ public:
 
   void commit();
 
+  inline const EmbreeCommitStats& commitStats() const
+  {
+    return m_commit_stats;
+  }
+
+  /**
+   * @brief Bytes of the buffers of all geometries in this scene and 
+   * in the instanced scenes. Shared geometries are counted once. 
+   * The BVHs are tracked by the device: device()->bytes()
+   */
+  size_t bytes() const;
+
   EmbreeInstancePtr instantiate();
 
   /**
@@ -165,6 +206,7 @@ public:
    *    - instance destroyed
    *    - instance transform applied to geometry
    *    - transformed geometry added to root
+   * - if the scene was created with EmbreeSceneSettings::compact: compact()
    * 
    * Drawbacks:
    * - Recover to dynamic map not tested yet. use with care
@@ -172,9 +214,55 @@ public:
    */
   void freeze();
 
+  /**
+   * @brief Compact all meshes of this scene and of the instanced scenes.
+   * Shared meshes are compacted once. Every already committed scene 
+   * containing a compacted mesh, directly or instanced, is committed again
+   */
+  void compact();
+
   // utility functions
   EmbreeClosestPointResult closestPoint(const Point& qp, const float& max_distance = std::numeric_limits<float>::max()) const;
 
+  /**
+   * @brief Closest point queries for a batch of points, answered in parallel
+   * 
+   * @param qps          query points
+   * @param res          one result per query point
+   * @param max_distance  search radius
+   * 
+   * @throws EmbreeException if res is smaller than qps
+   */
+  void closestPoints(
+    const MemoryView<const Point, RAM>& qps, 
+    MemoryView<EmbreeClosestPointResult, RAM>& res,
+    const float& max_distance = std::numeric_limits<float>::max()) const;
+
+  Memory<EmbreeClosestPointResult, RAM> closestPoints(
+    const MemoryView<const Point, RAM>& qps, 
+    const float& max_distance = std::numeric_limits<float>::max()) const;
+
+  /**
+   * @brief Mesh with the given geometry id without hash map lookup and cast.
+   * Used inside of point query callbacks
+   * 
+   * @return nullptr if no mesh is attached at geom_id
+   */
+  inline const EmbreeMesh* meshRaw(const unsigned int geom_id) const
+  {
+    return (geom_id < m_mesh_table.size()) ? m_mesh_table[geom_id] : nullptr;
+  }
+
+  /**
+   * @brief Instance with the given geometry id. See meshRaw
+   * 
+   * @return nullptr if no instance is attached at geom_id
+   */
+  inline const EmbreeInstance* instanceRaw(const unsigned int geom_id) const
+  {
+    return (geom_id < m_instance_table.size()) ? m_instance_table[geom_id] : nullptr;
+  }
+
   inline EmbreeDevicePtr device() const 
   {
       return m_device;
@@ -185,10 +273,19 @@ public:
   
 private:
 
+  void registerGeometry(EmbreeGeometryPtr geom, unsigned int geom_id);
+
   std::unordered_map<unsigned int, EmbreeGeometryPtr > m_geometries;
   std::unordered_map<EmbreeGeometryPtr, unsigned int> m_ids;
 
+  // flat geom_id -> mesh/instance tables, kept in sync by add and remove. 
+  // nullptr for other geometry types
+  std::vector<const EmbreeMesh*> m_mesh_table;
+  std::vector<const EmbreeInstance*> m_instance_table;
+
   bool m_committed_once = false;
+  bool m_compact = false;
+  EmbreeCommitStats m_commit_stats;
 
   RTCSceneTy* m_scene;
   EmbreeDevicePtr m_device;
@@ -229,7 +326,31 @@ std::shared_ptr<T> EmbreeScene::getAs(const unsigned int geom_id) const
 
 EmbreeScenePtr make_embree_scene(
     const aiScene* ascene,
-    EmbreeDevicePtr device = embree_default_device());
+    EmbreeDevicePtr device = embree_default_device(),
+    EmbreeSceneSettings settings = {});
+
+/**
+ * @brief Build a scene from a memory mapped .rmap file. 
+ * 
+ * The meshes use the buffers of the file without copying them 
+ * (see EmbreeMesh::init(const MapFileMesh&, MapFilePtr)). Geometry ids 
+ * of the stored scene are preserved. The returned scene is not committed yet.
+ * 
+ * @throws EmbreeException if the instance hierarchy contains a cycle
+ */
+EmbreeScenePtr make_embree_scene(
+    MapFilePtr file,
+    EmbreeDevicePtr device = embree_default_device(),
+    EmbreeSceneSettings settings = {});
+
+/**
+ * @brief Store a scene as .rmap file. Meshes are stored transformed, 
+ * instances keep their transform. Geometries that are neither meshes 
+ * nor instances are skipped.
+ */
+void write_map_file(
+    const std::string& filename,
+    EmbreeScenePtr scene);
 
 } // namespace rmagine
 
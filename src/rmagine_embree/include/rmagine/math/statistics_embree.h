@@ -0,0 +1,104 @@
+/*
+ * Copyright (c) 2025, University Osnabrück
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *     * Redistributions of source code must retain the above copyright
+ *       notice, this list of conditions and the following disclaimer.
+ *     * Redistributions in binary form must reproduce the above copyright
+ *       notice, this list of conditions and the following disclaimer in the
+ *       documentation and/or other materials provided with the distribution.
+ *     * Neither the name of the University Osnabrück nor the
+ *       names of its contributors may be used to endorse or promote products
+ *       derived from this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND
+ * ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+ * WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+ * DISCLAIMED. IN NO EVENT SHALL University Osnabrück BE LIABLE FOR ANY
+ * DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES
+ * (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+ * LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND
+ * ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ * (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS
+ * SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+/**
+ * @file
+ * 
+ * @brief Statistics functions that search correspondences in an EmbreeMap
+ *
+ * @copyright Copyright (c) 2025, University Osnabrück. All rights reserved.
+ * This project is released under the 3-Clause BSD License.
+ * 
+ */
+#ifndef RMAGINE_MATH_STATISTICS_EMBREE_H
+#define RMAGINE_MATH_STATISTICS_EMBREE_H
+
+#include <rmagine/math/types.h>
+#include <rmagine/types/PointCloud.hpp>
+#include <rmagine/types/UmeyamaReductionConstraints.hpp>
+#include <rmagine/map/EmbreeMap.hpp>
+
+namespace rmagine
+{
+
+/**
+ * @brief Reducing dataset and the closest points of the map to the cross statistics 
+ * using point to point (P2P) distances.
+ * 
+ * Every dataset point is transformed by pre_transform and matched with the closest
+ * point on the map's surface. The queries are answered in parallel and reduced
+ * directly to a single cross statistic. No sensor model or simulated model is required.
+ * 
+ * - set mask of dataset to 0 at index=X to ignore the point X
+ * - set the id view of dataset to filter by 'params.dataset_id'
+ * - params.max_dist is used as search radius
+ * 
+ * @param[in] pre_transform  transforms the dataset into the map frame
+ * @param[in] dataset   PointCloudView pointing to buffers of the dataset
+ * @param[in] map       map to search the correspondences in
+ * @param[in] params    Constraints that need to be satisfied
+ * @param[out] stats    Resulting statistics
+ * @param[in] filter_model_ids  only use correspondences on object 'params.model_id' 
+ *                              (instance id, or geometry id if not instanced)
+ */
+void statistics_p2p(
+    const Transform& pre_transform,
+    const PointCloudView_<RAM>& dataset,
+    const EmbreeMapPtr map,
+    const UmeyamaReductionConstraints params,
+    CrossStatistics& stats,
+    const bool filter_model_ids = false);
+
+CrossStatistics statistics_p2p(
+    const Transform& pre_transform,
+    const PointCloudView_<RAM>& dataset,
+    const EmbreeMapPtr map,
+    const UmeyamaReductionConstraints params,
+    const bool filter_model_ids = false);
+
+/**
+ * @brief Same as the map-based statistics_p2p, but every dataset point is 
+ * projected onto the plane of the closest face (P2L)
+ */
+void statistics_p2l(
+    const Transform& pre_transform,
+    const PointCloudView_<RAM>& dataset,
+    const EmbreeMapPtr map,
+    const UmeyamaReductionConstraints params,
+    CrossStatistics& stats,
+    const bool filter_model_ids = false);
+
+CrossStatistics statistics_p2l(
+    const Transform& pre_transform,
+    const PointCloudView_<RAM>& dataset,
+    const EmbreeMapPtr map,
+    const UmeyamaReductionConstraints params,
+    const bool filter_model_ids = false);
+
+} // namespace rmagine
+
+#endif // RMAGINE_MATH_STATISTICS_EMBREE_H
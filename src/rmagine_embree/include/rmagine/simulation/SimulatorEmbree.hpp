@@ -45,10 +45,38 @@
 #include <rmagine/types/Memory.hpp>
 #include <rmagine/types/sensor_models.h>
 #include <rmagine/simulation/SimulationResults.hpp>
+#include <rmagine/simulation/BundlePool.hpp>
+#include <rmagine/math/types.h>
+#include <rmagine/types/PointCloud.hpp>
+#include <rmagine/types/UmeyamaReductionConstraints.hpp>
+#include <rmagine/noise/Noise.hpp>
+
+#include "embree_common.h"
+
+#include <future>
+#include <memory>
+#include <type_traits>
+
+#include <tbb/task_arena.h>
 
 namespace rmagine
 {
 
+/**
+ * @brief Controls how the Embree simulators partition their work
+ * 
+ * - Fewer poses than worker threads (e.g. a single scan): every scan is split into
+ *   tiles of at most rows x cols rays
+ * - Otherwise: each task simulates chunks of whole scans, pose-major, with 
+ *   at least 'poses' poses per task
+ */
+struct EmbreeGrainSize
+{
+  unsigned int rows = 1;
+  unsigned int cols = 128;
+  unsigned int poses = 1;
+};
+
 class SimulatorEmbree {
 public:
   SimulatorEmbree();
@@ -65,13 +93,236 @@ public:
     return m_map;
   }
 
+  /**
+   * @brief Set the number of neighboring rays of a scan line that are traced at once
+   * 
+   * - 0: widest packet that is natively supported by the map's device (default)
+   * - 1: single rays (rtcIntersect1)
+   * - 4, 8, 16: ray packets (rtcIntersect4, rtcIntersect8, rtcIntersect16)
+   * 
+   * @param packet_size 
+   */
+  void setPacketSize(unsigned int packet_size);
+
+  /**
+   * @brief Packet size used for simulation. A packet size of 0 is resolved
+   * to the native packet size of the map's device
+   */
+  unsigned int packetSize() const;
+
+  /**
+   * @brief Set the tile and chunk sizes used to distribute the simulation over threads
+   */
+  void setGrainSize(const EmbreeGrainSize& grain_size);
+
+  inline EmbreeGrainSize grainSize() const
+  {
+    return m_grain_size;
+  }
+
+  /**
+   * @brief Bind the simulator to a task arena. Synchronous and asynchronous 
+   * simulations then only use the threads of this arena, so they do not 
+   * compete with TBB work of the rest of the process. 
+   * Custom arenas (e.g. with a task_scheduler_observer pinning the threads 
+   * to isolated cores) can be shared between several simulators.
+   * 
+   * @param arena  nullptr: simulate in the arena of the calling thread (default)
+   */
+  void setArena(std::shared_ptr<tbb::task_arena> arena);
+
+  /**
+   * @brief Bind the simulator to a new arena of fixed concurrency
+   * 
+   * @param max_concurrency  maximum number of threads used for simulation
+   */
+  void setConcurrency(int max_concurrency);
+
+  inline std::shared_ptr<tbb::task_arena> arena() const
+  {
+    return m_arena;
+  }
+
+  /**
+   * @brief Attach a noise model that is applied to every ray while simulating. 
+   * Ranges, Points and Hits of the results are computed from the disturbed range, 
+   * so they stay consistent. The ranges are the same as applying the noise 
+   * to the simulated ranges afterwards (noise->apply(ranges)), except for 
+   * misses: they keep their invalid range unless the noise moves it into 
+   * the sensor range (e.g. UniformDustNoise). Such returns are written as hits 
+   * without surface: NaN normals and invalid ids. 
+   * Every simulate call draws the next stream of the noise.
+   * The statistics functions are not affected.
+   * 
+   * @param noise  nullptr: no noise (default)
+   */
+  void setNoise(NoisePtr noise);
+
+  inline NoisePtr noise() const
+  {
+    return m_noise;
+  }
+
 protected:
+
+  /**
+   * @brief Run f asynchronously on the simulator's task arena, or on 
+   * a process-wide arena if the simulator is not bound to one. 
+   * Exceptions thrown by f are rethrown by the returned future's get()
+   */
+  template<typename F>
+  std::future<std::invoke_result_t<F> > enqueue_(F&& f) const;
+
+  /**
+   * @brief m_arena, or the process-wide arena for asynchronous simulations if unset
+   */
+  tbb::task_arena& asyncArena_() const;
+
+  /**
+   * @brief Throws if a buffer of the pool cannot hold Nrays rays per pose for Nposes poses
+   */
+  template<typename BundleT, typename MemT>
+  static void check_pool_(const BundlePool<BundleT, MemT>& pool, 
+    size_t Nrays, size_t Nposes);
+
+  /**
+   * @brief Generic simulation kernel shared by all Embree simulators
+   * 
+   * @tparam ModelT   sensor model providing getOrigin, getDirection and getBufferId
+   */
+  template<typename ModelT, typename BundleT>
+  void simulate_(
+    const ModelT& model,
+    const MemoryView<const Transform, RAM>& Tbm,
+    BundleT& ret) const;
+
+  /**
+   * @brief simulate_ in the arena of the calling thread
+   */
+  template<typename ModelT, typename BundleT>
+  void simulateInArena_(
+    const ModelT& model,
+    const MemoryView<const Transform, RAM>& Tbm,
+    BundleT& ret) const;
+
+  /**
+   * @brief Cast the rays of one pose and reduce the hits directly with the 
+   * index-wise corresponding dataset points to a CrossStatistics. 
+   * Equivalent to simulating Points, Normals and Hits followed by 
+   * statistics_p2p / statistics_p2l without materializing the model.
+   * 
+   * @tparam P2L  true: point to plane, false: point to point
+   */
+  template<bool P2L, typename ModelT>
+  CrossStatistics statistics_(
+    const ModelT& model,
+    const Transform& Tbm,
+    const Transform& pre_transform,
+    const PointCloudView_<RAM>& dataset,
+    const UmeyamaReductionConstraints& params,
+    const bool filter_model_ids) const;
+
+  /**
+   * @brief Reduce the rays [hid_begin, hid_end) of scan line vid into acc
+   */
+  template<unsigned int N, bool P2L, typename ModelT>
+  void reduceRow_(
+    const ModelT& model,
+    const Transform& Tsm,
+    const Transform& Tms,
+    const Transform& pre_transform,
+    const PointCloudView_<RAM>& dataset,
+    const UmeyamaReductionConstraints& params,
+    const bool filter_model_ids,
+    const unsigned int vid,
+    const unsigned int hid_begin,
+    const unsigned int hid_end,
+    CrossStatistics& acc) const;
+
+  /**
+   * @brief Simulate the rays [vid_begin, vid_end) x [hid_begin, hid_end) of pose pid
+   */
+  template<typename ModelT, typename BundleT>
+  void castTile_(
+    const ModelT& model,
+    const MemoryView<const Transform, RAM>& Tbm,
+    const unsigned int pid,
+    const unsigned int vid_begin,
+    const unsigned int vid_end,
+    const unsigned int hid_begin,
+    const unsigned int hid_end,
+    const unsigned int packet_size,
+    const SimulationFlags& flags,
+    const uint32_t noise_stream,
+    BundleT& ret) const;
+
+  /**
+   * @brief Trace the rays [hid_begin, hid_end) of scan line vid in packets of N
+   * 
+   * @param noise_stream  stream of m_noise drawn by this simulation
+   */
+  template<unsigned int N, typename ModelT, typename BundleT>
+  void castRow_(
+    const ModelT& model,
+    const Transform& Tsm,
+    const Transform& Tms,
+    const unsigned int glob_shift,
+    const unsigned int vid,
+    const unsigned int hid_begin,
+    const unsigned int hid_end,
+    const SimulationFlags& flags,
+    const uint32_t noise_stream,
+    BundleT& ret) const;
+
+  /**
+   * @brief Intersect the rays [hid_begin, hid_end) of scan line vid in packets of N 
+   * and pass every result to a callback
+   * 
+   * @param on_hit   on_hit(hid, ray_orig_s, ray_dir_s, tfar, Ng, prim_id, geom_id, inst_id)
+   * @param on_miss  on_miss(hid)
+   */
+  template<unsigned int N, typename ModelT, typename HitFunc, typename MissFunc>
+  void traceRow_(
+    const ModelT& model,
+    const Transform& Tsm,
+    const unsigned int vid,
+    const unsigned int hid_begin,
+    const unsigned int hid_end,
+    HitFunc&& on_hit,
+    MissFunc&& on_miss) const;
+
+  /**
+   * @brief Occlusion-only variant of castRow_ for bundles that only contain Hits.
+   * Traversal stops at the first intersection inside [range.min, range.max]
+   */
+  template<unsigned int N, typename ModelT, typename BundleT>
+  void occludeRow_(
+    const ModelT& model,
+    const Transform& Tsm,
+    const unsigned int glob_shift,
+    const unsigned int vid,
+    const unsigned int hid_begin,
+    const unsigned int hid_end,
+    BundleT& ret) const;
+
   EmbreeMapPtr m_map;
   
   Memory<Transform, RAM> m_Tsb;
+
+  unsigned int m_packet_size = 0;
+
+  EmbreeGrainSize m_grain_size;
+
+  // simulations run in this arena if set
+  std::shared_ptr<tbb::task_arena> m_arena;
+
+  // applied per ray if set
+  NoisePtr m_noise;
 };
 
 } // namespace rmagine
 
+#include "SimulatorEmbree.tcc"
+
 
 #endif // RMAGINE_SIMULATION_SIMULATOR_EMBREE_HPP
\ No newline at end of file
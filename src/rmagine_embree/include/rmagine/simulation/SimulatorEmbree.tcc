@@ -0,0 +1,542 @@
+#include "SimulatorEmbree.hpp"
+#include <rmagine/simulation/SimulationResults.hpp>
+#include <rmagine/util/exceptions.h>
+#include <limits>
+#include <algorithm>
+
+#include "embree_common.h"
+
+#include <embree4/rtcore.h>
+
+#include <tbb/parallel_for.h>
+#include <tbb/blocked_range.h>
+#include <tbb/blocked_range2d.h>
+#include <tbb/blocked_range3d.h>
+#include <tbb/parallel_reduce.h>
+#include <tbb/partitioner.h>
+#include <tbb/task_arena.h>
+
+#include <sstream>
+
+namespace rmagine
+{
+
+template<typename F>
+std::future<std::invoke_result_t<F> > SimulatorEmbree::enqueue_(F&& f) const
+{
+  using ResultT = std::invoke_result_t<F>;
+
+  // task_arena::enqueue requires a copyable functor
+  auto task = std::make_shared<std::packaged_task<ResultT()> >(std::forward<F>(f));
+  std::future<ResultT> fut = task->get_future();
+
+  asyncArena_().enqueue([task]() { (*task)(); });
+  return fut;
+}
+
+template<typename BundleT, typename MemT>
+void SimulatorEmbree::check_pool_(
+  const BundlePool<BundleT, MemT>& pool,
+  size_t Nrays, 
+  size_t Nposes)
+{
+  if(pool.capacity() < Nrays * Nposes)
+  {
+    std::stringstream ss;
+    ss << "BundlePool buffers hold " << pool.capacity() 
+       << " elements but the simulation requires " << Nrays * Nposes 
+       << " (" << Nposes << " poses x " << Nrays << " rays)";
+    RM_THROW(EmbreeException, ss.str());
+  }
+}
+
+template<typename ModelT, typename BundleT>
+void SimulatorEmbree::simulate_(
+  const ModelT& model,
+  const MemoryView<const Transform, RAM>& Tbm,
+  BundleT& ret) const
+{
+  if(m_arena)
+  {
+    // no-op if already called from inside the arena
+    m_arena->execute([&]() {
+      simulateInArena_(model, Tbm, ret);
+    });
+  } else {
+    simulateInArena_(model, Tbm, ret);
+  }
+}
+
+template<typename ModelT, typename BundleT>
+void SimulatorEmbree::simulateInArena_(
+  const ModelT& model,
+  const MemoryView<const Transform, RAM>& Tbm,
+  BundleT& ret) const
+{
+  SimulationFlags flags = SimulationFlags::Zero();
+  set_simulation_flags_<bundle_host_memory_t<BundleT> >(ret, flags);
+
+  const unsigned int packet_size = packetSize();
+  const unsigned int Nposes = Tbm.size();
+  const unsigned int concurrency = tbb::this_task_arena::max_concurrency();
+  const uint32_t noise_stream = m_noise ? m_noise->nextStream() : 0;
+
+  if(Nposes < concurrency)
+  {
+    // few poses (e.g. real-time single scan): 
+    // not enough poses to keep every thread busy -> split scans into tiles
+    tbb::parallel_for( tbb::blocked_range3d<unsigned int>(
+      0, Nposes, 1,
+      0, model.getHeight(), m_grain_size.rows,
+      0, model.getWidth(), m_grain_size.cols),
+      [&](const tbb::blocked_range3d<unsigned int>& r)
+    {
+      for(unsigned int pid = r.pages().begin(), pid_end = r.pages().end(); pid < pid_end; pid++)
+      {
+        castTile_(model, Tbm, pid, 
+          r.rows().begin(), r.rows().end(),
+          r.cols().begin(), r.cols().end(),
+          packet_size, flags, noise_stream, ret);
+      }
+    }, tbb::simple_partitioner());
+  } else {
+    // large batches: pose-major chunks of whole scans
+    tbb::parallel_for( tbb::blocked_range<unsigned int>(
+      0, Nposes, m_grain_size.poses),
+      [&](const tbb::blocked_range<unsigned int>& r)
+    {
+      for(unsigned int pid = r.begin(), pid_end = r.end(); pid < pid_end; pid++)
+      {
+        castTile_(model, Tbm, pid, 
+          0, model.getHeight(),
+          0, model.getWidth(),
+          packet_size, flags, noise_stream, ret);
+      }
+    });
+  }
+}
+
+template<bool P2L, typename ModelT>
+CrossStatistics SimulatorEmbree::statistics_(
+  const ModelT& model,
+  const Transform& Tbm,
+  const Transform& pre_transform,
+  const PointCloudView_<RAM>& dataset,
+  const UmeyamaReductionConstraints& params,
+  const bool filter_model_ids) const
+{
+  const Transform Tsm = Tbm * m_Tsb[0];
+  const Transform Tms = Tsm.inv();
+  const unsigned int packet_size = packetSize();
+
+  auto reduce = [&]()
+  {
+    return tbb::parallel_reduce(tbb::blocked_range2d<unsigned int>(
+      0, model.getHeight(), m_grain_size.rows,
+      0, model.getWidth(), m_grain_size.cols),
+      CrossStatistics::Identity(),
+      [&](const tbb::blocked_range2d<unsigned int>& r, CrossStatistics acc)
+      {
+        for(unsigned int vid = r.rows().begin(); vid < r.rows().end(); vid++)
+        {
+          switch(packet_size)
+          {
+            case 16:
+              reduceRow_<16, P2L>(model, Tsm, Tms, pre_transform, dataset, params, 
+                filter_model_ids, vid, r.cols().begin(), r.cols().end(), acc);
+              break;
+            case 8:
+              reduceRow_<8, P2L>(model, Tsm, Tms, pre_transform, dataset, params, 
+                filter_model_ids, vid, r.cols().begin(), r.cols().end(), acc);
+              break;
+            case 4:
+              reduceRow_<4, P2L>(model, Tsm, Tms, pre_transform, dataset, params, 
+                filter_model_ids, vid, r.cols().begin(), r.cols().end(), acc);
+              break;
+            default:
+              reduceRow_<1, P2L>(model, Tsm, Tms, pre_transform, dataset, params, 
+                filter_model_ids, vid, r.cols().begin(), r.cols().end(), acc);
+              break;
+          }
+        }
+        return acc;
+      },
+      std::plus<CrossStatistics>()
+    );
+  };
+
+  if(m_arena)
+  {
+    return m_arena->execute(reduce);
+  }
+  return reduce();
+}
+
+template<unsigned int N, bool P2L, typename ModelT>
+void SimulatorEmbree::reduceRow_(
+  const ModelT& model,
+  const Transform& Tsm,
+  const Transform& Tms,
+  const Transform& pre_transform,
+  const PointCloudView_<RAM>& dataset,
+  const UmeyamaReductionConstraints& params,
+  const bool filter_model_ids,
+  const unsigned int vid,
+  const unsigned int hid_begin,
+  const unsigned int hid_end,
+  CrossStatistics& acc) const
+{
+  traceRow_<N>(model, Tsm, vid, hid_begin, hid_end,
+    [&](const unsigned int hid,
+        const Vector& ray_orig_s, const Vector& ray_dir_s,
+        const float tfar, const Vector& Ng,
+        const unsigned int /*prim_id*/, const unsigned int geom_id, const unsigned int inst_id)
+    {
+      const unsigned int i = model.getBufferId(vid, hid);
+
+      // same masking as for a simulated model: hits closer than range.min are invalid
+      if(tfar < model.range.min
+        || (!dataset.mask.empty() && dataset.mask[i] == 0)
+        || (!dataset.ids.empty()  && dataset.ids[i] != params.dataset_id))
+      {
+        return;
+      }
+
+      if(filter_model_ids)
+      {
+        const unsigned int object_id = (inst_id != RTC_INVALID_GEOMETRY_ID) ? inst_id : geom_id;
+        if(object_id != params.model_id)
+        {
+          return;
+        }
+      }
+
+      const Vector Di = pre_transform * dataset.points[i];
+      const Vector Ii = ray_dir_s * tfar + ray_orig_s;
+
+      if constexpr(P2L)
+      {
+        const Vector Ni = hit_normal_(Tms, Ng, ray_dir_s);
+        const float signed_plane_dist = (Ii - Di).dot(Ni);
+        if(fabs(signed_plane_dist) < params.max_dist)
+        {
+          // nearest point on model
+          const Vector Mi = Di + Ni * signed_plane_dist;
+          acc += CrossStatistics::Init(Di, Mi);
+        }
+      } else {
+        const float dist = (Ii - Di).l2norm();
+        if(dist < params.max_dist)
+        {
+          acc += CrossStatistics::Init(Di, Ii);
+        }
+      }
+    },
+    [](const unsigned int /*hid*/)
+    {
+      // misses have no correspondence
+    });
+}
+
+template<typename ModelT, typename BundleT>
+void SimulatorEmbree::castTile_(
+  const ModelT& model,
+  const MemoryView<const Transform, RAM>& Tbm,
+  const unsigned int pid,
+  const unsigned int vid_begin,
+  const unsigned int vid_end,
+  const unsigned int hid_begin,
+  const unsigned int hid_end,
+  const unsigned int packet_size,
+  const SimulationFlags& flags,
+  const uint32_t noise_stream,
+  BundleT& ret) const
+{
+  const Transform Tbm_ = Tbm[pid];
+  const Transform Tsm_ = Tbm_ * m_Tsb[0];
+
+  // TODO: only required for certain elements (Normals, ...)
+  const Transform Tms_ = Tsm_.inv();
+
+  const unsigned int glob_shift = pid * model.size();
+
+  for(unsigned int vid = vid_begin; vid < vid_end; vid++)
+  {
+    switch(packet_size)
+    {
+      case 16:
+        castRow_<16>(model, Tsm_, Tms_, glob_shift, vid,
+          hid_begin, hid_end, flags, noise_stream, ret);
+        break;
+      case 8:
+        castRow_<8>(model, Tsm_, Tms_, glob_shift, vid,
+          hid_begin, hid_end, flags, noise_stream, ret);
+        break;
+      case 4:
+        castRow_<4>(model, Tsm_, Tms_, glob_shift, vid,
+          hid_begin, hid_end, flags, noise_stream, ret);
+        break;
+      default:
+        castRow_<1>(model, Tsm_, Tms_, glob_shift, vid,
+          hid_begin, hid_end, flags, noise_stream, ret);
+        break;
+    }
+  }
+}
+
+template<unsigned int N, typename ModelT, typename BundleT>
+void SimulatorEmbree::castRow_(
+  const ModelT& model,
+  const Transform& Tsm,
+  const Transform& Tms,
+  const unsigned int glob_shift,
+  const unsigned int vid,
+  const unsigned int hid_begin,
+  const unsigned int hid_end,
+  const SimulationFlags& flags,
+  const uint32_t noise_stream,
+  BundleT& ret) const
+{
+  const Noise* noise = m_noise.get();
+
+  if constexpr(is_hits_only_<BundleT>())
+  {
+    // with noise the disturbed range decides about a hit, 
+    // which requires the full intersection
+    if(!noise)
+    {
+      if(flags.hits)
+      {
+        occludeRow_<N>(model, Tsm, glob_shift, vid, hid_begin, hid_end, ret);
+      }
+      return;
+    }
+  }
+
+  traceRow_<N>(model, Tsm, vid, hid_begin, hid_end,
+    [&](const unsigned int hid,
+        const Vector& ray_orig_s, const Vector& ray_dir_s,
+        const float tfar, const Vector& Ng,
+        const unsigned int prim_id, const unsigned int geom_id, const unsigned int inst_id)
+    {
+      const unsigned int glob_id = glob_shift + model.getBufferId(vid, hid);
+      const float range = noise ? noise->applyAt(tfar, glob_id, noise_stream) : tfar;
+      write_hit_(ret, flags, glob_id,
+        ray_orig_s, ray_dir_s, Tms, model.range,
+        range, Ng, prim_id, geom_id, inst_id);
+    },
+    [&](const unsigned int hid)
+    {
+      const unsigned int glob_id = glob_shift + model.getBufferId(vid, hid);
+      if(noise)
+      {
+        const float range = noise->applyAt(model.range.invalidValue(), glob_id, noise_stream);
+        if(model.range.inside(range))
+        {
+          // return without surface, e.g. dust
+          const float nan = std::numeric_limits<float>::quiet_NaN();
+          write_hit_(ret, flags, glob_id,
+            model.getOrigin(vid, hid), model.getDirection(vid, hid), Tms, model.range,
+            range, Vector{nan, nan, nan}, 
+            RTC_INVALID_GEOMETRY_ID, RTC_INVALID_GEOMETRY_ID, RTC_INVALID_GEOMETRY_ID);
+          return;
+        }
+      }
+      write_miss_(ret, flags, glob_id, model.range);
+    });
+}
+
+template<unsigned int N, typename ModelT, typename HitFunc, typename MissFunc>
+void SimulatorEmbree::traceRow_(
+  const ModelT& model,
+  const Transform& Tsm,
+  const unsigned int vid,
+  const unsigned int hid_begin,
+  const unsigned int hid_end,
+  HitFunc&& on_hit,
+  MissFunc&& on_miss) const
+{
+  RTCScene scene = m_map->scene->handle();
+
+  if constexpr(N == 1)
+  {
+    for(unsigned int hid = hid_begin; hid < hid_end; hid++)
+    {
+      const Vector ray_orig_s = model.getOrigin(vid, hid);
+      const Vector ray_orig_m = Tsm * ray_orig_s;
+      const Vector ray_dir_s = model.getDirection(vid, hid);
+      const Vector ray_dir_m = Tsm.R * ray_dir_s;
+
+      RTCRayHit rayhit;
+      rayhit.ray.org_x = ray_orig_m.x;
+      rayhit.ray.org_y = ray_orig_m.y;
+      rayhit.ray.org_z = ray_orig_m.z;
+      rayhit.ray.dir_x = ray_dir_m.x;
+      rayhit.ray.dir_y = ray_dir_m.y;
+      rayhit.ray.dir_z = ray_dir_m.z;
+      rayhit.ray.tnear = 0; // if set to model.range.min we would scan through near occlusions
+      rayhit.ray.tfar = model.range.max;
+      rayhit.ray.mask = -1;
+      rayhit.ray.flags = 0;
+      rayhit.hit.geomID = RTC_INVALID_GEOMETRY_ID;
+      rayhit.hit.instID[0] = RTC_INVALID_GEOMETRY_ID;
+
+      rtcIntersect1(scene, &rayhit);
+
+      if(rayhit.hit.geomID != RTC_INVALID_GEOMETRY_ID)
+      {
+        on_hit(hid, ray_orig_s, ray_dir_s,
+          rayhit.ray.tfar,
+          Vector{rayhit.hit.Ng_x, rayhit.hit.Ng_y, rayhit.hit.Ng_z},
+          rayhit.hit.primID, rayhit.hit.geomID, rayhit.hit.instID[0]);
+      } else {
+        on_miss(hid);
+      }
+    }
+  } else {
+    using RayHitN = EmbreeRayHitN<N>;
+
+    // neighboring cells of one scan line form a packet
+    for(unsigned int hid_packet = hid_begin; hid_packet < hid_end; hid_packet += N)
+    {
+      const unsigned int n_valid = std::min(N, hid_end - hid_packet);
+
+      alignas(64) int valid[N];
+      typename RayHitN::Type rayhit;
+      Vector ray_origs_s[N];
+      Vector ray_dirs_s[N];
+
+      for(unsigned int i = 0; i < N; i++)
+      {
+        if(i < n_valid)
+        {
+          const unsigned int hid = hid_packet + i;
+          ray_origs_s[i] = model.getOrigin(vid, hid);
+          ray_dirs_s[i] = model.getDirection(vid, hid);
+
+          const Vector ray_orig_m = Tsm * ray_origs_s[i];
+          const Vector ray_dir_m = Tsm.R * ray_dirs_s[i];
+
+          valid[i] = -1;
+          rayhit.ray.org_x[i] = ray_orig_m.x;
+          rayhit.ray.org_y[i] = ray_orig_m.y;
+          rayhit.ray.org_z[i] = ray_orig_m.z;
+          rayhit.ray.dir_x[i] = ray_dir_m.x;
+          rayhit.ray.dir_y[i] = ray_dir_m.y;
+          rayhit.ray.dir_z[i] = ray_dir_m.z;
+          rayhit.ray.tnear[i] = 0;
+          rayhit.ray.tfar[i] = model.range.max;
+          rayhit.ray.mask[i] = -1;
+          rayhit.ray.flags[i] = 0;
+          rayhit.ray.time[i] = 0.0;
+          rayhit.hit.geomID[i] = RTC_INVALID_GEOMETRY_ID;
+          rayhit.hit.instID[0][i] = RTC_INVALID_GEOMETRY_ID;
+        } else {
+          valid[i] = 0;
+        }
+      }
+
+      RayHitN::intersect(valid, scene, &rayhit);
+
+      for(unsigned int i = 0; i < n_valid; i++)
+      {
+        if(rayhit.hit.geomID[i] != RTC_INVALID_GEOMETRY_ID)
+        {
+          on_hit(hid_packet + i, ray_origs_s[i], ray_dirs_s[i],
+            rayhit.ray.tfar[i],
+            Vector{rayhit.hit.Ng_x[i], rayhit.hit.Ng_y[i], rayhit.hit.Ng_z[i]},
+            rayhit.hit.primID[i], rayhit.hit.geomID[i], rayhit.hit.instID[0][i]);
+        } else {
+          on_miss(hid_packet + i);
+        }
+      }
+    }
+  }
+}
+
+template<unsigned int N, typename ModelT, typename BundleT>
+void SimulatorEmbree::occludeRow_(
+  const ModelT& model,
+  const Transform& Tsm,
+  const unsigned int glob_shift,
+  const unsigned int vid,
+  const unsigned int hid_begin,
+  const unsigned int hid_end,
+  BundleT& ret) const
+{
+  using MemT = bundle_host_memory_t<BundleT>;
+  RTCScene scene = m_map->scene->handle();
+
+  // rtcOccluded sets tfar to -inf if an intersection was found
+  if constexpr(N == 1)
+  {
+    for(unsigned int hid = hid_begin; hid < hid_end; hid++)
+    {
+      const Vector ray_orig_m = Tsm * model.getOrigin(vid, hid);
+      const Vector ray_dir_m = Tsm.R * model.getDirection(vid, hid);
+
+      RTCRay ray;
+      ray.org_x = ray_orig_m.x;
+      ray.org_y = ray_orig_m.y;
+      ray.org_z = ray_orig_m.z;
+      ray.dir_x = ray_dir_m.x;
+      ray.dir_y = ray_dir_m.y;
+      ray.dir_z = ray_dir_m.z;
+      ray.tnear = model.range.min;
+      ray.tfar = model.range.max;
+      ray.mask = -1;
+      ray.flags = 0;
+      ray.time = 0.0;
+
+      rtcOccluded1(scene, &ray);
+
+      const unsigned int glob_id = glob_shift + model.getBufferId(vid, hid);
+      ret.Hits<MemT>::hits[glob_id] = (ray.tfar < 0.0);
+    }
+  } else {
+    using RayHitN = EmbreeRayHitN<N>;
+
+    for(unsigned int hid_packet = hid_begin; hid_packet < hid_end; hid_packet += N)
+    {
+      const unsigned int n_valid = std::min(N, hid_end - hid_packet);
+
+      alignas(64) int valid[N];
+      typename RayHitN::RayType ray;
+
+      for(unsigned int i = 0; i < N; i++)
+      {
+        if(i < n_valid)
+        {
+          const unsigned int hid = hid_packet + i;
+          const Vector ray_orig_m = Tsm * model.getOrigin(vid, hid);
+          const Vector ray_dir_m = Tsm.R * model.getDirection(vid, hid);
+
+          valid[i] = -1;
+          ray.org_x[i] = ray_orig_m.x;
+          ray.org_y[i] = ray_orig_m.y;
+          ray.org_z[i] = ray_orig_m.z;
+          ray.dir_x[i] = ray_dir_m.x;
+          ray.dir_y[i] = ray_dir_m.y;
+          ray.dir_z[i] = ray_dir_m.z;
+          ray.tnear[i] = model.range.min;
+          ray.tfar[i] = model.range.max;
+          ray.mask[i] = -1;
+          ray.flags[i] = 0;
+          ray.time[i] = 0.0;
+        } else {
+          valid[i] = 0;
+        }
+      }
+
+      RayHitN::occluded(valid, scene, &ray);
+
+      for(unsigned int i = 0; i < n_valid; i++)
+      {
+        const unsigned int glob_id = glob_shift + model.getBufferId(vid, hid_packet + i);
+        ret.Hits<MemT>::hits[glob_id] = (ray.tfar[i] < 0.0);
+      }
+    }
+  }
+}
+
+} // namespace rmagine
@@ -44,6 +44,7 @@
 
 #include <rmagine/map/EmbreeMap.hpp>
 #include <rmagine/types/Memory.hpp>
+#include <rmagine/types/MemoryPooled.hpp>
 #include <rmagine/types/sensor_models.h>
 #include <rmagine/simulation/SimulationResults.hpp>
 
@@ -154,8 +155,85 @@ public:
   template<typename BundleT>
   BundleT simulate(const MemoryView<const Transform, RAM>& Tbm) const;
 
+  /**
+   * @brief Enqueue a simulation for multiple poses and return immediately.
+   * The poses are copied, ret must stay alive until the future is ready.
+   * Can be called from several threads. The model, map and Tsb 
+   * must not be changed while simulations are in flight.
+   * 
+   * @tparam BundleT 
+   * @param Tbm 
+   * @param ret 
+   * @return future that is ready once ret is filled
+   */
+  template<typename BundleT>
+  std::future<void> simulateAsync(
+      const MemoryView<Transform, RAM>& Tbm,
+      BundleT& ret) const;
+
+  template<typename BundleT>
+  std::future<void> simulateAsync(
+      const MemoryView<const Transform, RAM>& Tbm,
+      BundleT& ret) const;
+
+  /**
+   * @brief Enqueue a simulation that writes to a buffer of the pool. 
+   * Blocks until the pool has a free buffer.
+   * 
+   * @return future to the filled buffer. The buffer returns to the pool 
+   * once every copy of the handle is released
+   */
+  template<typename BundleT, typename MemT>
+  std::future<std::shared_ptr<BundleT> > simulateAsync(
+      const MemoryView<Transform, RAM>& Tbm,
+      BundlePool<BundleT, MemT>& pool) const;
+
+  template<typename BundleT, typename MemT>
+  std::future<std::shared_ptr<BundleT> > simulateAsync(
+      const MemoryView<const Transform, RAM>& Tbm,
+      BundlePool<BundleT, MemT>& pool) const;
+
+  /**
+   * @brief Cast the rays at pose Tbm and reduce them directly with the 
+   * dataset to point to point statistics. Gives the same result as
+   * 
+   * @code{cpp}
+   * model = simulate<Bundle<Hits<RAM>, Points<RAM> > >(Tbm);
+   * stats = statistics_p2p(pre_transform, dataset, {model.points, model.hits}, params);
+   * @endcode
+   * 
+   * without allocating the model.
+   * 
+   * @param Tbm            pose to cast the rays from
+   * @param pre_transform  applied to the dataset points before reduction
+   * @param dataset        one point per ray, in sensor frame, ordered like the simulation results
+   * @param params         max_dist, dataset_id (if dataset.ids are set)
+   * @param filter_model_ids  only use hits on object params.model_id (see ObjectIds)
+   */
+  CrossStatistics statisticsP2P(
+      const Transform& Tbm,
+      const Transform& pre_transform,
+      const PointCloudView_<RAM>& dataset,
+      const UmeyamaReductionConstraints& params,
+      const bool filter_model_ids = false) const;
+
+  /**
+   * @brief Same as statisticsP2P for point to plane statistics (statistics_p2l)
+   */
+  CrossStatistics statisticsP2L(
+      const Transform& Tbm,
+      const Transform& pre_transform,
+      const PointCloudView_<RAM>& dataset,
+      const UmeyamaReductionConstraints& params,
+      const bool filter_model_ids = false) const;
+
 protected:
   Memory<SphericalModel, RAM> m_model;
+
+  // ray directions of m_model precomputed by setModel.
+  // Saves the per-ray direction computation for every pose.
+  // 64 byte aligned: read by every ray of every pose
+  O1DnModel_<RAM_POOLED> m_model_dirs;
 };
 
 using SphereSimulatorEmbreePtr = std::shared_ptr<SphereSimulatorEmbree>;
@@ -3,9 +3,17 @@
 
 
 #include <rmagine/types/Memory.hpp>
+#include <rmagine/types/MemoryPooled.hpp>
+#include <rmagine/types/MemoryHuge.hpp>
+#include <rmagine/types/sensor_models.h>
+#include <rmagine/simulation/SimulationResults.hpp>
+#include <limits>
+#include <type_traits>
 // ?
 // #include <rmagine/types/MemoryCuda.hpp>
 
+#include <embree4/rtcore.h>
+
 namespace rmagine
 {
 
@@ -15,6 +23,8 @@ struct SimulationFlags
     bool ranges;
     bool points;
     bool normals;
+    bool points_soa;
+    bool normals_soa;
     bool object_ids;
     bool geom_ids;
     bool face_ids;
@@ -27,6 +37,8 @@ struct SimulationFlags
         flags.ranges = false;
         flags.points = false;
         flags.normals = false;
+        flags.points_soa = false;
+        flags.normals_soa = false;
         flags.object_ids = false;
         flags.geom_ids = false;
         flags.face_ids = false;
@@ -59,6 +71,16 @@ static void set_simulation_flags_(
         flags.normals = true;
     }
 
+    if constexpr(BundleT::template has<PointsSoA<MemT> >())
+    {
+        flags.points_soa = true;
+    }
+
+    if constexpr(BundleT::template has<NormalsSoA<MemT> >())
+    {
+        flags.normals_soa = true;
+    }
+
     if constexpr(BundleT::template has<FaceIds<MemT> >())
     {
         flags.face_ids = true;
@@ -113,6 +135,22 @@ static void set_simulation_flags_(
         }
     }
 
+    if constexpr(BundleT::template has<PointsSoA<MemT> >())
+    {
+        if(res.PointsSoA<MemT>::points_soa.size() > 0)
+        {
+            flags.points_soa = true;
+        }
+    }
+
+    if constexpr(BundleT::template has<NormalsSoA<MemT> >())
+    {
+        if(res.NormalsSoA<MemT>::normals_soa.size() > 0)
+        {
+            flags.normals_soa = true;
+        }
+    }
+
     if constexpr(BundleT::template has<FaceIds<MemT> >())
     {
         if(res.FaceIds<MemT>::face_ids.size() > 0)
@@ -139,8 +177,336 @@ static void set_simulation_flags_(
 }
 
 
+/**
+ * @brief True if the bundle contains any simulation result stored in MemT
+ */
+template<typename BundleT, typename MemT>
+static constexpr bool bundle_has_memory_()
+{
+    return BundleT::template has<Hits<MemT> >()
+        || BundleT::template has<Ranges<MemT> >()
+        || BundleT::template has<Points<MemT> >()
+        || BundleT::template has<Normals<MemT> >()
+        || BundleT::template has<PointsSoA<MemT> >()
+        || BundleT::template has<NormalsSoA<MemT> >()
+        || BundleT::template has<FaceIds<MemT> >()
+        || BundleT::template has<GeomIds<MemT> >()
+        || BundleT::template has<ObjectIds<MemT> >();
+}
+
+/**
+ * @brief Host memory type the Embree simulators write to: RAM_POOLED or 
+ * RAM_HUGE if the bundle stores its results there, RAM otherwise. 
+ * All elements of a bundle have to use the same host memory type
+ */
+template<typename BundleT>
+using bundle_host_memory_t = std::conditional_t<
+    bundle_has_memory_<BundleT, RAM_POOLED>(), RAM_POOLED, 
+    std::conditional_t<
+        bundle_has_memory_<BundleT, RAM_HUGE>(), RAM_HUGE, RAM> >;
+
+/**
+ * @brief True if the bundle requests nothing but Hits. 
+ * Then the simulation only needs occlusion tests instead of full intersections
+ */
+template<typename BundleT>
+static constexpr bool is_hits_only_()
+{
+    return BundleT::N == 1 && BundleT::template has<Hits<bundle_host_memory_t<BundleT> > >();
+}
+
+/**
+ * @brief Maps a packet size N to the matching Embree ray packet types 
+ * and intersection/occlusion functions
+ */
+template<unsigned int N>
+struct EmbreeRayHitN;
+
+template<>
+struct EmbreeRayHitN<4>
+{
+    using Type = RTCRayHit4;
+    using RayType = RTCRay4;
+
+    static inline void intersect(const int* valid, RTCScene scene, Type* rayhit)
+    {
+        rtcIntersect4(valid, scene, rayhit);
+    }
+
+    static inline void occluded(const int* valid, RTCScene scene, RayType* ray)
+    {
+        rtcOccluded4(valid, scene, ray);
+    }
+};
+
+template<>
+struct EmbreeRayHitN<8>
+{
+    using Type = RTCRayHit8;
+    using RayType = RTCRay8;
+
+    static inline void intersect(const int* valid, RTCScene scene, Type* rayhit)
+    {
+        rtcIntersect8(valid, scene, rayhit);
+    }
+
+    static inline void occluded(const int* valid, RTCScene scene, RayType* ray)
+    {
+        rtcOccluded8(valid, scene, ray);
+    }
+};
+
+template<>
+struct EmbreeRayHitN<16>
+{
+    using Type = RTCRayHit16;
+    using RayType = RTCRay16;
+
+    static inline void intersect(const int* valid, RTCScene scene, Type* rayhit)
+    {
+        rtcIntersect16(valid, scene, rayhit);
+    }
+
+    static inline void occluded(const int* valid, RTCScene scene, RayType* ray)
+    {
+        rtcOccluded16(valid, scene, ray);
+    }
+};
+
+/**
+ * @brief Geometric normal of a hit in sensor frame, facing the ray origin
+ */
+inline Vector hit_normal_(
+    const Transform& Tms,
+    const Vector& Ng,
+    const Vector& ray_dir_s)
+{
+    // nint in map frame
+    Vector nint = Ng.normalize();
+    // nint in sensor frame
+    nint = Tms.R * nint;
+
+    // flip?
+    if(ray_dir_s.dot(nint) > 0.0)
+    {
+        nint *= -1.0;
+    }
+
+    return nint.normalize();
+}
+
+/**
+ * @brief Write the attributes of one intersection to the result bundle
+ * 
+ * @param ray_orig_s  ray origin in sensor frame
+ * @param ray_dir_s   ray direction in sensor frame
+ * @param Tms         transform from map to sensor frame
+ * @param range       sensor range. Hits outside of it are marked as invalid
+ * @param tfar        distance to intersection
+ * @param Ng          unnormalized geometry normal in map frame
+ */
+template<typename BundleT>
+inline void write_hit_(
+    BundleT& ret,
+    const SimulationFlags& flags,
+    const unsigned int glob_id,
+    const Vector& ray_orig_s,
+    const Vector& ray_dir_s,
+    const Transform& Tms,
+    const Interval& range,
+    const float tfar,
+    const Vector& Ng,
+    const unsigned int prim_id,
+    const unsigned int geom_id,
+    const unsigned int inst_id)
+{
+    using MemT = bundle_host_memory_t<BundleT>;
+
+    if constexpr(BundleT::template has<Hits<MemT> >())
+    {
+        if(flags.hits)
+        {
+            // tfar can leave the range if noise was applied
+            if(range.inside(tfar))
+            {
+                ret.Hits<MemT>::hits[glob_id] = 1;
+            } else {
+                ret.Hits<MemT>::hits[glob_id] = 0;
+            }
+        }
+    }
+
+    if constexpr(BundleT::template has<Ranges<MemT> >())
+    {
+        if(flags.ranges)
+        {
+            ret.Ranges<MemT>::ranges[glob_id] = tfar;
+        }
+    }
+
+    if constexpr(BundleT::template has<Points<MemT> >())
+    {
+        if(flags.points)
+        {
+            ret.Points<MemT>::points[glob_id] = ray_dir_s * tfar + ray_orig_s;
+        }
+    }
+
+    if constexpr(BundleT::template has<Normals<MemT> >())
+    {
+        if(flags.normals)
+        {
+            ret.Normals<MemT>::normals[glob_id] = hit_normal_(Tms, Ng, ray_dir_s);
+        }
+    }
+
+    if constexpr(BundleT::template has<PointsSoA<MemT> >())
+    {
+        if(flags.points_soa)
+        {
+            const Vector p = ray_dir_s * tfar + ray_orig_s;
+            ret.PointsSoA<MemT>::points_soa.x[glob_id] = p.x;
+            ret.PointsSoA<MemT>::points_soa.y[glob_id] = p.y;
+            ret.PointsSoA<MemT>::points_soa.z[glob_id] = p.z;
+        }
+    }
+
+    if constexpr(BundleT::template has<NormalsSoA<MemT> >())
+    {
+        if(flags.normals_soa)
+        {
+            const Vector n = hit_normal_(Tms, Ng, ray_dir_s);
+            ret.NormalsSoA<MemT>::normals_soa.x[glob_id] = n.x;
+            ret.NormalsSoA<MemT>::normals_soa.y[glob_id] = n.y;
+            ret.NormalsSoA<MemT>::normals_soa.z[glob_id] = n.z;
+        }
+    }
+
+    if constexpr(BundleT::template has<FaceIds<MemT> >())
+    {
+        if(flags.face_ids)
+        {
+            ret.FaceIds<MemT>::face_ids[glob_id] = prim_id;
+        }
+    }
+
+    if constexpr(BundleT::template has<GeomIds<MemT> >())
+    {
+        if(flags.geom_ids)
+        {
+            ret.GeomIds<MemT>::geom_ids[glob_id] = geom_id;
+        }
+    }
+
+    if constexpr(BundleT::template has<ObjectIds<MemT> >())
+    {
+        if(flags.object_ids)
+        {
+            if(inst_id != RTC_INVALID_GEOMETRY_ID)
+            {
+                ret.ObjectIds<MemT>::object_ids[glob_id] = inst_id;
+            } else {
+                ret.ObjectIds<MemT>::object_ids[glob_id] = geom_id;
+            }
+        }
+    }
+}
+
+/**
+ * @brief Write invalid values to the result bundle for a ray that hit nothing
+ */
+template<typename BundleT>
+inline void write_miss_(
+    BundleT& ret,
+    const SimulationFlags& flags,
+    const unsigned int glob_id,
+    const Interval& range)
+{
+    using MemT = bundle_host_memory_t<BundleT>;
+
+    if constexpr(BundleT::template has<Hits<MemT> >())
+    {
+        if(flags.hits)
+        {
+            ret.Hits<MemT>::hits[glob_id] = 0;
+        }
+    }
+
+    if constexpr(BundleT::template has<Ranges<MemT> >())
+    {
+        if(flags.ranges)
+        {
+            ret.Ranges<MemT>::ranges[glob_id] = range.max + 1.0;
+        }
+    }
+
+    if constexpr(BundleT::template has<Points<MemT> >())
+    {
+        if(flags.points)
+        {
+            ret.Points<MemT>::points[glob_id].x = std::numeric_limits<float>::quiet_NaN();
+            ret.Points<MemT>::points[glob_id].y = std::numeric_limits<float>::quiet_NaN();
+            ret.Points<MemT>::points[glob_id].z = std::numeric_limits<float>::quiet_NaN();
+        }
+    }
+
+    if constexpr(BundleT::template has<Normals<MemT> >())
+    {
+        if(flags.normals)
+        {
+            ret.Normals<MemT>::normals[glob_id].x = std::numeric_limits<float>::quiet_NaN();
+            ret.Normals<MemT>::normals[glob_id].y = std::numeric_limits<float>::quiet_NaN();
+            ret.Normals<MemT>::normals[glob_id].z = std::numeric_limits<float>::quiet_NaN();
+        }
+    }
+
+    if constexpr(BundleT::template has<PointsSoA<MemT> >())
+    {
+        if(flags.points_soa)
+        {
+            ret.PointsSoA<MemT>::points_soa.x[glob_id] = std::numeric_limits<float>::quiet_NaN();
+            ret.PointsSoA<MemT>::points_soa.y[glob_id] = std::numeric_limits<float>::quiet_NaN();
+            ret.PointsSoA<MemT>::points_soa.z[glob_id] = std::numeric_limits<float>::quiet_NaN();
+        }
+    }
+
+    if constexpr(BundleT::template has<NormalsSoA<MemT> >())
+    {
+        if(flags.normals_soa)
+        {
+            ret.NormalsSoA<MemT>::normals_soa.x[glob_id] = std::numeric_limits<float>::quiet_NaN();
+            ret.NormalsSoA<MemT>::normals_soa.y[glob_id] = std::numeric_limits<float>::quiet_NaN();
+            ret.NormalsSoA<MemT>::normals_soa.z[glob_id] = std::numeric_limits<float>::quiet_NaN();
+        }
+    }
+
+    if constexpr(BundleT::template has<FaceIds<MemT> >())
+    {
+        if(flags.face_ids)
+        {
+            ret.FaceIds<MemT>::face_ids[glob_id] = std::numeric_limits<unsigned int>::max();
+        }
+    }
+
+    if constexpr(BundleT::template has<GeomIds<MemT> >())
+    {
+        if(flags.geom_ids)
+        {
+            ret.GeomIds<MemT>::geom_ids[glob_id] = std::numeric_limits<unsigned int>::max();
+        }
+    }
+
+    if constexpr(BundleT::template has<ObjectIds<MemT> >())
+    {
+        if(flags.object_ids)
+        {
+            ret.ObjectIds<MemT>::object_ids[glob_id] = std::numeric_limits<unsigned int>::max();
+        }
+    }
+}
 
 } // namespace rmagine
 
 
+
 #endif // RMAGINE_SIMULATION_EMBREE_COMMON_H
\ No newline at end of file
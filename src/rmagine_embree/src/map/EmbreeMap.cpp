@@ -37,4 +37,19 @@ EmbreeClosestPointResult EmbreeMap::closestPoint(
   return this->scene->closestPoint(qp, max_distance);
 }
 
+Memory<EmbreeClosestPointResult, RAM> EmbreeMap::closestPoints(
+  const MemoryView<const Point, RAM>& qps,
+  const float& max_distance) const
+{
+  return this->scene->closestPoints(qps, max_distance);
+}
+
+Memory<EmbreeClosestPointResult, RAM> EmbreeMap::closestPoints(
+  const MemoryView<Point, RAM>& qps,
+  const float& max_distance) const
+{
+  const MemoryView<const Point, RAM> qps_const(qps.raw(), qps.size());
+  return closestPoints(qps_const, max_distance);
+}
+
 } // namespace rmagine
\ No newline at end of file
@@ -1,9 +1,11 @@
 #include "rmagine/map/embree/EmbreeDevice.hpp"
+#include <rmagine/util/exceptions.h>
 
 #include <iostream>
 #include <cassert>
 #include <sstream>
 #include <stdexcept>
+#include <mutex>
 
 #include <embree4/rtcore.h>
 
@@ -18,19 +20,87 @@ void errorFunction(void* userPtr, enum RTCError error, const char* str)
   throw std::runtime_error(ss.str());
 }
 
+struct EmbreeMemoryMonitor
+{
+  static bool call(void* ptr, ssize_t bytes, bool /*post*/)
+  {
+    static_cast<EmbreeDevice*>(ptr)->trackBytes(bytes);
+    // never cancel the operation
+    return true;
+  }
+};
+
+std::string EmbreeDeviceSettings::toConfigString() const
+{
+  std::stringstream ss;
+  std::string sep = "";
+
+  if(threads > 0)
+  {
+    ss << sep << "threads=" << threads;
+    sep = ",";
+  }
+
+  if(!isa.empty())
+  {
+    ss << sep << "isa=" << isa;
+    sep = ",";
+  }
+
+  if(set_affinity)
+  {
+    ss << sep << "set_affinity=1";
+    sep = ",";
+  }
+
+  if(!frequency_level.empty())
+  {
+    ss << sep << "frequency_level=" << frequency_level;
+    sep = ",";
+  }
+
+  if(!config.empty())
+  {
+    ss << sep << config;
+  }
+
+  return ss.str();
+}
+
 /////////////////
 // EmbreeDevice
 /////////////////
 EmbreeDevice::EmbreeDevice()
+:EmbreeDevice(EmbreeDeviceSettings())
 {
-  m_device = rtcNewDevice(NULL);
+  
+}
+
+EmbreeDevice::EmbreeDevice(const EmbreeDeviceSettings& settings)
+:m_settings(settings)
+{
+  const std::string config = settings.toConfigString();
+  m_device = rtcNewDevice(config.empty() ? NULL : config.c_str());
 
   if (!m_device)
   {
-    std::cerr << "error " << rtcGetDeviceError(NULL) << ": cannot create device" << std::endl;
+    std::stringstream ss;
+    ss << "Cannot create device with config '" << config << "'. Error " << rtcGetDeviceError(NULL);
+    RM_THROW(EmbreeException, ss.str());
   }
 
   rtcSetDeviceErrorFunction(m_device, errorFunction, NULL);
+  rtcSetDeviceMemoryMonitorFunction(m_device, EmbreeMemoryMonitor::call, this);
+
+  m_native_packet_size = 1;
+  if(rtcGetDeviceProperty(m_device, RTC_DEVICE_PROPERTY_NATIVE_RAY16_SUPPORTED))
+  {
+    m_native_packet_size = 16;
+  } else if(rtcGetDeviceProperty(m_device, RTC_DEVICE_PROPERTY_NATIVE_RAY8_SUPPORTED)) {
+    m_native_packet_size = 8;
+  } else if(rtcGetDeviceProperty(m_device, RTC_DEVICE_PROPERTY_NATIVE_RAY4_SUPPORTED)) {
+    m_native_packet_size = 4;
+  }
 }
 
 EmbreeDevice::~EmbreeDevice()
@@ -44,16 +114,66 @@ RTCDevice EmbreeDevice::handle()
   return m_device;
 }
 
-EmbreeDevicePtr em_def_dev(new EmbreeDevice);
+unsigned int EmbreeDevice::nativePacketSize() const
+{
+  return m_native_packet_size;
+}
+
+void EmbreeDevice::trackBytes(int64_t bytes)
+{
+  const int64_t current = m_bytes.fetch_add(bytes) + bytes;
+
+  int64_t peak = m_bytes_peak.load();
+  while(current > peak && !m_bytes_peak.compare_exchange_weak(peak, current))
+  {
+    // peak was updated by another thread
+  }
+}
+
+size_t EmbreeDevice::bytes() const
+{
+  const int64_t bytes = m_bytes.load();
+  return (bytes > 0) ? bytes : 0;
+}
+
+size_t EmbreeDevice::bytesPeak() const
+{
+  return m_bytes_peak.load();
+}
+
+void EmbreeDevice::resetBytesPeak()
+{
+  m_bytes_peak = m_bytes.load();
+}
+
+std::mutex em_def_dev_mutex;
+EmbreeDeviceSettings em_def_dev_settings;
+EmbreeDevicePtr em_def_dev;
 
 EmbreeDevicePtr embree_default_device()
 {
+  std::lock_guard<std::mutex> lock(em_def_dev_mutex);
+  if(!em_def_dev)
+  {
+    em_def_dev = std::make_shared<EmbreeDevice>(em_def_dev_settings);
+  }
   return em_def_dev;
 }
 
 void embree_default_device_reset()
 {
+  std::lock_guard<std::mutex> lock(em_def_dev_mutex);
   em_def_dev.reset();
 }
 
+void embree_default_device_configure(const EmbreeDeviceSettings& settings)
+{
+  std::lock_guard<std::mutex> lock(em_def_dev_mutex);
+  em_def_dev_settings = settings;
+  if(em_def_dev)
+  {
+    em_def_dev = std::make_shared<EmbreeDevice>(em_def_dev_settings);
+  }
+}
+
 } // namespace mamcl
\ No newline at end of file
@@ -13,6 +13,14 @@
 
 #include <embree4/rtcore.h>
 #include <rmagine/math/assimp_conversions.h>
+#include <rmagine/types/Memory.hpp>
+#include <rmagine/math/simd.h>
+
+#include <tbb/parallel_for.h>
+#include <tbb/blocked_range.h>
+
+// elements per task of the per-vertex and per-face loops
+#define RMAGINE_EMBREE_MESH_BLOCK_SIZE 4096
 
 
 
@@ -79,6 +87,76 @@ Point closestPointTriangle(
 }
 
 
+// Embree stores instance transforms as column major 4x4 matrices
+inline Vector xfmPoint(const float* M, const Vector& p)
+{
+  return {
+    M[0] * p.x + M[4] * p.y + M[8]  * p.z + M[12],
+    M[1] * p.x + M[5] * p.y + M[9]  * p.z + M[13],
+    M[2] * p.x + M[6] * p.y + M[10] * p.z + M[14]
+  };
+}
+
+// transforms a normal with the transposed inverse: 
+// M has to be the inverse (world2inst) of the transform that is applied to points
+inline Vector xfmNormal(const float* M, const Vector& n)
+{
+  return {
+    M[0] * n.x + M[1] * n.y + M[2]  * n.z,
+    M[4] * n.x + M[5] * n.y + M[6]  * n.z,
+    M[8] * n.x + M[9] * n.y + M[10] * n.z
+  };
+}
+
+inline bool is_identity(const Transform& T, const Vector3& S)
+{
+    return T.t.x == 0.0 && T.t.y == 0.0 && T.t.z == 0.0
+        && T.R.x == 0.0 && T.R.y == 0.0 && T.R.z == 0.0
+        && S.x == 1.0 && S.y == 1.0 && S.z == 1.0;
+}
+
+// frees the buffer: moved into a temporary
+template<typename DataT>
+void free_memory(Memory<DataT, RAM>& mem)
+{
+    Memory<DataT, RAM> tmp(std::move(mem));
+}
+
+static void compute_face_normals(
+    const MemoryView<Vertex, RAM>& vertices,
+    const MemoryView<Face, RAM>& faces,
+    MemoryView<Vector, RAM>& face_normals)
+{
+    tbb::parallel_for(tbb::blocked_range<size_t>(0, faces.size(), RMAGINE_EMBREE_MESH_BLOCK_SIZE),
+        [&](const tbb::blocked_range<size_t>& r)
+    {
+        for(size_t i=r.begin(); i<r.end(); i++)
+        {
+            const Vector v0 = vertices[faces[i].v0];
+            const Vector v1 = vertices[faces[i].v1];
+            const Vector v2 = vertices[faces[i].v2];
+            face_normals[i] = (v1 - v0).normalize().cross((v2 - v0).normalize() ).normalize();
+        }
+    });
+}
+
+// out[i] = R * normalize(S * in[i])
+static void transform_normals(
+    const Matrix3x3& R,
+    const Vector3& S,
+    const MemoryView<Vector, RAM>& in,
+    MemoryView<Vector, RAM>& out)
+{
+    tbb::parallel_for(tbb::blocked_range<size_t>(0, in.size(), RMAGINE_EMBREE_MESH_BLOCK_SIZE),
+        [&](const tbb::blocked_range<size_t>& r)
+    {
+        for(size_t i=r.begin(); i<r.end(); i++)
+        {
+            out[i] = R * in[i].multEwise(S).normalize();
+        }
+    });
+}
+
 bool closestPointFunc(RTCPointQueryFunctionArguments* args)
 {
     assert(args->userPtr);
@@ -92,21 +170,47 @@ bool closestPointFunc(RTCPointQueryFunctionArguments* args)
     EmbreePointQueryUserData* userData = (EmbreePointQueryUserData*)args->userPtr;
 
     // query position in world space
-    const Vector q{args->query->x, args->query->y, args->query->z};
+    Vector q{args->query->x, args->query->y, args->query->z};
 
     /*
-    * Get triangle information in global space
+    * Find the mesh by following the instance stack from the top-level scene
     */
     const EmbreeScene* scene = userData->scene;
-    const EmbreeMeshPtr mesh = scene->getAs<EmbreeMesh>(geomID);
+    for(unsigned int i=0; i<stackSize && scene; i++)
+    {
+        const EmbreeInstance* inst = scene->instanceRaw(context->instID[i]);
+        scene = (inst ? inst->sceneRaw() : nullptr);
+    }
+
+    if(!scene)
+    {
+        return false;
+    }
+
+    const EmbreeMesh* mesh = scene->meshRaw(geomID);
     
     // Alex: I assume it can never happen that it is no mesh since the function is only used for point queries in meshes
     const Face face = mesh->faces()[primID];
-    const Vector face_normal = mesh->faceNormalsTransformed()[primID];
 
-    const Vertex v0 = mesh->verticesTransformed()[face.v0];
-    const Vertex v1 = mesh->verticesTransformed()[face.v1];
-    const Vertex v2 = mesh->verticesTransformed()[face.v2];
+    Vertex v0 = mesh->verticesTransformed()[face.v0];
+    Vertex v1 = mesh->verticesTransformed()[face.v1];
+    Vertex v2 = mesh->verticesTransformed()[face.v2];
+
+    /*
+    * Bring query and triangle into the same space
+    */
+    if(stackSize > 0 && args->similarityScale > 0)
+    {
+        // similarity transform: distances can be computed in instance space. 
+        // The query radius is already scaled to instance space by embree
+        q = xfmPoint(context->world2inst[stackPtr], q);
+    } else if(stackSize > 0) {
+        // distances are not preserved: compute in world space
+        const float* M = context->inst2world[stackPtr];
+        v0 = xfmPoint(M, v0);
+        v1 = xfmPoint(M, v1);
+        v2 = xfmPoint(M, v2);
+    }
 
     const Vector p = closestPointTriangle(q, v0, v1, v2);
 
@@ -115,13 +219,40 @@ bool closestPointFunc(RTCPointQueryFunctionArguments* args)
     if (d < args->query->radius)
     {
         args->query->radius = d;
-        if(d < userData->result->d)
+
+        // distances of the results are compared in world space
+        const float d_world = (stackSize > 0 && args->similarityScale > 0) ? d / args->similarityScale : d;
+
+        if(d_world < userData->result->d)
         {
-            userData->result->d = d;
+            userData->result->d = d_world;
             userData->result->geomID = geomID;
             userData->result->primID = primID;
-            userData->result->p = p;
-            userData->result->n = face_normal;
+
+            const MemoryView<const Vector, RAM> face_normals = mesh->faceNormalsTransformed();
+            Vector n;
+            if(primID < face_normals.size())
+            {
+                n = face_normals[primID];
+            } else {
+                // compacted mesh: normal from the triangle in mesh space
+                const MemoryView<const Vertex, RAM> vertices = mesh->verticesTransformed();
+                const Vector a = vertices[face.v0];
+                const Vector b = vertices[face.v1];
+                const Vector c = vertices[face.v2];
+                n = (b - a).normalize().cross((c - a).normalize() ).normalize();
+            }
+
+            if(stackSize > 0)
+            {
+                userData->result->instID = context->instID[0];
+                userData->result->p = (args->similarityScale > 0) ? xfmPoint(context->inst2world[stackPtr], p) : p;
+                userData->result->n = xfmNormal(context->world2inst[stackPtr], n).normalize();
+            } else {
+                userData->result->instID = RTC_INVALID_GEOMETRY_ID;
+                userData->result->p = p;
+                userData->result->n = n;
+            }
         }
         return true; // Return true to indicate that the query radius changed.
     }
@@ -154,6 +285,15 @@ EmbreeMesh::EmbreeMesh(
     init(amesh);
 }
 
+EmbreeMesh::EmbreeMesh( 
+    const MapFileMesh& mesh,
+    MapFilePtr file,
+    EmbreeDevicePtr device)
+:EmbreeMesh(device)
+{
+    init(mesh, file);
+}
+
 EmbreeMesh::~EmbreeMesh()
 {
     // std::cout << "[EmbreeMesh::~EmbreeMesh()] destroyed." << std::endl;
@@ -164,6 +304,7 @@ void EmbreeMesh::init(
     unsigned int Nfaces)
 {
     // init buffers
+    m_compact = false;
     m_num_vertices = Nvertices;
     m_num_faces = Nfaces;
     m_vertices.resize(Nvertices);
@@ -236,6 +377,125 @@ void EmbreeMesh::init(
     apply();
 }
 
+void EmbreeMesh::init(
+    const MapFileMesh& mesh,
+    MapFilePtr file)
+{
+    m_file = file;
+    // views: constructed, not assigned (assignment copies the data)
+    m_mapped.emplace(mesh);
+    m_num_vertices = mesh.vertices.size();
+    m_num_faces = mesh.faces.size();
+    name = mesh.name;
+
+    // the map file is padded behind every buffer as required by embree
+    rtcSetSharedGeometryBuffer(m_handle,
+                            RTC_BUFFER_TYPE_VERTEX,
+                            0, // slot
+                            RTC_FORMAT_FLOAT3, // RTCFormat
+                            static_cast<const void*>(m_mapped->vertices.raw()), // ptr
+                            0, // byteOffset
+                            sizeof(Vector), // byteStride
+                            m_num_vertices // itemCount
+                            );
+
+    rtcSetSharedGeometryBuffer(m_handle,
+                            RTC_BUFFER_TYPE_INDEX,
+                            0, // slot
+                            RTC_FORMAT_UINT3, // RTCFormat
+                            static_cast<const void*>(m_mapped->faces.raw()), // ptr
+                            0, // byteOffset
+                            sizeof(Face), // byteStride
+                            m_num_faces // itemCount
+                            );
+}
+
+void EmbreeMesh::unmap()
+{
+    const MapFileMesh mapped = *m_mapped;
+    // keeps the mapping alive until the buffers are copied
+    MapFilePtr file = m_file;
+
+    m_file.reset();
+    m_mapped.reset();
+    init(mapped.vertices.size(), mapped.faces.size());
+    copy(mapped.vertices, m_vertices);
+    copy(mapped.faces, m_faces);
+
+    m_face_normals.resize(m_num_faces);
+    copy(mapped.face_normals, m_face_normals);
+
+    if(!mapped.vertex_normals.empty())
+    {
+        initVertexNormals();
+        copy(mapped.vertex_normals, m_vertex_normals);
+    }
+
+    if(anyParentCommittedOnce())
+    {
+        rtcUpdateGeometryBuffer(m_handle, RTC_BUFFER_TYPE_INDEX, 0);
+    }
+}
+
+void EmbreeMesh::compact()
+{
+    if(m_file || m_compact)
+    {
+        // a single buffer already
+        return;
+    }
+
+    // bake the transform
+    copy(m_vertices_transformed, m_vertices);
+    if(m_vertex_normals_transformed.size() == m_vertex_normals.size())
+    {
+        copy(m_vertex_normals_transformed, m_vertex_normals);
+    }
+    m_T.setIdentity();
+    m_S = {1.0, 1.0, 1.0};
+
+    rtcSetSharedGeometryBuffer(m_handle,
+                            RTC_BUFFER_TYPE_VERTEX,
+                            0, // slot
+                            RTC_FORMAT_FLOAT3, // RTCFormat
+                            static_cast<const void*>(m_vertices.raw()), // ptr
+                            0, // byteOffset
+                            sizeof(Vector), // byteStride
+                            m_num_vertices // itemCount
+                            );
+
+    free_memory(m_vertices_transformed);
+    free_memory(m_vertex_normals_transformed);
+    free_memory(m_face_normals);
+    free_memory(m_face_normals_transformed);
+    m_compact = true;
+
+    if(anyParentCommittedOnce())
+    {
+        rtcUpdateGeometryBuffer(m_handle, RTC_BUFFER_TYPE_VERTEX, 0);
+    }
+}
+
+void EmbreeMesh::expand()
+{
+    m_compact = false;
+    m_vertices_transformed.resize(m_num_vertices);
+
+    rtcSetSharedGeometryBuffer(m_handle,
+                            RTC_BUFFER_TYPE_VERTEX,
+                            0, // slot
+                            RTC_FORMAT_FLOAT3, // RTCFormat
+                            static_cast<const void*>(m_vertices_transformed.raw()), // ptr
+                            0, // byteOffset
+                            sizeof(Vector), // byteStride
+                            m_num_vertices // itemCount
+                            );
+
+    // compact() released the face normals. 
+    // Recomputed from the baked vertices: apply() transforms them
+    computeFaceNormals();
+}
+
 void EmbreeMesh::initVertexNormals()
 {
     m_vertex_normals.resize(m_num_vertices);
@@ -244,89 +504,177 @@ void EmbreeMesh::initVertexNormals()
 
 MemoryView<Face, RAM> EmbreeMesh::faces() const
 {
+    if(m_file)
+    {
+        return m_mapped->faces;
+    }
     return m_faces;
 }
 
 MemoryView<Vertex, RAM> EmbreeMesh::vertices() const
 {
+    if(m_file)
+    {
+        return m_mapped->vertices;
+    }
     return m_vertices;
 }
 
 MemoryView<Vector, RAM> EmbreeMesh::vertexNormals() const
 {
+    if(m_file)
+    {
+        return m_mapped->vertex_normals;
+    }
     return m_vertex_normals;
 }
 
 MemoryView<Vector, RAM> EmbreeMesh::faceNormals() const
 {
+    if(m_file)
+    {
+        return m_mapped->face_normals;
+    }
     return m_face_normals;
 }
 
 MemoryView<const Vertex, RAM> EmbreeMesh::verticesTransformed() const
 {
+    if(m_file)
+    {
+        return MemoryView<const Vertex, RAM>(m_mapped->vertices.raw(), m_num_vertices);
+    }
+    if(m_compact)
+    {
+        return MemoryView<const Vertex, RAM>(m_vertices.raw(), m_num_vertices);
+    }
     return MemoryView<const Vertex, RAM>(m_vertices_transformed.raw(), m_num_vertices);
 }
 
 MemoryView<const Vertex, RAM> EmbreeMesh::faceNormalsTransformed() const
 {
-    return MemoryView<const Vertex, RAM>(m_face_normals_transformed.raw(), m_num_faces);
+    if(m_file)
+    {
+        return MemoryView<const Vertex, RAM>(m_mapped->face_normals.raw(), m_mapped->face_normals.size());
+    }
+    if(m_compact)
+    {
+        return MemoryView<const Vertex, RAM>(m_face_normals.raw(), m_face_normals.size());
+    }
+    return MemoryView<const Vertex, RAM>(m_face_normals_transformed.raw(), m_face_normals_transformed.size());
+}
+
+MemoryView<const Vector, RAM> EmbreeMesh::vertexNormalsTransformed() const
+{
+    if(m_file)
+    {
+        return MemoryView<const Vector, RAM>(m_mapped->vertex_normals.raw(), m_mapped->vertex_normals.size());
+    }
+    if(m_compact)
+    {
+        return MemoryView<const Vector, RAM>(m_vertex_normals.raw(), m_vertex_normals.size());
+    }
+    return MemoryView<const Vector, RAM>(m_vertex_normals_transformed.raw(), m_vertex_normals_transformed.size());
+}
+
+size_t EmbreeMesh::bytes() const
+{
+    return m_vertices.size() * sizeof(Vertex)
+        + m_vertices_transformed.size() * sizeof(Vector)
+        + m_faces.size() * sizeof(Face)
+        + m_vertex_normals.size() * sizeof(Vector)
+        + m_vertex_normals_transformed.size() * sizeof(Vector)
+        + m_face_normals.size() * sizeof(Vector)
+        + m_face_normals_transformed.size() * sizeof(Vector);
 }
 
 void EmbreeMesh::computeFaceNormals()
 {
+    if(m_file)
+    {
+        // identity transform: the normals are also the transformed ones
+        MemoryView<Vector, RAM> face_normals = m_mapped->face_normals;
+        compute_face_normals(m_mapped->vertices, m_mapped->faces, face_normals);
+        return;
+    }
+
     if(m_face_normals.size() != m_num_faces)
     {
         m_face_normals.resize(m_num_faces);
     }
 
-    if(m_face_normals_transformed.size() != m_num_faces)
+    // compacted: the vertices are already transformed
+    if(!m_compact && m_face_normals_transformed.size() != m_num_faces)
     {
         m_face_normals_transformed.resize(m_num_faces);
     }
     
-    for(size_t i=0; i<m_num_faces; i++)
-    {
-        const Vector v0 = m_vertices[m_faces[i].v0];
-        const Vector v1 = m_vertices[m_faces[i].v1];
-        const Vector v2 = m_vertices[m_faces[i].v2];
-        Vector n = (v1 - v0).normalize().cross((v2 - v0).normalize() ).normalize();
-        m_face_normals[i] = n;
-    }
+    compute_face_normals(m_vertices, m_faces, m_face_normals);
 }
 
 void EmbreeMesh::apply()
 {
+    if(m_file)
+    {
+        if(is_identity(m_T, m_S))
+        {
+            // the shared buffers are used as they are
+            if(anyParentCommittedOnce())
+            {
+                rtcUpdateGeometryBuffer(m_handle, RTC_BUFFER_TYPE_VERTEX, 0);
+            }
+            return;
+        }
+        unmap();
+    }
+
+    if(m_compact)
+    {
+        if(is_identity(m_T, m_S))
+        {
+            if(anyParentCommittedOnce())
+            {
+                rtcUpdateGeometryBuffer(m_handle, RTC_BUFFER_TYPE_VERTEX, 0);
+            }
+            return;
+        }
+        expand();
+    }
+
+    const Matrix3x3 R = m_T.R;
+
     // TRANSFORM VERTICES
-    for(unsigned int i=0; i<m_num_vertices; i++)
+    // T * (S * v) = (R * diag(S)) * v + t
+    Matrix3x3 RS;
+    for(size_t i=0; i<3; i++)
     {
-        m_vertices_transformed[i] = m_T * (m_vertices[i].multEwise(m_S));
-        // also possible:
-        // m_vertices_transformed[i] = matrix() * m_vertices[i];
-        // might be slower
+        RS(i,0) = R(i,0) * m_S.x;
+        RS(i,1) = R(i,1) * m_S.y;
+        RS(i,2) = R(i,2) * m_S.z;
     }
 
+    tbb::parallel_for(tbb::blocked_range<size_t>(0, m_num_vertices, RMAGINE_EMBREE_MESH_BLOCK_SIZE),
+        [&](const tbb::blocked_range<size_t>& r)
+    {
+        simd::transform_points(RS, m_T.t, 
+            m_vertices.raw() + r.begin(), m_vertices_transformed.raw() + r.begin(), r.size());
+    });
+
     // TRANSFORM FACE NORMALS
     if(m_face_normals_transformed.size() != m_face_normals.size())
     {
         m_face_normals_transformed.resize(m_face_normals.size());
     }
 
-    for(unsigned int i=0; i<m_face_normals.size(); i++)
-    {
-        auto face_normal_scaled = m_face_normals[i].multEwise(m_S);
-        m_face_normals_transformed[i] = m_T.R * face_normal_scaled.normalize();
-    }
+    // normals set by the user are not necessarily unit length: always normalized
+    transform_normals(R, m_S, m_face_normals, m_face_normals_transformed);
 
     // TRANSFORM VERTEX NORMALS
     if(m_vertex_normals_transformed.size() != m_vertex_normals.size())
     {
         m_vertex_normals_transformed.resize(m_vertex_normals.size());
     }
-    for(unsigned int i=0; i<m_vertex_normals.size(); i++)
-    {
-        auto vertex_normal_scaled = m_vertex_normals[i].multEwise(m_S);
-        m_vertex_normals_transformed[i] = m_T.R * vertex_normal_scaled.normalize();
-    }
+    transform_normals(R, m_S, m_vertex_normals, m_vertex_normals_transformed);
 
     if(anyParentCommittedOnce())
     {
@@ -334,4 +682,4 @@ void EmbreeMesh::apply()
     }
 }
 
-} // namespace rmagine
\ No newline at end of file
+} // namespace rmagine
@@ -6,14 +6,23 @@
 #include <iostream>
 
 #include <map>
+#include <functional>
+#include <list>
+#include <unordered_map>
+#include <unordered_set>
 #include <cassert>
 
 #include <rmagine/util/prints.h>
 #include <rmagine/math/assimp_conversions.h>
 #include <rmagine/util/assimp/helper.h>
+#include <rmagine/util/exceptions.h>
+#include <rmagine/util/StopWatch.hpp>
 
 #include <embree4/rtcore.h>
 
+#include <tbb/parallel_for.h>
+#include <tbb/blocked_range.h>
+
 
 namespace rmagine {
 
@@ -24,6 +33,11 @@ EmbreeScene::EmbreeScene(
 ,m_scene(rtcNewScene(device->handle()))
 {
   setQuality(settings.quality);
+  if(settings.compact)
+  {
+    settings.flags = settings.flags | RTC_SCENE_FLAG_COMPACT;
+    m_compact = true;
+  }
   setFlags(settings.flags);
 }
 
@@ -36,6 +50,8 @@ EmbreeScene::~EmbreeScene()
   }
 
   m_geometries.clear();
+  m_mesh_table.clear();
+  m_instance_table.clear();
   m_ids.clear();
 
   rtcReleaseScene(m_scene);
@@ -54,8 +70,37 @@ void EmbreeScene::setFlags(RTCSceneFlags flags)
 unsigned int EmbreeScene::add(EmbreeGeometryPtr geom)
 {
   unsigned int geom_id = rtcAttachGeometry(m_scene, geom->handle());
+  registerGeometry(geom, geom_id);
+  return geom_id;
+}
+
+unsigned int EmbreeScene::add(EmbreeGeometryPtr geom, unsigned int geom_id)
+{
+  if(geom_id == RTC_INVALID_GEOMETRY_ID)
+  {
+    RM_THROW(EmbreeException, "[EmbreeScene::add()] invalid geometry id");
+  }
+  if(has(geom_id))
+  {
+    RM_THROW(EmbreeException, "[EmbreeScene::add()] geometry id " + std::to_string(geom_id) + " already in use");
+  }
+  rtcAttachGeometryByID(m_scene, geom->handle(), geom_id);
+  registerGeometry(geom, geom_id);
+  return geom_id;
+}
+
+void EmbreeScene::registerGeometry(EmbreeGeometryPtr geom, unsigned int geom_id)
+{
   m_geometries[geom_id] = geom;
   m_ids[geom] = geom_id;
+
+  if(geom_id >= m_mesh_table.size())
+  {
+    m_mesh_table.resize(geom_id + 1, nullptr);
+    m_instance_table.resize(geom_id + 1, nullptr);
+  }
+  m_mesh_table[geom_id] = dynamic_cast<const EmbreeMesh*>(geom.get());
+  m_instance_table[geom_id] = dynamic_cast<const EmbreeInstance*>(geom.get());
   
   size_t nparents_before = geom->parents.size();
   geom->parents.insert(weak_from_this());
@@ -65,9 +110,6 @@ unsigned int EmbreeScene::add(EmbreeGeometryPtr geom)
   {
     std::cout << "WARNING geometry seems to be already added before. same number of parents as before: " << nparents_after << std::endl; 
   }
-  
-  // geom->id = geom_id;
-  return geom_id;
 }
 
 std::optional<unsigned int> EmbreeScene::getOpt(
@@ -125,6 +167,8 @@ bool EmbreeScene::remove(EmbreeGeometryPtr geom)
     
     m_geometries.erase(geom_id);
     m_ids.erase(geom);
+    m_mesh_table[geom_id] = nullptr;
+    m_instance_table[geom_id] = nullptr;
     ret = true;
   }
 
@@ -164,6 +208,8 @@ EmbreeGeometryPtr EmbreeScene::remove(const unsigned int geom_id)
     
     m_geometries.erase(geom_id);
     m_ids.erase(geom);
+    m_mesh_table[geom_id] = nullptr;
+    m_instance_table[geom_id] = nullptr;
   }
 
   return geom;
@@ -186,10 +232,27 @@ RTCScene EmbreeScene::handle()
 
 void EmbreeScene::commit()
 {
+  StopWatch sw;
   rtcCommitScene(m_scene);
+  const double el = sw();
+
+  m_commit_stats.commits++;
+  m_commit_stats.last_time = el;
+  m_commit_stats.total_time += el;
+
   m_committed_once = true;
 }
 
+size_t EmbreeScene::bytes() const
+{
+  size_t ret = 0;
+  for(EmbreeGeometryPtr geom : findLeafs())
+  {
+    ret += geom->bytes();
+  }
+  return ret;
+}
+
 EmbreeInstancePtr EmbreeScene::instantiate()
 {
   EmbreeInstancePtr geom_inst = std::make_shared<EmbreeInstance>(m_device);
@@ -266,27 +329,161 @@ void EmbreeScene::freeze()
     }
   }
 
-  // remove all
-  for(auto instance : instances_to_optimize)
+  std::vector<EmbreeMeshPtr> meshes(instances_to_optimize.size());
+  std::unordered_map<EmbreeMeshPtr, size_t> mesh_count;
+  for(size_t i=0; i<instances_to_optimize.size(); i++)
+  {
+    meshes[i] = std::dynamic_pointer_cast<EmbreeMesh>(
+        instances_to_optimize[i]->scene()->geometries().begin()->second);
+    mesh_count[meshes[i]]++;
+  }
+
+  auto transform_mesh = [&](size_t i)
+  {
+    EmbreeInstancePtr instance = instances_to_optimize[i];
+    EmbreeMeshPtr mesh = meshes[i];
+
+    // TODO check if this is correct
+    mesh->setScale(instance->scale().multEwise(mesh->scale()));
+
+    mesh->setTransform(instance->transform() * mesh->transform());
+    mesh->apply();
+    mesh->commit();
+  };
+
+  // transform the meshes in parallel. Meshes that are part of 
+  // several instances are transformed one after another
+  tbb::parallel_for(tbb::blocked_range<size_t>(0, meshes.size()),
+    [&](const tbb::blocked_range<size_t>& r)
+  {
+    for(size_t i=r.begin(); i<r.end(); i++)
+    {
+      if(mesh_count.at(meshes[i]) == 1)
+      {
+        transform_mesh(i);
+      }
+    }
+  });
+
+  for(size_t i=0; i<meshes.size(); i++)
   {
-    unsigned int instance_id = m_ids[instance];
+    if(mesh_count.at(meshes[i]) > 1)
+    {
+      transform_mesh(i);
+    }
+  }
+
+  // replace the instances
+  for(size_t i=0; i<instances_to_optimize.size(); i++)
+  {
+    unsigned int instance_id = m_ids[instances_to_optimize[i]];
     remove(instance_id);
+    add(meshes[i]);
+  }
 
-    EmbreeMeshPtr mesh = std::dynamic_pointer_cast<EmbreeMesh>(
-        instance->scene()->geometries().begin()->second);
+  if(m_compact)
+  {
+    compact();
+  }
+}
 
-    if(mesh)
+void EmbreeScene::compact()
+{
+  std::vector<EmbreeMeshPtr> meshes;
+  for(EmbreeGeometryPtr geom : findLeafs())
+  {
+    if(EmbreeMeshPtr mesh = std::dynamic_pointer_cast<EmbreeMesh>(geom))
     {
-      // TODO check if this is correct
-      mesh->setScale(instance->scale().multEwise(mesh->scale()));
+      meshes.push_back(mesh);
+    }
+  }
 
-      mesh->setTransform(instance->transform() * mesh->transform());
-      mesh->apply();
-      mesh->commit();
+  std::vector<char> compacted(meshes.size(), 0);
+  tbb::parallel_for(tbb::blocked_range<size_t>(0, meshes.size()),
+    [&](const tbb::blocked_range<size_t>& r)
+  {
+    for(size_t i=r.begin(); i<r.end(); i++)
+    {
+      const bool was_compact = meshes[i]->compacted();
+      meshes[i]->compact();
+      meshes[i]->commit();
+      compacted[i] = (!was_compact && meshes[i]->compacted());
+    }
+  });
+
+  // the vertex buffers of the compacted meshes changed: every scene 
+  // above them has to be rebuilt, including scenes outside of this one 
+  // that share a mesh
+  std::unordered_map<EmbreeScene*, EmbreeScenePtr> affected;
+  std::vector<EmbreeScenePtr> stack;
+  for(size_t i=0; i<meshes.size(); i++)
+  {
+    if(!compacted[i])
+    {
+      continue;
+    }
+    for(EmbreeSceneWPtr parent : meshes[i]->parents)
+    {
+      if(EmbreeScenePtr scene = parent.lock())
+      {
+        stack.push_back(scene);
+      }
+    }
+  }
 
-      unsigned int geom_id = add(mesh);
+  while(!stack.empty())
+  {
+    EmbreeScenePtr scene = stack.back();
+    stack.pop_back();
+    if(!affected.emplace(scene.get(), scene).second)
+    {
+      continue;
+    }
+    for(EmbreeInstanceWPtr instance_wptr : scene->parents)
+    {
+      if(EmbreeInstancePtr instance = instance_wptr.lock())
+      {
+        for(EmbreeSceneWPtr parent : instance->parents)
+        {
+          if(EmbreeScenePtr parent_scene = parent.lock())
+          {
+            stack.push_back(parent_scene);
+          }
+        }
+      }
     }
   }
+
+  // instanced scenes are committed before the scenes instancing them. 
+  // Scenes that were never committed are left to the caller
+  std::unordered_set<EmbreeScene*> recommitted;
+  std::function<void(EmbreeScenePtr)> recommit = [&](EmbreeScenePtr scene)
+  {
+    if(!recommitted.insert(scene.get()).second)
+    {
+      return;
+    }
+    for(auto elem : scene->geometries())
+    {
+      if(EmbreeInstancePtr instance = std::dynamic_pointer_cast<EmbreeInstance>(elem.second))
+      {
+        EmbreeScenePtr instance_scene = instance->scene();
+        if(affected.find(instance_scene.get()) != affected.end())
+        {
+          recommit(instance_scene);
+        }
+      }
+    }
+    if(scene->committedOnce())
+    {
+      scene->commit();
+    }
+  };
+
+  for(auto elem : affected)
+  {
+    recommit(elem.second);
+  }
 }
 
 EmbreeClosestPointResult EmbreeScene::closestPoint(
@@ -314,31 +511,81 @@ EmbreeClosestPointResult EmbreeScene::closestPoint(
   return result;
 }
 
+void EmbreeScene::closestPoints(
+    const MemoryView<const Point, RAM>& qps, 
+    MemoryView<EmbreeClosestPointResult, RAM>& res,
+    const float& max_distance) const
+{
+  if(res.size() < qps.size())
+  {
+    RM_THROW(EmbreeException, "[EmbreeScene::closestPoints()] " + std::to_string(qps.size()) 
+      + " query points but only " + std::to_string(res.size()) + " results");
+  }
+
+  tbb::parallel_for(tbb::blocked_range<size_t>(0, qps.size(), 64),
+    [&](const tbb::blocked_range<size_t>& r)
+  {
+    RTCPointQueryContext ctx;
+    RTCPointQuery query;
+    EmbreePointQueryUserData user_data;
+    user_data.scene = this;
+
+    for(size_t i = r.begin(); i < r.end(); i++)
+    {
+      rtcInitPointQueryContext(&ctx);
+      query.x = qps[i].x;
+      query.y = qps[i].y;
+      query.z = qps[i].z;
+      query.radius = max_distance;
+      query.time = 0.0;
+
+      res[i] = EmbreeClosestPointResult();
+      user_data.result = &res[i];
+
+      rtcPointQuery(m_scene, &query, &ctx, nullptr, (void*)&user_data);
+    }
+  });
+}
+
+Memory<EmbreeClosestPointResult, RAM> EmbreeScene::closestPoints(
+    const MemoryView<const Point, RAM>& qps, 
+    const float& max_distance) const
+{
+  Memory<EmbreeClosestPointResult, RAM> res(qps.size());
+  closestPoints(qps, res, max_distance);
+  return res;
+}
+
 EmbreeScenePtr make_embree_scene(
     const aiScene* ascene,
-    EmbreeDevicePtr device)
+    EmbreeDevicePtr device,
+    EmbreeSceneSettings settings)
 {   
-    EmbreeSceneSettings settings = {};
     EmbreeScenePtr scene = std::make_shared<EmbreeScene>(settings, device);
 
-    // std::vector<EmbreeMeshPtr> meshes;
-    std::map<unsigned int, EmbreeMeshPtr> meshes;
-
-    // 1. meshes
-    // std::cout << "[make_embree_scene()] Loading Meshes..." << std::endl;
-    for(size_t i=0; i<ascene->mNumMeshes; i++)
+    // 1. meshes. conversion, normals and geometry commits are independent per mesh
+    std::vector<EmbreeMeshPtr> meshes(ascene->mNumMeshes);
+    tbb::parallel_for(tbb::blocked_range<size_t>(0, ascene->mNumMeshes),
+      [&](const tbb::blocked_range<size_t>& r)
     {
-      // std::cout << "Make Mesh " << i+1 << "/" << ascene->mNumMeshes << std::endl;
-      const aiMesh* amesh = ascene->mMeshes[i];
+      for(size_t i=r.begin(); i<r.end(); i++)
+      {
+        const aiMesh* amesh = ascene->mMeshes[i];
+        if(amesh->mPrimitiveTypes & aiPrimitiveType_TRIANGLE)
+        {
+          // triangle mesh
+          EmbreeMeshPtr mesh = std::make_shared<EmbreeMesh>(amesh, device);
+          mesh->commit();
+          meshes[i] = mesh;
+        }
+      }
+    });
 
-      if(amesh->mPrimitiveTypes & aiPrimitiveType_TRIANGLE)
+    for(size_t i=0; i<meshes.size(); i++)
+    {
+      if(!meshes[i])
       {
-        // triangle mesh
-        EmbreeMeshPtr mesh = std::make_shared<EmbreeMesh>(amesh);
-        mesh->commit();
-        meshes[i] = mesh;
-      } else {
-        std::cout << "[ make_embree_scene(aiScene) ] WARNING: Could not construct geometry " << i << " prim type " << amesh->mPrimitiveTypes << " not supported yet. Skipping." << std::endl;
+        std::cout << "[ make_embree_scene(aiScene) ] WARNING: Could not construct geometry " << i << " prim type " << ascene->mMeshes[i]->mPrimitiveTypes << " not supported yet. Skipping." << std::endl;
       }
     }
 
@@ -348,54 +595,67 @@ EmbreeScenePtr make_embree_scene(
     const aiNode* root_node = ascene->mRootNode;
     std::vector<const aiNode*> mesh_nodes = get_nodes_with_meshes(root_node);
 
-    // std::cout << "[make_embree_scene()] Loading Instances..." << std::endl;
+    // a mesh can be part of several instances: 
+    // adding changes its parents and therefore stays sequential
+    std::vector<EmbreeScenePtr> mesh_scenes(mesh_nodes.size());
     for(size_t i=0; i<mesh_nodes.size(); i++)
     {
       const aiNode* node = mesh_nodes[i];
-      
-      Matrix4x4 M = global_transform(node);
-      Transform T;
-      Vector3 scale;
-      decompose(M, T, scale);
-
-      EmbreeScenePtr mesh_scene = std::make_shared<EmbreeScene>();
-      for(unsigned int i = 0; i<node->mNumMeshes; i++)
+
+      EmbreeScenePtr mesh_scene = std::make_shared<EmbreeScene>(settings, device);
+      for(unsigned int j = 0; j<node->mNumMeshes; j++)
       {
-        unsigned int mesh_id = node->mMeshes[i];
-        auto mesh_it = meshes.find(mesh_id);
-        if(mesh_it != meshes.end())
+        unsigned int mesh_id = node->mMeshes[j];
+        if(mesh_id < meshes.size() && meshes[mesh_id])
         {
           // mesh found
-          EmbreeMeshPtr mesh = mesh_it->second;
+          EmbreeMeshPtr mesh = meshes[mesh_id];
           instanciated_meshes.insert(mesh);
           mesh_scene->add(mesh);
-          mesh_scene->commit();
         } else {
           std::cout << "[make_embree_scene()] WARNING: could not find mesh_id " 
               << mesh_id << " in meshes during instantiation" << std::endl;
         }
       }
+      mesh_scenes[i] = mesh_scene;
+    }
+
+    // the instanced scenes are independent: one BVH build each, in parallel
+    std::vector<EmbreeInstancePtr> mesh_instances(mesh_nodes.size());
+    tbb::parallel_for(tbb::blocked_range<size_t>(0, mesh_nodes.size()),
+      [&](const tbb::blocked_range<size_t>& r)
+    {
+      for(size_t i=r.begin(); i<r.end(); i++)
+      {
+        const aiNode* node = mesh_nodes[i];
+
+        Matrix4x4 M = global_transform(node);
+        Transform T;
+        Vector3 scale;
+        decompose(M, T, scale);
+
+        mesh_scenes[i]->commit();
+
+        EmbreeInstancePtr mesh_instance = std::make_shared<EmbreeInstance>(device);
+        mesh_instance->set(mesh_scenes[i]);
+        mesh_instance->name = node->mName.C_Str();
+        mesh_instance->setTransform(T);
+        mesh_instance->setScale(scale);
+        mesh_instance->apply();
+        mesh_instance->commit();
+        mesh_instances[i] = mesh_instance;
+      }
+    });
 
-      mesh_scene->commit();
-
-      // std::cout << "--- mesh added to mesh_scene" << std::endl;
-      EmbreeInstancePtr mesh_instance = std::make_shared<EmbreeInstance>();
-      mesh_instance->set(mesh_scene);
-      mesh_instance->name = node->mName.C_Str();
-      mesh_instance->setTransform(T);
-      mesh_instance->setScale(scale);
-      mesh_instance->apply();
-      mesh_instance->commit();
-      // std::cout << "--- mesh_instance created" << std::endl;
+    for(EmbreeInstancePtr mesh_instance : mesh_instances)
+    {
       scene->add(mesh_instance);
     }
 
-    // std::cout << "add meshes that are not instanciated ..." << std::endl;
     // ADD MESHES THAT ARE NOT INSTANCIATED
-    for(auto elem : meshes)
+    for(EmbreeMeshPtr mesh : meshes)
     {
-      auto mesh = elem.second;
-      if(instanciated_meshes.find(mesh) == instanciated_meshes.end())
+      if(mesh && instanciated_meshes.find(mesh) == instanciated_meshes.end())
       {
         // mesh was never instanciated. add to scene
         scene->add(mesh);
@@ -405,4 +665,182 @@ EmbreeScenePtr make_embree_scene(
     return scene;
 }
 
+EmbreeScenePtr make_embree_scene(
+    MapFilePtr file,
+    EmbreeDevicePtr device,
+    EmbreeSceneSettings settings)
+{
+    EmbreeScenePtr scene = std::make_shared<EmbreeScene>(settings, device);
+
+    // 1. meshes
+    const std::vector<MapFileMesh>& file_meshes = file->meshes();
+    std::vector<EmbreeMeshPtr> meshes(file_meshes.size());
+    tbb::parallel_for(tbb::blocked_range<size_t>(0, file_meshes.size()),
+      [&](const tbb::blocked_range<size_t>& r)
+    {
+      for(size_t i=r.begin(); i<r.end(); i++)
+      {
+        meshes[i] = std::make_shared<EmbreeMesh>(file_meshes[i], file, device);
+        meshes[i]->commit();
+      }
+    });
+
+    // 2. instances. referenced instances are built first. 
+    // The geometry ids are bounded by MapFile (rmap::GEOM_ID_LIMIT): 
+    // the flat tables of the scenes cannot grow unbounded. 
+    // So is the nesting (rmap::MAX_INSTANCE_DEPTH): the recursion of build
+    const std::vector<MapFileInstance>& file_instances = file->instances();
+    std::vector<EmbreeInstancePtr> instances(file_instances.size());
+    std::vector<bool> visiting(file_instances.size(), false);
+
+    std::function<EmbreeGeometryPtr(const rmap::GeometryRef&)> build 
+      = [&](const rmap::GeometryRef& ref) -> EmbreeGeometryPtr
+    {
+      if(ref.type == rmap::GeometryType::MESH)
+      {
+        return meshes[ref.index];
+      }
+
+      if(instances[ref.index])
+      {
+        return instances[ref.index];
+      }
+
+      if(visiting[ref.index])
+      {
+        RM_THROW(EmbreeException, "[make_embree_scene(MapFile)] instance '" 
+          + file_instances[ref.index].name + "' references itself");
+      }
+      visiting[ref.index] = true;
+
+      const MapFileInstance& file_instance = file_instances[ref.index];
+      EmbreeScenePtr instance_scene = std::make_shared<EmbreeScene>(settings, device);
+      for(const rmap::GeometryRef& child : file_instance.geometries)
+      {
+        instance_scene->add(build(child), child.geom_id);
+      }
+      instance_scene->commit();
+
+      EmbreeInstancePtr instance = std::make_shared<EmbreeInstance>(device);
+      instance->set(instance_scene);
+      instance->name = file_instance.name;
+      instance->setTransform(file_instance.T);
+      instance->setScale(file_instance.scale);
+      instance->apply();
+      instance->commit();
+
+      instances[ref.index] = instance;
+      return instance;
+    };
+
+    // 3. top-level scene
+    for(const rmap::GeometryRef& ref : file->root())
+    {
+      scene->add(build(ref), ref.geom_id);
+    }
+
+    return scene;
+}
+
+void write_map_file(
+    const std::string& filename,
+    EmbreeScenePtr scene)
+{
+    std::vector<MapFileMesh> meshes;
+    std::vector<MapFileInstance> instances;
+    std::vector<rmap::GeometryRef> root;
+
+    // geometries can be added to several scenes. store them once
+    std::unordered_map<const EmbreeGeometry*, uint32_t> mesh_index;
+    std::unordered_map<const EmbreeGeometry*, uint32_t> instance_index;
+
+    // face normals computed here if the mesh has none
+    // (list: the buffers must not move)
+    std::list<Memory<Vector, RAM> > face_normals_buffers;
+
+    std::function<void(EmbreeScenePtr, std::vector<rmap::GeometryRef>&)> collect
+      = [&](EmbreeScenePtr s, std::vector<rmap::GeometryRef>& refs)
+    {
+      // deterministic order
+      std::map<unsigned int, EmbreeGeometryPtr> geometries;
+      for(const auto& elem : s->geometries())
+      {
+        geometries.insert(elem);
+      }
+
+      for(const auto& elem : geometries)
+      {
+        rmap::GeometryRef ref = {};
+        ref.geom_id = elem.first;
+
+        if(EmbreeMeshPtr mesh = std::dynamic_pointer_cast<EmbreeMesh>(elem.second))
+        {
+          auto it = mesh_index.find(mesh.get());
+          if(it == mesh_index.end())
+          {
+            MemoryView<const Vertex, RAM> vertices = mesh->verticesTransformed();
+            MemoryView<Face, RAM> faces = mesh->faces();
+            MemoryView<const Vector, RAM> face_normals = mesh->faceNormalsTransformed();
+            MemoryView<const Vector, RAM> vertex_normals = mesh->vertexNormalsTransformed();
+
+            const Vector* face_normals_ptr = face_normals.raw();
+            if(face_normals.size() != faces.size())
+            {
+              face_normals_buffers.emplace_back(faces.size());
+              Memory<Vector, RAM>& normals = face_normals_buffers.back();
+              for(size_t i=0; i<faces.size(); i++)
+              {
+                const Vector v0 = vertices[faces[i].v0];
+                const Vector v1 = vertices[faces[i].v1];
+                const Vector v2 = vertices[faces[i].v2];
+                normals[i] = (v1 - v0).normalize().cross((v2 - v0).normalize()).normalize();
+              }
+              face_normals_ptr = normals.raw();
+            }
+
+            const size_t num_vertex_normals = 
+              (vertex_normals.size() == vertices.size()) ? vertices.size() : 0;
+
+            // write_map_file only reads the buffers
+            meshes.push_back(MapFileMesh{
+              mesh->name,
+              MemoryView<Vertex, RAM>(const_cast<Vertex*>(vertices.raw()), vertices.size()),
+              faces,
+              MemoryView<Vector, RAM>(const_cast<Vector*>(face_normals_ptr), faces.size()),
+              MemoryView<Vector, RAM>(const_cast<Vector*>(vertex_normals.raw()), num_vertex_normals)
+            });
+            it = mesh_index.emplace(mesh.get(), meshes.size() - 1).first;
+          }
+          ref.type = rmap::GeometryType::MESH;
+          ref.index = it->second;
+        } else if(EmbreeInstancePtr instance = std::dynamic_pointer_cast<EmbreeInstance>(elem.second)) {
+          auto it = instance_index.find(instance.get());
+          if(it == instance_index.end())
+          {
+            // reserve the slot before the children are collected
+            const uint32_t index = instances.size();
+            instances.push_back(MapFileInstance{
+              instance->name, instance->transform(), instance->scale(), {}});
+            it = instance_index.emplace(instance.get(), index).first;
+
+            std::vector<rmap::GeometryRef> children;
+            collect(instance->scene(), children);
+            instances[index].geometries = children;
+          }
+          ref.type = rmap::GeometryType::INSTANCE;
+          ref.index = it->second;
+        } else {
+          std::cout << "[write_map_file()] WARNING: geometry " << elem.first 
+            << " is neither a mesh nor an instance. Skipping." << std::endl;
+          continue;
+        }
+
+        refs.push_back(ref);
+      }
+    };
+
+    collect(scene, root);
+    write_map_file(filename, meshes, instances, root);
+}
+
 } // namespace rmagine
\ No newline at end of file
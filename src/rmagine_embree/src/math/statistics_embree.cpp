@@ -0,0 +1,112 @@
+#include "rmagine/math/statistics_embree.h"
+
+#include <tbb/blocked_range.h>
+#include <tbb/parallel_reduce.h>
+
+namespace rmagine
+{
+
+template<bool P2L>
+CrossStatistics statistics_closest_points(
+    const Transform& pre_transform,
+    const PointCloudView_<RAM>& dataset,
+    const EmbreeScene& scene,
+    const UmeyamaReductionConstraints& params,
+    const bool filter_model_ids)
+{
+  return tbb::parallel_reduce(
+    tbb::blocked_range<size_t>(0, dataset.points.size(), 64),
+    CrossStatistics::Identity(),
+    [&](const tbb::blocked_range<size_t>& r, CrossStatistics acc) 
+    {
+      for (size_t i = r.begin(); i != r.end(); ++i) 
+      {
+        if(  (dataset.mask.empty() || dataset.mask[i] > 0)
+          && (dataset.ids.empty()  || dataset.ids[i] == params.dataset_id)
+          )
+        {
+          const Vector Di = pre_transform * dataset.points[i]; // read
+
+          // the search radius already rejects correspondences farther than max_dist
+          const EmbreeClosestPointResult cp = scene.closestPoint(Di, params.max_dist);
+
+          if(cp.geomID == RTC_INVALID_GEOMETRY_ID)
+          {
+            continue;
+          }
+
+          if(filter_model_ids)
+          {
+            const unsigned int object_id = (cp.instID != RTC_INVALID_GEOMETRY_ID) ? cp.instID : cp.geomID;
+            if(object_id != params.model_id)
+            {
+              continue;
+            }
+          }
+
+          if constexpr(P2L)
+          {
+            const Vector Ni = cp.n;
+            const float signed_plane_dist = (cp.p - Di).dot(Ni);
+
+            // nearest point on plane
+            const Vector Mi = Di + Ni * signed_plane_dist;
+            acc += CrossStatistics::Init(Di, Mi);
+          } else {
+            acc += CrossStatistics::Init(Di, cp.p);
+          }
+        }
+      }
+      return acc;
+    },
+    std::plus<CrossStatistics>()
+  );
+}
+
+void statistics_p2p(
+    const Transform& pre_transform,
+    const PointCloudView_<RAM>& dataset,
+    const EmbreeMapPtr map,
+    const UmeyamaReductionConstraints params,
+    CrossStatistics& stats,
+    const bool filter_model_ids)
+{
+  stats = statistics_closest_points<false>(pre_transform, dataset, *map->scene, params, filter_model_ids);
+}
+
+CrossStatistics statistics_p2p(
+    const Transform& pre_transform,
+    const PointCloudView_<RAM>& dataset,
+    const EmbreeMapPtr map,
+    const UmeyamaReductionConstraints params,
+    const bool filter_model_ids)
+{
+  CrossStatistics ret;
+  statistics_p2p(pre_transform, dataset, map, params, ret, filter_model_ids);
+  return ret;
+}
+
+void statistics_p2l(
+    const Transform& pre_transform,
+    const PointCloudView_<RAM>& dataset,
+    const EmbreeMapPtr map,
+    const UmeyamaReductionConstraints params,
+    CrossStatistics& stats,
+    const bool filter_model_ids)
+{
+  stats = statistics_closest_points<true>(pre_transform, dataset, *map->scene, params, filter_model_ids);
+}
+
+CrossStatistics statistics_p2l(
+    const Transform& pre_transform,
+    const PointCloudView_<RAM>& dataset,
+    const EmbreeMapPtr map,
+    const UmeyamaReductionConstraints params,
+    const bool filter_model_ids)
+{
+  CrossStatistics ret;
+  statistics_p2l(pre_transform, dataset, map, params, ret, filter_model_ids);
+  return ret;
+}
+
+} // namespace rmagine
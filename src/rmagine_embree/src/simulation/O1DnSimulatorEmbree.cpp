@@ -38,4 +38,24 @@ void O1DnSimulatorEmbree::setModel(
   m_model->dirs = model->dirs;
 }
 
-} // namespace rmagine
\ No newline at end of file
+CrossStatistics O1DnSimulatorEmbree::statisticsP2P(
+    const Transform& Tbm,
+    const Transform& pre_transform,
+    const PointCloudView_<RAM>& dataset,
+    const UmeyamaReductionConstraints& params,
+    const bool filter_model_ids) const
+{
+  return statistics_<false>(m_model[0], Tbm, pre_transform, dataset, params, filter_model_ids);
+}
+
+CrossStatistics O1DnSimulatorEmbree::statisticsP2L(
+    const Transform& Tbm,
+    const Transform& pre_transform,
+    const PointCloudView_<RAM>& dataset,
+    const UmeyamaReductionConstraints& params,
+    const bool filter_model_ids) const
+{
+  return statistics_<true>(m_model[0], Tbm, pre_transform, dataset, params, filter_model_ids);
+}
+
+} // namespace rmagine
@@ -1,9 +1,28 @@
 #include "rmagine/simulation/PinholeSimulatorEmbree.hpp"
+#include <rmagine/types/conversions.h>
 #include <limits>
 
 namespace rmagine
 {
 
+namespace
+{
+
+void set_model_dirs(
+    const PinholeModel& model,
+    O1DnModel_<RAM_POOLED>& model_dirs)
+{
+  O1DnModel tmp;
+  convert(model, tmp);
+  model_dirs.width = tmp.width;
+  model_dirs.height = tmp.height;
+  model_dirs.range = tmp.range;
+  model_dirs.orig = tmp.orig;
+  model_dirs.dirs = tmp.dirs;
+}
+
+} // anonymous namespace
+
 PinholeSimulatorEmbree::PinholeSimulatorEmbree()
 :SimulatorEmbree()
 ,m_model(1)
@@ -26,12 +45,34 @@ PinholeSimulatorEmbree::~PinholeSimulatorEmbree()
 void PinholeSimulatorEmbree::setModel(const MemoryView<PinholeModel, RAM>& model)
 {
   m_model = model;
+  set_model_dirs(m_model[0], m_model_dirs);
 }
 
 void PinholeSimulatorEmbree::setModel(const PinholeModel& model)
 {
   m_model.resize(1);
   m_model[0] = model;
+  set_model_dirs(m_model[0], m_model_dirs);
+}
+
+CrossStatistics PinholeSimulatorEmbree::statisticsP2P(
+    const Transform& Tbm,
+    const Transform& pre_transform,
+    const PointCloudView_<RAM>& dataset,
+    const UmeyamaReductionConstraints& params,
+    const bool filter_model_ids) const
+{
+  return statistics_<false>(m_model_dirs, Tbm, pre_transform, dataset, params, filter_model_ids);
+}
+
+CrossStatistics PinholeSimulatorEmbree::statisticsP2L(
+    const Transform& Tbm,
+    const Transform& pre_transform,
+    const PointCloudView_<RAM>& dataset,
+    const UmeyamaReductionConstraints& params,
+    const bool filter_model_ids) const
+{
+  return statistics_<true>(m_model_dirs, Tbm, pre_transform, dataset, params, filter_model_ids);
 }
 
-} // namespace rmagine
\ No newline at end of file
+} // namespace rmagine
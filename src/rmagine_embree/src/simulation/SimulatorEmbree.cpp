@@ -1,5 +1,7 @@
 #include "rmagine/simulation/SimulatorEmbree.hpp"
+#include <rmagine/util/exceptions.h>
 #include <limits>
+#include <sstream>
 
 namespace rmagine
 {
@@ -37,4 +39,68 @@ void SimulatorEmbree::setTsb(const Transform& Tsb)
   m_Tsb[0] = Tsb;
 }
 
-} // namespace rmagine
\ No newline at end of file
+void SimulatorEmbree::setPacketSize(unsigned int packet_size)
+{
+  if(packet_size != 0 && packet_size != 1 && packet_size != 4 
+    && packet_size != 8 && packet_size != 16)
+  {
+    std::stringstream ss;
+    ss << "Unsupported packet size " << packet_size << ". Choose one of 0 (native), 1, 4, 8, 16";
+    RM_THROW(EmbreeException, ss.str());
+  }
+  m_packet_size = packet_size;
+}
+
+unsigned int SimulatorEmbree::packetSize() const
+{
+  if(m_packet_size == 0)
+  {
+    if(m_map && m_map->device)
+    {
+      return m_map->device->nativePacketSize();
+    }
+    return 1;
+  }
+  return m_packet_size;
+}
+
+void SimulatorEmbree::setGrainSize(const EmbreeGrainSize& grain_size)
+{
+  if(grain_size.rows == 0 || grain_size.cols == 0 || grain_size.poses == 0)
+  {
+    RM_THROW(EmbreeException, "Grain sizes must be greater than zero");
+  }
+  m_grain_size = grain_size;
+}
+
+void SimulatorEmbree::setArena(std::shared_ptr<tbb::task_arena> arena)
+{
+  m_arena = arena;
+}
+
+void SimulatorEmbree::setConcurrency(int max_concurrency)
+{
+  if(max_concurrency <= 0)
+  {
+    RM_THROW(EmbreeException, "Concurrency must be greater than zero");
+  }
+  m_arena = std::make_shared<tbb::task_arena>(max_concurrency);
+}
+
+void SimulatorEmbree::setNoise(NoisePtr noise)
+{
+  m_noise = noise;
+}
+
+tbb::task_arena& SimulatorEmbree::asyncArena_() const
+{
+  if(m_arena)
+  {
+    return *m_arena;
+  }
+
+  static tbb::task_arena async_arena;
+  return async_arena;
+}
+
+} // namespace rmagine
@@ -1,10 +1,29 @@
 #include "rmagine/simulation/SphereSimulatorEmbree.hpp"
+#include <rmagine/types/conversions.h>
 #include <limits>
 
 
 namespace rmagine
 {
 
+namespace
+{
+
+void set_model_dirs(
+    const SphericalModel& model,
+    O1DnModel_<RAM_POOLED>& model_dirs)
+{
+  O1DnModel tmp;
+  convert(model, tmp);
+  model_dirs.width = tmp.width;
+  model_dirs.height = tmp.height;
+  model_dirs.range = tmp.range;
+  model_dirs.orig = tmp.orig;
+  model_dirs.dirs = tmp.dirs;
+}
+
+} // anonymous namespace
+
 SphereSimulatorEmbree::SphereSimulatorEmbree()
 :SimulatorEmbree()
 ,m_model(1)
@@ -28,6 +47,7 @@ void SphereSimulatorEmbree::setModel(
     const MemoryView<SphericalModel, RAM>& model)
 {
   m_model = model;
+  set_model_dirs(m_model[0], m_model_dirs);
 }
 
 void SphereSimulatorEmbree::setModel(
@@ -35,6 +55,27 @@ void SphereSimulatorEmbree::setModel(
 {
   m_model.resize(1);
   m_model[0] = model;
+  set_model_dirs(m_model[0], m_model_dirs);
+}
+
+CrossStatistics SphereSimulatorEmbree::statisticsP2P(
+    const Transform& Tbm,
+    const Transform& pre_transform,
+    const PointCloudView_<RAM>& dataset,
+    const UmeyamaReductionConstraints& params,
+    const bool filter_model_ids) const
+{
+  return statistics_<false>(m_model_dirs, Tbm, pre_transform, dataset, params, filter_model_ids);
+}
+
+CrossStatistics SphereSimulatorEmbree::statisticsP2L(
+    const Transform& Tbm,
+    const Transform& pre_transform,
+    const PointCloudView_<RAM>& dataset,
+    const UmeyamaReductionConstraints& params,
+    const bool filter_model_ids) const
+{
+  return statistics_<true>(m_model_dirs, Tbm, pre_transform, dataset, params, filter_model_ids);
 }
 
-} // namespace rmagine
\ No newline at end of file
+} // namespace rmagine
@@ -0,0 +1,326 @@
+#include <iostream>
+#include <cstdio>
+#include <filesystem>
+#include <fstream>
+
+#include <rmagine/map/MapFile.hpp>
+#include <rmagine/types/Memory.hpp>
+#include <rmagine/util/exceptions.h>
+
+namespace rm = rmagine;
+
+bool equal(const rm::Vector& a, const rm::Vector& b)
+{
+  return a.x == b.x && a.y == b.y && a.z == b.z;
+}
+
+int main(int argc, char** argv)
+{
+  std::cout << "RMAGINE CORE MAP FILE" << std::endl;
+
+  const std::string filename = "rmagine_tests_core_map_file.rmap";
+
+  // two triangles. the second mesh has vertex normals
+  rm::Memory<rm::Vertex, rm::RAM> vertices(4);
+  vertices[0] = {0.0, 0.0, 0.0};
+  vertices[1] = {1.0, 0.0, 0.0};
+  vertices[2] = {0.0, 1.0, 0.0};
+  vertices[3] = {1.0, 1.0, 0.0};
+
+  rm::Memory<rm::Face, rm::RAM> faces(2);
+  faces[0] = {0, 1, 2};
+  faces[1] = {1, 3, 2};
+
+  rm::Memory<rm::Vector, rm::RAM> normals(4);
+  for(size_t i=0; i<normals.size(); i++)
+  {
+    normals[i] = {0.0, 0.0, 1.0};
+  }
+
+  std::vector<rm::MapFileMesh> meshes;
+  meshes.push_back(rm::MapFileMesh{"plane", vertices, faces, normals(0, 2)});
+  meshes.push_back(rm::MapFileMesh{"plane_normals", vertices, faces, normals(0, 2), normals});
+
+  // instance of both meshes, instanced once more
+  std::vector<rm::MapFileInstance> instances(2);
+  instances[0].name = "planes";
+  instances[0].T.setIdentity();
+  instances[0].T.t = {1.0, 2.0, 3.0};
+  instances[0].scale = {1.0, 1.0, 2.0};
+  instances[0].geometries = {
+    {rm::rmap::GeometryType::MESH, 0, 0, 0}, 
+    {rm::rmap::GeometryType::MESH, 1, 5, 0}};
+  instances[1].name = "planes_of_planes";
+  instances[1].T.setIdentity();
+  instances[1].scale = {1.0, 1.0, 1.0};
+  instances[1].geometries = {{rm::rmap::GeometryType::INSTANCE, 0, 0, 0}};
+
+  std::vector<rm::rmap::GeometryRef> root = {
+    {rm::rmap::GeometryType::INSTANCE, 1, 0, 0},
+    {rm::rmap::GeometryType::MESH, 0, 3, 0}};
+
+  rm::write_map_file(filename, meshes, instances, root);
+
+  if(!rm::is_map_file(filename))
+  {
+    RM_THROW(rm::Exception, "is_map_file: .rmap not detected");
+  }
+
+  {
+    rm::MapFile file(filename);
+
+    if(file.meshes().size() != 2 || file.instances().size() != 2 || file.root().size() != 2)
+    {
+      RM_THROW(rm::Exception, "MapFile: wrong number of entries");
+    }
+
+    for(size_t i=0; i<2; i++)
+    {
+      const rm::MapFileMesh& mesh = file.meshes()[i];
+      if(mesh.name != meshes[i].name 
+        || mesh.vertices.size() != 4 || mesh.faces.size() != 2 || mesh.face_normals.size() != 2)
+      {
+        RM_THROW(rm::Exception, "MapFile: wrong mesh " + std::to_string(i));
+      }
+
+      if(reinterpret_cast<uintptr_t>(mesh.vertices.raw()) % rm::rmap::ALIGNMENT != 0)
+      {
+        RM_THROW(rm::Exception, "MapFile: vertex buffer not aligned");
+      }
+
+      for(size_t j=0; j<4; j++)
+      {
+        if(!equal(mesh.vertices[j], vertices[j]))
+        {
+          RM_THROW(rm::Exception, "MapFile: wrong vertex");
+        }
+      }
+      for(size_t j=0; j<2; j++)
+      {
+        if(mesh.faces[j].v0 != faces[j].v0 || mesh.faces[j].v1 != faces[j].v1 || mesh.faces[j].v2 != faces[j].v2)
+        {
+          RM_THROW(rm::Exception, "MapFile: wrong face");
+        }
+      }
+    }
+
+    if(file.meshes()[0].vertex_normals.size() != 0 || file.meshes()[1].vertex_normals.size() != 4)
+    {
+      RM_THROW(rm::Exception, "MapFile: wrong vertex normals");
+    }
+
+    const rm::MapFileInstance& instance = file.instances()[0];
+    if(instance.name != "planes" || !equal(instance.T.t, instances[0].T.t) 
+      || !equal(instance.scale, instances[0].scale)
+      || instance.geometries.size() != 2 || instance.geometries[1].geom_id != 5)
+    {
+      RM_THROW(rm::Exception, "MapFile: wrong instance");
+    }
+
+    if(file.root()[0].type != rm::rmap::GeometryType::INSTANCE 
+      || file.root()[1].geom_id != 3)
+    {
+      RM_THROW(rm::Exception, "MapFile: wrong root geometries");
+    }
+
+    // copy-on-write: changing the mapping does not change the file
+    rm::MemoryView<rm::Vertex, rm::RAM> mapped_vertices = file.meshes()[0].vertices;
+    mapped_vertices[0] = {10.0, 10.0, 10.0};
+  }
+
+  {
+    rm::MapFile file(filename);
+    if(!equal(file.meshes()[0].vertices[0], vertices[0]))
+    {
+      RM_THROW(rm::Exception, "MapFile: file changed by modifying the mapping");
+    }
+  }
+
+  // invalid references are rejected
+  {
+    std::vector<rm::rmap::GeometryRef> root_invalid = {{rm::rmap::GeometryType::MESH, 2, 0, 0}};
+    bool thrown = false;
+    try {
+      rm::write_map_file(filename, meshes, instances, root_invalid);
+    } catch(const rm::Exception& e) {
+      thrown = true;
+    }
+    if(!thrown)
+    {
+      RM_THROW(rm::Exception, "write_map_file: invalid reference accepted");
+    }
+  }
+
+  // geometry ids beyond the limit are rejected
+  {
+    std::vector<rm::rmap::GeometryRef> root_invalid = {{rm::rmap::GeometryType::MESH, 0, rm::rmap::GEOM_ID_LIMIT, 0}};
+    bool thrown = false;
+    try {
+      rm::write_map_file(filename, meshes, instances, root_invalid);
+    } catch(const rm::Exception& e) {
+      thrown = true;
+    }
+    if(!thrown)
+    {
+      RM_THROW(rm::Exception, "write_map_file: invalid geometry id accepted");
+    }
+  }
+
+  // cycles and too deeply nested instances are rejected
+  {
+    std::vector<rm::MapFileInstance> instances_cycle = instances;
+    instances_cycle[0].geometries.push_back({rm::rmap::GeometryType::INSTANCE, 1, 7, 0});
+
+    bool thrown = false;
+    try {
+      rm::write_map_file(filename, meshes, instances_cycle, root);
+    } catch(const rm::Exception& e) {
+      thrown = true;
+    }
+    if(!thrown)
+    {
+      RM_THROW(rm::Exception, "write_map_file: instance cycle accepted");
+    }
+
+    // chain of instances, each instancing the previous one
+    std::vector<rm::MapFileInstance> instances_deep(rm::rmap::MAX_INSTANCE_DEPTH + 1);
+    for(size_t i=0; i<instances_deep.size(); i++)
+    {
+      instances_deep[i].name = "level_" + std::to_string(i);
+      instances_deep[i].T.setIdentity();
+      instances_deep[i].scale = {1.0, 1.0, 1.0};
+      if(i == 0)
+      {
+        instances_deep[i].geometries = {{rm::rmap::GeometryType::MESH, 0, 0, 0}};
+      } else {
+        instances_deep[i].geometries = {{rm::rmap::GeometryType::INSTANCE, static_cast<uint32_t>(i - 1), 0, 0}};
+      }
+    }
+    std::vector<rm::rmap::GeometryRef> root_deep = {
+      {rm::rmap::GeometryType::INSTANCE, static_cast<uint32_t>(instances_deep.size() - 1), 0, 0}};
+
+    thrown = false;
+    try {
+      rm::write_map_file(filename, meshes, instances_deep, root_deep);
+    } catch(const rm::Exception& e) {
+      thrown = true;
+    }
+    if(!thrown)
+    {
+      RM_THROW(rm::Exception, "write_map_file: too deeply nested instances accepted");
+    }
+
+    // the maximum depth is fine
+    instances_deep.pop_back();
+    root_deep[0].index = instances_deep.size() - 1;
+    rm::write_map_file(filename, meshes, instances_deep, root_deep);
+    rm::MapFile file(filename);
+  }
+
+  // a vertex buffer at the end of the file needs the padding for Embree
+  {
+    std::vector<rm::MapFileMesh> meshes_points;
+    meshes_points.push_back(rm::MapFileMesh{"points", vertices, faces(0, 0), normals(0, 0)});
+    std::vector<rm::rmap::GeometryRef> root_points = {{rm::rmap::GeometryType::MESH, 0, 0, 0}};
+    rm::write_map_file(filename, meshes_points, {}, root_points);
+
+    {
+      std::fstream fs(filename, std::ios::in | std::ios::out | std::ios::binary);
+      rm::rmap::Header header;
+      fs.read(reinterpret_cast<char*>(&header), sizeof(header));
+      rm::rmap::MeshEntry entry;
+      fs.seekg(header.meshes_offset);
+      fs.read(reinterpret_cast<char*>(&entry), sizeof(entry));
+
+      // end the file directly behind the vertices
+      entry.faces_offset = entry.vertices_offset;
+      entry.face_normals_offset = entry.vertices_offset;
+      header.file_size = entry.vertices_offset + sizeof(rm::Vertex) * entry.num_vertices;
+      fs.seekp(0);
+      fs.write(reinterpret_cast<const char*>(&header), sizeof(header));
+      fs.seekp(header.meshes_offset);
+      fs.write(reinterpret_cast<const char*>(&entry), sizeof(entry));
+      fs.close();
+      std::filesystem::resize_file(filename, header.file_size);
+    }
+
+    bool thrown = false;
+    try {
+      rm::MapFile file(filename);
+    } catch(const rm::Exception& e) {
+      thrown = true;
+    }
+    if(!thrown)
+    {
+      RM_THROW(rm::Exception, "MapFile: vertex buffer without padding accepted");
+    }
+  }
+
+  // faces referencing missing vertices are rejected
+  {
+    rm::Memory<rm::Face, rm::RAM> faces_invalid(2);
+    faces_invalid[0] = {0, 1, 2};
+    faces_invalid[1] = {1, 4, 2};
+
+    std::vector<rm::MapFileMesh> meshes_invalid;
+    meshes_invalid.push_back(rm::MapFileMesh{"plane", vertices, faces_invalid, normals(0, 2)});
+
+    bool thrown = false;
+    try {
+      rm::write_map_file(filename, meshes_invalid, {}, {});
+    } catch(const rm::Exception& e) {
+      thrown = true;
+    }
+    if(!thrown)
+    {
+      RM_THROW(rm::Exception, "write_map_file: invalid face accepted");
+    }
+
+    // corrupt a face of a valid file
+    rm::write_map_file(filename, meshes, instances, root);
+    {
+      std::fstream fs(filename, std::ios::in | std::ios::out | std::ios::binary);
+      rm::rmap::Header header;
+      fs.read(reinterpret_cast<char*>(&header), sizeof(header));
+      rm::rmap::MeshEntry entry;
+      fs.seekg(header.meshes_offset);
+      fs.read(reinterpret_cast<char*>(&entry), sizeof(entry));
+      const rm::Face face_invalid = {0, 1, 1000};
+      fs.seekp(entry.faces_offset + sizeof(rm::Face));
+      fs.write(reinterpret_cast<const char*>(&face_invalid), sizeof(face_invalid));
+    }
+
+    thrown = false;
+    try {
+      rm::MapFile file(filename);
+    } catch(const rm::Exception& e) {
+      thrown = true;
+    }
+    if(!thrown)
+    {
+      RM_THROW(rm::Exception, "MapFile: invalid face accepted");
+    }
+  }
+
+  // no map file
+  {
+    FILE* fp = fopen(filename.c_str(), "w");
+    fputs("no map file", fp);
+    fclose(fp);
+
+    bool thrown = false;
+    try {
+      rm::MapFile file(filename);
+    } catch(const rm::Exception& e) {
+      thrown = true;
+    }
+    if(!thrown)
+    {
+      RM_THROW(rm::Exception, "MapFile: invalid file accepted");
+    }
+  }
+
+  std::remove(filename.c_str());
+
+  return 0;
+}
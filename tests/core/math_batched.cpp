@@ -0,0 +1,192 @@
+#include <iostream>
+#include <random>
+#include <cmath>
+
+#include <rmagine/math/types.h>
+#include <rmagine/math/memory_math.h>
+#include <rmagine/math/math_batched.h>
+#include <rmagine/util/exceptions.h>
+#include <rmagine/util/StopWatch.hpp>
+#include <rmagine/util/prints.h>
+
+namespace rm = rmagine;
+
+void expect_near(const rm::Vector& a, const rm::Vector& b, float eps, std::string name)
+{
+  if((a - b).l2norm() > eps)
+  {
+    std::cout << a << " != " << b << std::endl;
+    RM_THROW(rm::Exception, name + " differs");
+  }
+}
+
+void expect_near(const rm::Matrix3x3& a, const rm::Matrix3x3& b, float eps, std::string name)
+{
+  for(size_t i=0; i<3; i++)
+  {
+    for(size_t j=0; j<3; j++)
+    {
+      if(fabs(a(i,j) - b(i,j)) > eps)
+      {
+        std::cout << a << " != " << b << std::endl;
+        RM_THROW(rm::Exception, name + " differs");
+      }
+    }
+  }
+}
+
+/**
+ * Compares the batched reductions against sum / cov of memory_math 
+ * applied to every batch separately
+ */
+void test_batched(size_t n_batches, size_t batch_size)
+{
+  std::cout << "- " << n_batches << " batches of " << batch_size << std::endl;
+  const size_t N = n_batches * batch_size;
+
+  std::mt19937 gen(42);
+  std::uniform_real_distribution<float> dist(-1.0, 1.0);
+
+  rm::Memory<rm::Vector, rm::RAM> a(N), b(N);
+  rm::Memory<float, rm::RAM> f(N);
+  rm::Memory<unsigned int, rm::RAM> u(N);
+  rm::Memory<bool, rm::RAM> mask(N);
+  rm::Memory<unsigned int, rm::RAM> mask_u(N);
+  rm::Memory<uint8_t, rm::RAM> mask_u8(N);
+  rm::Memory<unsigned int, rm::RAM> ncorr(n_batches);
+
+  for(size_t i=0; i<N; i++)
+  {
+    a[i] = {dist(gen), dist(gen), dist(gen)};
+    b[i] = {dist(gen), dist(gen), dist(gen)};
+    f[i] = dist(gen);
+    u[i] = i % 7;
+    mask[i] = (dist(gen) > 0.0);
+    mask_u[i] = mask[i];
+    mask_u8[i] = mask[i];
+  }
+
+  // the last batch has no valid element
+  for(size_t i=(n_batches - 1) * batch_size; i<N; i++)
+  {
+    mask[i] = false;
+    mask_u[i] = 0;
+    mask_u8[i] = 0;
+  }
+
+  for(size_t bid=0; bid<n_batches; bid++)
+  {
+    ncorr[bid] = 0;
+    for(size_t i=bid * batch_size; i<(bid + 1) * batch_size; i++)
+    {
+      ncorr[bid] += mask[i];
+    }
+  }
+
+  auto sums = rm::sumBatched(a, batch_size);
+  auto sums_f = rm::sumBatched(f, batch_size);
+  auto sums_u = rm::sumBatched(u, batch_size);
+  auto sums_masked = rm::sumBatched(a, mask, batch_size);
+  auto sums_masked_u = rm::sumBatched(a, mask_u, batch_size);
+  auto sums_masked_u8 = rm::sumBatched(a, mask_u8, batch_size);
+  auto covs = rm::covBatched(a, b, batch_size);
+  auto covs_masked = rm::covBatched(a, b, mask, ncorr, batch_size);
+
+  rm::Memory<rm::Matrix3x3, rm::RAM> outer(N);
+  for(size_t i=0; i<N; i++)
+  {
+    outer[i] = rm::Matrix3x3::Zeros();
+    for(size_t r=0; r<3; r++)
+    {
+      for(size_t c=0; c<3; c++)
+      {
+        outer[i](r,c) = b[i][r] * a[i][c];
+      }
+    }
+  }
+  auto sums_m = rm::sumBatched(outer, batch_size);
+
+  if(sums.size() != n_batches || covs.size() != n_batches)
+  {
+    RM_THROW(rm::Exception, "wrong number of batches");
+  }
+
+  const float eps = 1e-5 * batch_size + 1e-4;
+
+  for(size_t bid=0; bid<n_batches; bid++)
+  {
+    auto a_b = a(bid * batch_size, (bid + 1) * batch_size);
+    auto b_b = b(bid * batch_size, (bid + 1) * batch_size);
+    
+    rm::Vector sum_ref = rm::Vector::Zeros();
+    rm::Vector sum_masked_ref = rm::Vector::Zeros();
+    rm::Matrix3x3 cov_masked_ref = rm::Matrix3x3::Zeros();
+    double sum_f_ref = 0.0;
+    unsigned int sum_u_ref = 0;
+    for(size_t i=bid * batch_size; i<(bid + 1) * batch_size; i++)
+    {
+      sum_ref += a[i];
+      sum_f_ref += f[i];
+      sum_u_ref += u[i];
+      if(mask[i])
+      {
+        sum_masked_ref += a[i];
+        cov_masked_ref += outer[i];
+      }
+    }
+    if(ncorr[bid] > 0)
+    {
+      cov_masked_ref /= static_cast<float>(ncorr[bid]);
+    }
+
+    expect_near(sums[bid], sum_ref, eps, "sumBatched Vector");
+    expect_near(sums_masked[bid], sum_masked_ref, eps, "sumBatched Vector masked (bool)");
+    expect_near(sums_masked_u[bid], sum_masked_ref, eps, "sumBatched Vector masked (unsigned int)");
+    expect_near(sums_masked_u8[bid], sum_masked_ref, eps, "sumBatched Vector masked (uint8_t)");
+    expect_near(sums_m[bid], rm::cov(a_b, b_b)[0] * static_cast<float>(batch_size), eps, "sumBatched Matrix3x3");
+    expect_near(covs[bid], rm::cov(a_b, b_b)[0], 1e-4, "covBatched");
+    expect_near(covs_masked[bid], cov_masked_ref, 1e-4, "covBatched masked");
+
+    if(fabs(sums_f[bid] - sum_f_ref) > eps)
+    {
+      RM_THROW(rm::Exception, "sumBatched float differs");
+    }
+    if(sums_u[bid] != sum_u_ref)
+    {
+      RM_THROW(rm::Exception, "sumBatched unsigned int differs");
+    }
+  }
+
+  if(sums_masked[n_batches - 1].l2norm() != 0.0 || covs_masked[n_batches - 1].det() != 0.0)
+  {
+    RM_THROW(rm::Exception, "empty batch is not zero");
+  }
+}
+
+int main(int argc, char** argv)
+{
+  std::cout << "Rmagine Test: Batched Math" << std::endl;
+
+  test_batched(1, 1);
+  test_batched(100, 1);
+  test_batched(1000, 100);
+  test_batched(7, 10007);
+  test_batched(1, 200003);
+
+  // runtime: one batch per simulated scan
+  rm::StopWatch sw;
+  rm::Memory<rm::Vector, rm::RAM> points(100 * 1024 * 64);
+  for(size_t i=0; i<points.size(); i++)
+  {
+    points[i] = {static_cast<float>(i % 13), 1.0, 2.0};
+  }
+
+  sw();
+  auto sums = rm::sumBatched(points, 1024 * 64);
+  auto covs = rm::covBatched(points, points, 1024 * 64);
+  double el = sw();
+  std::cout << "- sumBatched + covBatched of " << sums.size() << " scans: " << el * 1000.0 << "ms" << std::endl;
+
+  std::cout << "Done." << std::endl;
+  return 0;
+}
@@ -0,0 +1,239 @@
+#include <iostream>
+#include <random>
+#include <cmath>
+
+#include <rmagine/math/types.h>
+#include <rmagine/math/optimization.h>
+#include <rmagine/math/statistics.h>
+#include <rmagine/types/PointCloud.hpp>
+#include <rmagine/util/exceptions.h>
+#include <rmagine/util/StopWatch.hpp>
+#include <rmagine/util/prints.h>
+
+namespace rm = rmagine;
+
+size_t n_points = 100000;
+
+struct Scene 
+{
+  rm::Memory<rm::Vector> dataset_points;
+  rm::Memory<rm::Vector> model_points;
+  rm::Memory<rm::Vector> model_normals;
+};
+
+/**
+ * Points on n_planes planes of a box corner (x=0, y=0, z=0). 
+ * The dataset is the model moved by Tdm^-1 and shifted along the planes, 
+ * so index-wise correspondences are only valid point to plane.
+ * outlier_ratio of the dataset points are moved away from their plane.
+ */
+Scene make_scene(
+  const rm::Transform& Tdm, 
+  unsigned int n_planes,
+  float outlier_ratio)
+{
+  std::mt19937 gen(42);
+  std::uniform_real_distribution<float> dist(0.0, 5.0);
+  std::uniform_real_distribution<float> shift(-0.05, 0.05);
+  std::uniform_real_distribution<float> unit(0.0, 1.0);
+
+  Scene scene;
+  scene.dataset_points.resize(n_points);
+  scene.model_points.resize(n_points);
+  scene.model_normals.resize(n_points);
+
+  const rm::Transform Tmd = Tdm.inv();
+
+  for(size_t i=0; i<n_points; i++)
+  {
+    const unsigned int plane = i % n_planes;
+    rm::Vector m = {dist(gen), dist(gen), dist(gen)};
+    rm::Vector n = {0.0, 0.0, 0.0};
+    m[plane] = 0.0;
+    n[plane] = 1.0;
+
+    rm::Vector d = m + rm::Vector{shift(gen), shift(gen), shift(gen)};
+    d[plane] = 0.0;
+
+    if(unit(gen) < outlier_ratio)
+    {
+      d[plane] = 0.5;
+    }
+
+    scene.model_points[i] = m;
+    scene.model_normals[i] = n;
+    scene.dataset_points[i] = Tmd * d;
+  }
+
+  return scene;
+}
+
+void expect_near(const rm::Transform& a, const rm::Transform& b, float eps, std::string name)
+{
+  const rm::Transform d = a.inv() * b;
+  const float rot_err = rm::Vector{d.R.x, d.R.y, d.R.z}.l2norm();
+  if(d.t.l2norm() > eps || rot_err > eps)
+  {
+    std::cout << a << " != " << b << std::endl;
+    RM_THROW(rm::Exception, name + " differs");
+  }
+}
+
+void test_parallel_vs_serial()
+{
+  std::cout << "- parallel vs serial system" << std::endl;
+  rm::Transform Tdm;
+  Tdm.R = rm::EulerAngles{0.05, -0.02, 0.1};
+  Tdm.t = {0.1, -0.2, 0.05};
+  Scene scene = make_scene(Tdm, 3, 0.05);
+
+  rm::PointCloudView dataset = {.points = scene.dataset_points};
+  rm::PointCloudView model = {.points = scene.model_points, .normals = scene.model_normals};
+
+  rm::UmeyamaReductionConstraints params;
+  params.max_dist = 1000.0;
+  params.dataset_id = 0;
+  params.model_id = 0;
+
+  for(auto type : {rm::RobustKernelType::NONE, rm::RobustKernelType::HUBER, 
+                   rm::RobustKernelType::CAUCHY, rm::RobustKernelType::GEMAN_MCCLURE})
+  {
+    rm::RobustKernel kernel;
+    kernel.type = type;
+    kernel.scale = 0.1;
+
+    for(int metric=0; metric<2; metric++)
+    {
+      rm::Matrix_<float, 6, 6> JTwJ, JTwJ_ref;
+      rm::Matrix_<float, 6, 1> JTwr, JTwr_ref;
+      JTwJ_ref.setZeros();
+      JTwr_ref.setZeros();
+
+      unsigned int n_meas;
+      if(metric == 0)
+      {
+        n_meas = rm::build_linear_system_p2l(rm::Transform::Identity(), dataset, model, params, kernel, JTwJ, JTwr);
+        rm::build_linear_system_p2l(JTwJ_ref, JTwr_ref, model, dataset, kernel);
+      } else {
+        n_meas = rm::build_linear_system_p2p(rm::Transform::Identity(), dataset, model, params, kernel, JTwJ, JTwr);
+        rm::build_linear_system_p2p(JTwJ_ref, JTwr_ref, model, dataset, kernel);
+      }
+
+      if(n_meas != n_points)
+      {
+        RM_THROW(rm::Exception, "wrong number of correspondences");
+      }
+
+      for(size_t i=0; i<6; i++)
+      {
+        for(size_t j=0; j<6; j++)
+        {
+          if(fabs(JTwJ(i,j) - JTwJ_ref(i,j)) > 1e-3 * (fabs(JTwJ_ref(i,j)) + 1.0))
+          {
+            std::cout << JTwJ << " != " << JTwJ_ref << std::endl;
+            RM_THROW(rm::Exception, "JTwJ differs");
+          }
+        }
+        if(fabs(JTwr(i,0) - JTwr_ref(i,0)) > 1e-3 * (fabs(JTwr_ref(i,0)) + 1.0))
+        {
+          std::cout << JTwr << " != " << JTwr_ref << std::endl;
+          RM_THROW(rm::Exception, "JTwr differs");
+        }
+      }
+    }
+  }
+}
+
+void test_convergence()
+{
+  std::cout << "- convergence" << std::endl;
+  rm::Transform Tdm;
+  Tdm.R = rm::EulerAngles{0.05, -0.02, 0.1};
+  Tdm.t = {0.1, -0.2, 0.05};
+
+  rm::UmeyamaReductionConstraints params;
+  params.max_dist = 1.0;
+  params.dataset_id = 0;
+  params.model_id = 0;
+
+  // without outliers least squares converges exactly
+  {
+    Scene scene = make_scene(Tdm, 3, 0.0);
+    rm::PointCloudView dataset = {.points = scene.dataset_points};
+    rm::PointCloudView model = {.points = scene.model_points, .normals = scene.model_normals};
+    
+    rm::RobustKernel kernel;
+    kernel.type = rm::RobustKernelType::NONE;
+
+    rm::StopWatch sw;
+    sw();
+    rm::Transform T = rm::gauss_newton_p2l(rm::Transform::Identity(), dataset, model, params, kernel);
+    double el = sw();
+    std::cout << "  gauss_newton_p2l, " << n_points << " points: " << el * 1000.0 << "ms" << std::endl;
+    expect_near(T, Tdm, 1e-4, "least squares");
+  }
+
+  // robust kernels suppress 20% outliers
+  Scene scene = make_scene(Tdm, 3, 0.2);
+  rm::PointCloudView dataset = {.points = scene.dataset_points};
+  rm::PointCloudView model = {.points = scene.model_points, .normals = scene.model_normals};
+
+  for(auto type : {rm::RobustKernelType::HUBER, rm::RobustKernelType::CAUCHY, 
+                   rm::RobustKernelType::GEMAN_MCCLURE})
+  {
+    rm::RobustKernel kernel;
+    kernel.type = type;
+    kernel.scale = 0.05;
+    rm::Transform T = rm::gauss_newton_p2l(rm::Transform::Identity(), dataset, model, params, kernel, 30);
+    // Huber still gives the outliers a small influence
+    const float eps = (type == rm::RobustKernelType::HUBER) ? 0.05 : 0.01;
+    expect_near(T, Tdm, eps, "robust kernel");
+  }
+}
+
+void test_degenerate()
+{
+  std::cout << "- single plane" << std::endl;
+
+  // a single plane x=0 only constrains x, pitch and yaw
+  rm::Transform Tdm = rm::Transform::Identity();
+  Tdm.t.x = 0.1;
+  Tdm.R = rm::EulerAngles{0.0, 0.02, 0.0};
+  Scene scene = make_scene(Tdm, 1, 0.0);
+  rm::PointCloudView dataset = {.points = scene.dataset_points};
+  rm::PointCloudView model = {.points = scene.model_points, .normals = scene.model_normals};
+
+  rm::UmeyamaReductionConstraints params;
+  params.max_dist = 1.0;
+  params.dataset_id = 0;
+  params.model_id = 0;
+
+  rm::Transform T = rm::gauss_newton_p2l(rm::Transform::Identity(), dataset, model, params);
+  
+  // the unconstrained translation is only moved by the coupling of se3_exp
+  if(fabs(T.t.y) > 5e-3 || fabs(T.t.z) > 5e-3)
+  {
+    std::cout << T << std::endl;
+    RM_THROW(rm::Exception, "unconstrained directions moved");
+  }
+
+  for(size_t i=0; i<n_points; i++)
+  {
+    if(fabs((T * scene.dataset_points[i]).x) > 1e-3)
+    {
+      RM_THROW(rm::Exception, "dataset not moved onto the plane");
+    }
+  }
+}
+
+int main(int argc, char** argv)
+{
+  std::cout << "Rmagine Test: Gauss-Newton Optimization" << std::endl;
+
+  test_parallel_vs_serial();
+  test_convergence();
+  test_degenerate();
+
+  std::cout << "Done." << std::endl;
+  return 0;
+}
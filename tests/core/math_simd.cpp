@@ -0,0 +1,120 @@
+#include <iostream>
+#include <random>
+#include <limits>
+
+#include <rmagine/math/types.h>
+#include <rmagine/math/memory_math.h>
+#include <rmagine/math/simd.h>
+#include <rmagine/util/exceptions.h>
+#include <rmagine/util/StopWatch.hpp>
+#include <rmagine/util/prints.h>
+
+namespace rm = rmagine;
+
+// documented tolerance of simd.h
+void check(
+  const rm::MemoryView<rm::Vector, rm::RAM>& X,
+  const rm::MemoryView<rm::Vector, rm::RAM>& ref,
+  const rm::MemoryView<rm::Vector, rm::RAM>& res,
+  const rm::Vector& t,
+  std::string name)
+{
+  for(size_t i=0; i<ref.size(); i++)
+  {
+    if(ref[i].x != ref[i].x)
+    {
+      // NaN has to stay in its own vector
+      if(res[i].x == res[i].x)
+      {
+        RM_THROW(rm::Exception, name + ": NaN lost");
+      }
+      continue;
+    }
+
+    const float tol = 1e-6 * (X[i].l2norm() + t.l2norm()) + 1e-7;
+    if(fabs(ref[i].x - res[i].x) > tol 
+      || fabs(ref[i].y - res[i].y) > tol 
+      || fabs(ref[i].z - res[i].z) > tol)
+    {
+      std::cout << i << ": " << ref[i] << " != " << res[i] << std::endl;
+      RM_THROW(rm::Exception, name + ": result out of tolerance");
+    }
+  }
+}
+
+int main(int argc, char** argv)
+{
+  std::cout << "RMAGINE CORE MATH SIMD" << std::endl;
+  std::cout << "- supported: " << rm::simd_level_name(rm::simd_level_supported()) << std::endl;
+
+  std::mt19937 gen(42);
+  std::uniform_real_distribution<float> dist(-100.0, 100.0);
+
+  rm::Memory<rm::Transform, rm::RAM> T(1);
+  T[0].R = rm::EulerAngles{0.3, -0.5, 1.2};
+  T[0].t = {10.0, -20.0, 3.0};
+
+  rm::Memory<rm::Matrix3x3, rm::RAM> M(1);
+  M[0] = T[0].R;
+
+  rm::Memory<rm::Quaternion, rm::RAM> Q(1);
+  Q[0] = T[0].R;
+
+  // sizes around the block sizes of all kernels
+  for(size_t N : {0, 1, 2, 5, 6, 7, 17, 18, 19, 33, 34, 35, 1000, 1000003})
+  {
+    rm::Memory<rm::Vector, rm::RAM> X(N);
+    for(size_t i=0; i<N; i++)
+    {
+      X[i] = {dist(gen), dist(gen), dist(gen)};
+    }
+
+    // misses of a simulation
+    for(size_t i=3; i<N; i += 11)
+    {
+      X[i].y = std::numeric_limits<float>::quiet_NaN();
+    }
+
+    rm::set_simd_level(rm::SimdLevel::SCALAR);
+    rm::Memory<rm::Vector, rm::RAM> ref_T = rm::mult1xN(T, X);
+    rm::Memory<rm::Vector, rm::RAM> ref_M = rm::mult1xN(M, X);
+    rm::Memory<rm::Vector, rm::RAM> ref_Q = rm::mult1xN(Q, X);
+
+    for(int level = 1; level <= static_cast<int>(rm::simd_level_supported()); level++)
+    {
+      rm::set_simd_level(static_cast<rm::SimdLevel>(level));
+      const std::string name = std::string(rm::simd_level_name(rm::simd_level())) 
+        + " N=" + std::to_string(N);
+
+      check(X, ref_T, rm::mult1xN(T, X), T[0].t, name + " Transform");
+      check(X, ref_M, rm::mult1xN(M, X), {0.0, 0.0, 0.0}, name + " Matrix3x3");
+      check(X, ref_Q, rm::mult1xN(Q, X), {0.0, 0.0, 0.0}, name + " Quaternion");
+
+      // in place
+      rm::Memory<rm::Vector, rm::RAM> Y = X;
+      rm::mult1xN(T, Y, Y);
+      check(X, ref_T, Y, T[0].t, name + " Transform in place");
+    }
+  }
+
+  // runtime
+  rm::Memory<rm::Vector, rm::RAM> X(10000000), Y(10000000);
+  for(size_t i=0; i<X.size(); i++)
+  {
+    X[i] = {dist(gen), dist(gen), dist(gen)};
+  }
+
+  rm::StopWatch sw;
+  for(int level = 0; level <= static_cast<int>(rm::simd_level_supported()); level++)
+  {
+    rm::set_simd_level(static_cast<rm::SimdLevel>(level));
+    rm::mult1xN(T, X, Y); // warm up
+    sw();
+    rm::mult1xN(T, X, Y);
+    const double el = sw();
+    std::cout << "- " << rm::simd_level_name(rm::simd_level()) << ": " 
+      << X.size() << " points in " << el * 1000.0 << "ms" << std::endl;
+  }
+
+  return 0;
+}
@@ -0,0 +1,200 @@
+#include <iostream>
+#include <random>
+#include <limits>
+
+#include <rmagine/math/types.h>
+#include <rmagine/math/memory_math.h>
+#include <rmagine/math/statistics.h>
+#include <rmagine/types/VectorSoA.hpp>
+#include <rmagine/types/PointCloud.hpp>
+#include <rmagine/util/exceptions.h>
+#include <rmagine/util/StopWatch.hpp>
+#include <rmagine/util/prints.h>
+
+namespace rm = rmagine;
+
+size_t n_points = 1000003; // not a multiple of the block sizes
+
+void expect_near(const rm::Vector& a, const rm::Vector& b, float eps, std::string name)
+{
+  if((a - b).l2norm() > eps)
+  {
+    std::cout << a << " != " << b << std::endl;
+    RM_THROW(rm::Exception, name + " differs");
+  }
+}
+
+void expect_near(const rm::Matrix3x3& a, const rm::Matrix3x3& b, float eps, std::string name)
+{
+  for(size_t i=0; i<3; i++)
+  {
+    for(size_t j=0; j<3; j++)
+    {
+      if(fabs(a(i,j) - b(i,j)) > eps)
+      {
+        std::cout << a << " != " << b << std::endl;
+        RM_THROW(rm::Exception, name + " differs");
+      }
+    }
+  }
+}
+
+void expect_equal(const rm::MemoryView<rm::Vector, rm::RAM>& a, const rm::VectorSoAView& b, std::string name)
+{
+  for(size_t i=0; i<a.size(); i++)
+  {
+    expect_near(a[i], {b.x[i], b.y[i], b.z[i]}, 0.0001, name);
+  }
+}
+
+void expect_equal(const rm::CrossStatistics& a, const rm::CrossStatistics& b, float eps, std::string name)
+{
+  if(a.n_meas != b.n_meas)
+  {
+    RM_THROW(rm::Exception, name + ": number of measurements differ");
+  }
+  expect_near(a.dataset_mean, b.dataset_mean, eps, name + " dataset mean");
+  expect_near(a.model_mean, b.model_mean, eps, name + " model mean");
+  expect_near(a.covariance, b.covariance, eps, name + " covariance");
+}
+
+// serial reference in double precision
+rm::CrossStatistics reference_stats(
+  const rm::Transform& Tpre,
+  const rm::PointCloudView& dataset,
+  const rm::PointCloudView& model,
+  const rm::UmeyamaReductionConstraints& params,
+  bool p2l)
+{
+  rm::CrossStatisticsd acc = rm::CrossStatisticsd::Identity();
+  for(size_t i=0; i<dataset.points.size(); i++)
+  {
+    if(dataset.mask[i] == 0)
+    {
+      continue;
+    }
+
+    const rm::Vector Di = Tpre * dataset.points[i];
+    rm::Vector Mi = model.points[i];
+    float dist = (Mi - Di).l2norm();
+    if(p2l)
+    {
+      const rm::Vector Ni = model.normals[i];
+      dist = (Mi - Di).dot(Ni);
+      Mi = Di + Ni * dist;
+    }
+
+    if(fabs(dist) < params.max_dist)
+    {
+      acc += rm::CrossStatisticsd::Init(Di.cast<double>(), Mi.cast<double>());
+    }
+  }
+
+  rm::CrossStatistics ret;
+  ret.dataset_mean = acc.dataset_mean.cast<float>();
+  ret.model_mean = acc.model_mean.cast<float>();
+  ret.covariance = acc.covariance.cast<float>();
+  ret.n_meas = acc.n_meas;
+  return ret;
+}
+
+int main(int argc, char** argv)
+{
+  std::cout << "RMAGINE CORE MATH SOA" << std::endl;
+
+  std::mt19937 gen(42);
+  std::uniform_real_distribution<float> dist(-10.0, 10.0);
+
+  rm::Memory<rm::Vector, rm::RAM> A(n_points), B(n_points), N(n_points);
+  rm::Memory<uint8_t, rm::RAM> mask(n_points);
+  for(size_t i=0; i<n_points; i++)
+  {
+    A[i] = {dist(gen) + 100.0f, dist(gen), dist(gen)};
+    B[i] = A[i] + rm::Vector{dist(gen), dist(gen), dist(gen)} * 0.01;
+    N[i] = rm::Vector{dist(gen), dist(gen), dist(gen)}.normalize();
+    mask[i] = (i % 7 != 0);
+  }
+
+  // misses of a simulation are NaN
+  for(size_t i=0; i<n_points; i += 13)
+  {
+    B[i].x = std::numeric_limits<float>::quiet_NaN();
+    N[i].x = std::numeric_limits<float>::quiet_NaN();
+  }
+
+  rm::VectorSoA As = rm::to_soa(A);
+  rm::VectorSoA Bs = rm::to_soa(B);
+  rm::VectorSoA Ns = rm::to_soa(N);
+
+  expect_equal(A, As, "to_soa");
+  rm::Memory<rm::Vector, rm::RAM> A_back = rm::to_aos(As);
+  expect_equal(A_back, As, "to_aos");
+
+  // element-wise
+  rm::Memory<rm::Transform, rm::RAM> T(1);
+  T[0].R = rm::EulerAngles{0.1, -0.2, 0.3};
+  T[0].t = {1.0, 2.0, 3.0};
+  expect_equal(rm::mult1xN(T, A), rm::mult1xN(T, As), "mult1xN");
+
+  rm::Memory<rm::Matrix3x3, rm::RAM> M(1);
+  M[0] = T[0].R;
+  expect_equal(rm::mult1xN(M, A), rm::mult1xN(M, As), "mult1xN(Matrix3x3)");
+  
+  expect_equal(rm::addNxN(A, N), rm::addNxN(As, Ns), "addNxN");
+  expect_equal(rm::subNxN(A, N), rm::subNxN(As, Ns), "subNxN");
+  expect_equal(rm::sub(A, T[0].t), rm::sub(As, T[0].t), "sub");
+
+  // in place
+  rm::VectorSoA Cs = As;
+  rm::mult1xN(T, Cs, Cs);
+  expect_equal(rm::mult1xN(T, A), Cs, "mult1xN in place");
+
+  // reductions
+  // serial float sums of the AoS version drift for 1M points, compare to double
+  rm::Vector3d sum_ref = {0.0, 0.0, 0.0};
+  for(size_t i=0; i<n_points; i++)
+  {
+    sum_ref += A[i].cast<double>();
+  }
+  const rm::Vector mean_ref = (sum_ref / static_cast<double>(n_points)).cast<float>();
+  expect_near(mean_ref, rm::mean(As)[0], 0.0005, "mean");
+  expect_near(rm::cov(N, N)[0], rm::cov(Ns, Ns)[0], 0.001, "cov");
+
+  // statistics
+  rm::PointCloudView dataset = {.points = A, .mask = mask};
+  rm::PointCloudView model = {.points = B, .normals = N};
+  rm::PointCloudSoAView dataset_soa = {.points = As, .mask = mask};
+  rm::PointCloudSoAView model_soa = {.points = Bs, .normals = Ns};
+
+  rm::UmeyamaReductionConstraints params;
+  params.max_dist = 0.1;
+
+  rm::Transform Tpre = rm::Transform::Identity();
+  Tpre.t.x = 0.01;
+
+  rm::StopWatch sw;
+  double el_aos, el_soa;
+
+  sw();
+  rm::CrossStatistics p2p = rm::statistics_p2p(Tpre, dataset, model, params);
+  el_aos = sw();
+  rm::CrossStatistics p2p_soa = rm::statistics_p2p(Tpre, dataset_soa, model_soa, params);
+  el_soa = sw();
+  // the incremental merge of the AoS version drifts in float for many points
+  expect_equal(p2p, p2p_soa, 0.1, "statistics_p2p AoS/SoA");
+  expect_equal(reference_stats(Tpre, dataset, model, params, false), p2p_soa, 0.001, "statistics_p2p");
+  std::cout << "- statistics_p2p: " << p2p.n_meas << " correspondences. AoS: " 
+    << el_aos * 1000.0 << "ms, SoA: " << el_soa * 1000.0 << "ms" << std::endl;
+
+  sw();
+  rm::CrossStatistics p2l = rm::statistics_p2l(Tpre, dataset, model, params);
+  el_aos = sw();
+  rm::CrossStatistics p2l_soa = rm::statistics_p2l(Tpre, dataset_soa, model_soa, params);
+  el_soa = sw();
+  expect_equal(p2l, p2l_soa, 0.1, "statistics_p2l AoS/SoA");
+  expect_equal(reference_stats(Tpre, dataset, model, params, true), p2l_soa, 0.001, "statistics_p2l");
+  std::cout << "- statistics_p2l: " << p2l.n_meas << " correspondences. AoS: " 
+    << el_aos * 1000.0 << "ms, SoA: " << el_soa * 1000.0 << "ms" << std::endl;
+
+  return 0;
+}
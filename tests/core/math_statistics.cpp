@@ -15,6 +15,7 @@
 
 #include <algorithm>
 #include <random>
+#include <limits>
 
 
 
@@ -660,6 +661,154 @@ void test_p2l()
   if(stats.n_meas != 0){throw std::runtime_error("ERROR: Too many points");}
 }
 
+void expect_equal(const rm::CrossStatistics& a, const rm::CrossStatistics& b)
+{
+  if(a.n_meas != b.n_meas){throw std::runtime_error("ERROR: number of measurements differ");}
+  if((a.dataset_mean - b.dataset_mean).l2norm() > 0.0001){throw std::runtime_error("ERROR: dataset mean differs");}
+  if((a.model_mean - b.model_mean).l2norm() > 0.0001){throw std::runtime_error("ERROR: model mean differs");}
+  for(size_t i=0; i<3; i++)
+  {
+    for(size_t j=0; j<3; j++)
+    {
+      if(fabs(a.covariance(i,j) - b.covariance(i,j)) > 0.0001){throw std::runtime_error("ERROR: covariance differs");}
+    }
+  }
+}
+
+void test_p2l_ow()
+{
+  std::cout << "TEST P2L OBJECT-WISE" << std::endl;
+  rm::StopWatch sw;
+  double el;
+
+  const unsigned int width = 1024;
+  const unsigned int height = 128;
+  const size_t N = width * height;
+  const unsigned int n_objects = 2000;
+
+  std::mt19937 gen(42);
+  std::uniform_real_distribution<float> dist(-1.0, 1.0);
+
+  rm::Memory<rm::Vector3> dataset_points(N);
+  rm::Memory<rm::Vector3> model_points(N);
+  rm::Memory<rm::Vector3> model_normals(N);
+  rm::Memory<uint8_t> model_mask(N);
+  rm::Memory<unsigned int> model_ids(N);
+
+  for(size_t i=0; i<N; i++)
+  {
+    dataset_points[i] = {dist(gen), dist(gen), dist(gen)};
+    model_points[i] = dataset_points[i] + rm::Vector3{dist(gen), dist(gen), dist(gen)} * 0.1;
+    model_normals[i] = rm::Vector3{dist(gen), dist(gen), dist(gen)}.normalize();
+    model_mask[i] = (i % 5 != 0);
+    // every 7th measurement has no object
+    model_ids[i] = (i % 7 == 0) ? std::numeric_limits<unsigned int>::max() : (i / 13) % n_objects;
+  }
+
+  rm::Memory<rm::Transform> Tobj(n_objects);
+  for(size_t i=0; i<n_objects; i++)
+  {
+    Tobj[i] = rm::Transform::Identity();
+    Tobj[i].t = {dist(gen) * 0.01f, 0.0, 0.0};
+  }
+
+  rm::PointCloudView dataset = {.points = dataset_points};
+  rm::PointCloudView model = {.points = model_points, .mask = model_mask, .normals = model_normals, .ids = model_ids};
+
+  rm::UmeyamaReductionConstraints params;
+  params.max_dist = 0.1;
+  params.dataset_id = 0;
+  params.model_id = 0;
+
+  // serial reference
+  std::vector<rm::CrossStatistics> stats_ref(n_objects, rm::CrossStatistics::Identity());
+  std::vector<rm::CrossStatistics> stats_ref_id(n_objects, rm::CrossStatistics::Identity());
+  for(size_t i=0; i<N; i++)
+  {
+    const unsigned int Oi = model_ids[i];
+    if(Oi >= n_objects || !model_mask[i])
+    {
+      continue;
+    }
+    const rm::Vector3 Di = dataset_points[i];
+    for(int pre=0; pre<2; pre++)
+    {
+      const rm::Transform T = (pre == 0) ? Tobj[Oi] : rm::Transform::Identity();
+      const rm::Vector3 Ii = T * model_points[i];
+      const rm::Vector3 Ni = T.R * model_normals[i];
+      const float signed_plane_dist = (Ii - Di).dot(Ni);
+      if(fabs(signed_plane_dist) < params.max_dist)
+      {
+        auto& target = (pre == 0) ? stats_ref[Oi] : stats_ref_id[Oi];
+        target += rm::CrossStatistics::Init(Di, Di + Ni * signed_plane_dist);
+      }
+    }
+  }
+
+  rm::Memory<rm::CrossStatistics> stats(n_objects);
+  sw();
+  rm::statistics_p2l_ow(dataset, model, Tobj, params, stats);
+  el = sw();
+  std::cout << "statistics_p2l_ow, " << n_objects << " objects: " << el << " s" << std::endl;
+
+  for(size_t i=0; i<n_objects; i++)
+  {
+    checkStats(stats[i]);
+    expect_equal(stats[i], stats_ref[i]);
+  }
+
+  // sparse
+  sw();
+  auto stats_map = rm::statistics_p2l_ow(rm::Transform::Identity(), dataset, model, params);
+  el = sw();
+  std::cout << "statistics_p2l_ow (sparse): " << el << " s" << std::endl;
+
+  for(size_t i=0; i<n_objects; i++)
+  {
+    auto it = stats_map.find(i);
+    if(stats_ref_id[i].n_meas == 0)
+    {
+      if(it != stats_map.end()){throw std::runtime_error("ERROR: object without correspondences in map");}
+    } else {
+      if(it == stats_map.end()){throw std::runtime_error("ERROR: object missing in map");}
+      expect_equal(it->second, stats_ref_id[i]);
+    }
+  }
+  if(stats_map.size() > n_objects){throw std::runtime_error("ERROR: too many objects in map");}
+
+  // bounding box variant: one box per image quarter, all of object 0
+  const unsigned int n_boxes = 4;
+  rm::Memory<rm::Transform> Tboxes(n_boxes);
+  rm::Memory<rm::UmeyamaReductionConstraints> box_params(n_boxes);
+  rm::Memory<rm::AABB> bboxes(n_boxes);
+  rm::Memory<rm::CrossStatistics> box_stats(n_boxes);
+  rm::Memory<unsigned int> zero_ids(N);
+  for(size_t i=0; i<N; i++)
+  {
+    zero_ids[i] = 0;
+  }
+  for(size_t b=0; b<n_boxes; b++)
+  {
+    Tboxes[b] = rm::Transform::Identity();
+    box_params[b] = params;
+    box_params[b].model_id = 0;
+    bboxes[b].min = {static_cast<float>((b % 2) * width / 2), static_cast<float>((b / 2) * height / 2), 0.0};
+    bboxes[b].max = {static_cast<float>((b % 2 + 1) * width / 2), static_cast<float>((b / 2 + 1) * height / 2), 0.0};
+  }
+
+  rm::PointCloudView model_zero = {.points = model_points, .mask = model_mask, .normals = model_normals, .ids = zero_ids};
+  rm::statistics_objectwise_p2l(Tboxes, dataset, model_zero, width, height, box_params, bboxes, box_stats);
+
+  rm::CrossStatistics box_sum = rm::CrossStatistics::Identity();
+  for(size_t b=0; b<n_boxes; b++)
+  {
+    checkStats(box_stats[b]);
+    box_sum += box_stats[b];
+  }
+  // the boxes cover the whole image
+  expect_equal(box_sum, rm::statistics_p2l(rm::Transform::Identity(), dataset, model_zero, params));
+}
+
 int main(int argc, char** argv)
 {
   srand((unsigned int) time(0));
@@ -678,6 +827,7 @@ int main(int argc, char** argv)
       
   test_p2p(); // down to 0.0341 s for 10000000 elements
   test_p2l();
+  test_p2l_ow();
 
   // compute_precision<float>(n_points);
   // compute_precision<double>(n_points);
@@ -0,0 +1,280 @@
+#include <iostream>
+#include <random>
+#include <algorithm>
+
+#include <rmagine/math/types.h>
+#include <rmagine/math/linalg.h>
+#include <rmagine/math/memory_math.h>
+#include <rmagine/math/optimization.h>
+#include <rmagine/math/simd.h>
+#include <rmagine/util/exceptions.h>
+#include <rmagine/util/StopWatch.hpp>
+#include <rmagine/util/prints.h>
+
+namespace rm = rmagine;
+
+float max_abs_diff(const rm::Matrix3x3& A, const rm::Matrix3x3& B)
+{
+  float ret = 0.0;
+  for(size_t i=0; i<3; i++)
+  {
+    for(size_t j=0; j<3; j++)
+    {
+      ret = std::max(ret, fabsf(A(i,j) - B(i,j)));
+    }
+  }
+  return ret;
+}
+
+float max_abs(const rm::Matrix3x3& A)
+{
+  return max_abs_diff(A, rm::Matrix3x3::Zeros());
+}
+
+void check_rotation(const rm::Matrix3x3& R, std::string name)
+{
+  if(max_abs_diff(R * R.transpose(), rm::Matrix3x3::Identity()) > 1e-5
+    || fabsf(R.det() - 1.0) > 1e-5)
+  {
+    std::cout << R << std::endl;
+    RM_THROW(rm::Exception, name + ": not a rotation");
+  }
+}
+
+void check_svd(
+  const rm::MemoryView<rm::Matrix3x3, rm::RAM>& A,
+  const rm::MemoryView<rm::Matrix3x3, rm::RAM>& U,
+  const rm::MemoryView<rm::Vector3, rm::RAM>& s,
+  const rm::MemoryView<rm::Matrix3x3, rm::RAM>& V,
+  std::string name)
+{
+  for(size_t i=0; i<A.size(); i++)
+  {
+    check_rotation(U[i], name + " U");
+    check_rotation(V[i], name + " V");
+
+    // repeated singular values may be unordered by rounding
+    const float tol = 1e-5 * s[i].x;
+    if(s[i].x < 0.0 || s[i].y < 0.0
+      || s[i].x + tol < s[i].y || s[i].y + tol < fabsf(s[i].z))
+    {
+      std::cout << i << ": " << s[i] << std::endl;
+      RM_THROW(rm::Exception, name + ": singular values not sorted");
+    }
+
+    if((s[i].z < 0.0) != (A[i].det() < 0.0) && fabsf(s[i].z) > 1e-4 * s[i].x)
+    {
+      RM_THROW(rm::Exception, name + ": sign of last singular value wrong");
+    }
+
+    rm::Matrix3x3 S = rm::Matrix3x3::Zeros();
+    S(0,0) = s[i].x;
+    S(1,1) = s[i].y;
+    S(2,2) = s[i].z;
+    const rm::Matrix3x3 A_rec = U[i] * S * V[i].transpose();
+    if(max_abs_diff(A[i], A_rec) > 1e-5 * std::max(1.0f, max_abs(A[i])))
+    {
+      std::cout << i << ": " << std::endl << A[i] << std::endl << A_rec << std::endl;
+      RM_THROW(rm::Exception, name + ": reconstruction out of tolerance");
+    }
+  }
+}
+
+int main(int argc, char** argv)
+{
+  std::cout << "RMAGINE CORE MATH SVD3" << std::endl;
+  std::cout << "- supported: " << rm::simd_level_name(rm::simd_level_supported()) << std::endl;
+
+  std::mt19937 gen(42);
+  std::uniform_real_distribution<float> dist(-10.0, 10.0);
+
+  // sizes around the lane counts, random and degenerate matrices
+  for(size_t N : {0, 1, 3, 4, 5, 15, 16, 17, 33, 100003})
+  {
+    rm::Memory<rm::Matrix3x3, rm::RAM> A(N);
+    for(size_t i=0; i<N; i++)
+    {
+      for(size_t r=0; r<3; r++)
+      {
+        for(size_t c=0; c<3; c++)
+        {
+          A[i](r,c) = dist(gen);
+        }
+      }
+
+      switch(i % 7)
+      {
+        case 1: // zero
+          A[i].setZeros();
+          break;
+        case 2: // rotation
+          A[i] = rm::EulerAngles{dist(gen), dist(gen), dist(gen)};
+          break;
+        case 3: // rank 1
+          for(size_t r=0; r<3; r++)
+          {
+            A[i](r,1) = 2.0 * A[i](r,0);
+            A[i](r,2) = -0.5 * A[i](r,0);
+          }
+          break;
+        case 4: // repeated singular values
+          A[i] = rm::EulerAngles{dist(gen), dist(gen), dist(gen)};
+          A[i] *= 1e-3;
+          break;
+        case 5: // reflection
+          A[i](0,0) = -A[i](0,0);
+          A[i](1,0) = -A[i](1,0);
+          A[i](2,0) = -A[i](2,0);
+          break;
+        default:
+          break;
+      }
+    }
+
+    rm::Memory<rm::Matrix3x3, rm::RAM> U(N), V(N);
+    rm::Memory<rm::Vector3, rm::RAM> s(N);
+
+    for(rm::SimdLevel level : {rm::SimdLevel::SCALAR, rm::SimdLevel::SSE4,
+                              rm::SimdLevel::AVX2, rm::SimdLevel::AVX512})
+    {
+      if(level > rm::simd_level_supported())
+      {
+        continue;
+      }
+      rm::set_simd_level(level);
+      rm::simd::svd3(A.raw(), U.raw(), s.raw(), V.raw(), N);
+      check_svd(A, U, s, V,
+        std::string("svd3 ") + rm::simd_level_name(level) + " N=" + std::to_string(N));
+    }
+
+    // single matrix overload: scalar, no dispatch
+    for(size_t i=0; i<N; i++)
+    {
+      rm::simd::svd3(A[i], U[i], s[i], V[i]);
+    }
+    check_svd(A, U, s, V, "svd3 single N=" + std::to_string(N));
+  }
+  rm::set_simd_level(rm::simd_level_supported());
+
+  // single svd: non-negative singular values, reflections stay in U V^T
+  {
+    rm::Matrix3x3 A;
+    A = rm::EulerAngles{0.3, -0.5, 1.2};
+    A(0,2) = -A(0,2);
+    A(1,2) = -A(1,2);
+    A(2,2) = -A(2,2);
+
+    rm::Matrix3x3 U, V;
+    rm::Vector3 w;
+    rm::svd(A, U, w, V);
+
+    if(w.x < 0.0 || w.y < 0.0 || w.z < 0.0)
+    {
+      RM_THROW(rm::Exception, "svd: negative singular values");
+    }
+
+    rm::Matrix3x3 W = rm::Matrix3x3::Zeros();
+    W(0,0) = w.x;
+    W(1,1) = w.y;
+    W(2,2) = w.z;
+    if(max_abs_diff(A, U * W * V.transpose()) > 1e-5)
+    {
+      RM_THROW(rm::Exception, "svd: reconstruction out of tolerance");
+    }
+  }
+
+  // batched umeyama recovers known rotations
+  {
+    const size_t N = 1000;
+    rm::Memory<rm::Transform, rm::RAM> T_gt(N);
+    rm::Memory<rm::Vector, rm::RAM> ds(N), ms(N);
+    rm::Memory<rm::Matrix3x3, rm::RAM> Cs(N);
+    rm::Memory<unsigned int, rm::RAM> n_meas(N);
+
+    for(size_t i=0; i<N; i++)
+    {
+      T_gt[i].R = rm::EulerAngles{dist(gen) * 0.3f, dist(gen) * 0.1f, dist(gen) * 0.3f};
+      T_gt[i].t = {dist(gen), dist(gen), dist(gen)};
+
+      // covariance of 4 points with their transformed partners
+      const rm::Vector P[4] = {{1.0, 0.0, 0.0}, {0.0, 2.0, 0.0}, {0.0, 0.0, 3.0}, {-1.0, -1.0, -1.0}};
+      rm::Vector d_mean = {0.0, 0.0, 0.0};
+      rm::Vector m_mean = {0.0, 0.0, 0.0};
+      for(size_t j=0; j<4; j++)
+      {
+        d_mean += P[j] / 4.0;
+        m_mean += (T_gt[i] * P[j]) / 4.0;
+      }
+      rm::Matrix3x3 C = rm::Matrix3x3::Zeros();
+      for(size_t j=0; j<4; j++)
+      {
+        C += (T_gt[i] * P[j] - m_mean).multT(P[j] - d_mean) / 4.0;
+      }
+
+      ds[i] = d_mean;
+      ms[i] = m_mean;
+      Cs[i] = C;
+      n_meas[i] = 4;
+    }
+
+    rm::Memory<rm::Transform, rm::RAM> Ts = rm::umeyama_transform(ds, ms, Cs, n_meas);
+    for(size_t i=0; i<N; i++)
+    {
+      const rm::Transform Tdiff = ~T_gt[i] * Ts[i];
+      if(Tdiff.t.l2norm() > 1e-3 || fabsf(Tdiff.R.w) < 1.0 - 1e-5)
+      {
+        std::cout << i << ": " << T_gt[i] << " != " << Ts[i] << std::endl;
+        RM_THROW(rm::Exception, "umeyama_transform: wrong transform");
+      }
+    }
+  }
+
+  // runtimes
+  {
+    const size_t N = 1000000;
+    rm::Memory<rm::Matrix3x3, rm::RAM> A(N), U(N), V(N);
+    rm::Memory<rm::Vector3, rm::RAM> s(N);
+    for(size_t i=0; i<N; i++)
+    {
+      for(size_t r=0; r<3; r++)
+      {
+        for(size_t c=0; c<3; c++)
+        {
+          A[i](r,c) = dist(gen);
+        }
+      }
+    }
+
+    rm::StopWatch sw;
+    double el;
+    for(rm::SimdLevel level : {rm::SimdLevel::SCALAR, rm::SimdLevel::SSE4,
+                              rm::SimdLevel::AVX2, rm::SimdLevel::AVX512})
+    {
+      if(level > rm::simd_level_supported())
+      {
+        continue;
+      }
+      rm::set_simd_level(level);
+      sw();
+      rm::simd::svd3(A.raw(), U.raw(), s.raw(), V.raw(), N);
+      el = sw();
+      std::cout << "- svd3 " << rm::simd_level_name(level) << ": " << el * 1000.0 << "ms" << std::endl;
+    }
+    rm::set_simd_level(rm::simd_level_supported());
+
+    sw();
+    rm::svd(A, U, s, V);
+    el = sw();
+    std::cout << "- svd batched: " << el * 1000.0 << "ms" << std::endl;
+
+    sw();
+    for(size_t i=0; i<N; i++)
+    {
+      rm::simd::svd3(A[i], U[i], s[i], V[i]);
+    }
+    el = sw();
+    std::cout << "- svd3 single: " << el * 1000.0 << "ms" << std::endl;
+  }
+
+  return 0;
+}
@@ -0,0 +1,124 @@
+#include <iostream>
+#include <vector>
+#include <cstdint>
+
+#include <rmagine/types/Memory.hpp>
+#include <rmagine/types/MemoryHuge.hpp>
+#include <rmagine/math/types.h>
+#include <rmagine/util/exceptions.h>
+#include <rmagine/util/prints.h>
+
+namespace rm = rmagine;
+
+bool is_aligned(const void* ptr)
+{
+  return reinterpret_cast<std::uintptr_t>(ptr) % rm::huge::HUGE_PAGE_SIZE == 0;
+}
+
+void fill(rm::MemoryView<rm::Vector, rm::RAM_HUGE>& a, size_t offset)
+{
+  for(size_t i=0; i<a.size(); i++)
+  {
+    a[i] = {static_cast<float>(i + offset), 0.0, 1.0};
+  }
+}
+
+void check(const rm::MemoryView<rm::Vector, rm::RAM>& a, size_t offset, std::string name)
+{
+  for(size_t i=0; i<a.size(); i++)
+  {
+    if(a[i].x != static_cast<float>(i + offset) || a[i].z != 1.0)
+    {
+      RM_THROW(rm::Exception, name + " wrong");
+    }
+  }
+}
+
+void test_huge(bool prefault)
+{
+  rm::huge::set_prefault(prefault);
+
+  // ~24 MB
+  const size_t N = 2000000;
+  rm::Memory<rm::Vector, rm::RAM_HUGE> a(N);
+  if(!is_aligned(a.raw()))
+  {
+    RM_THROW(rm::Exception, "RAM_HUGE memory is not aligned to huge pages");
+  }
+
+  fill(a, 0);
+
+  // RAM_HUGE -> RAM
+  rm::Memory<rm::Vector, rm::RAM> b = a;
+  check(b, 0, "RAM_HUGE -> RAM");
+
+  // slicing + RAM -> RAM_HUGE
+  rm::Memory<rm::Vector, rm::RAM_HUGE> c(N);
+  rm::MemoryView<rm::Vector, rm::RAM_HUGE> c_slice = c(1000, 2000);
+  c_slice = b(5000, 6000);
+  rm::Memory<rm::Vector, rm::RAM> c_back = c(1000, 2000);
+  check(c_back, 5000, "RAM -> RAM_HUGE slice");
+
+  // RAM_HUGE -> RAM_HUGE
+  rm::Memory<rm::Vector, rm::RAM_HUGE> d = a;
+  rm::Memory<rm::Vector, rm::RAM> d_back = d;
+  check(d_back, 0, "RAM_HUGE -> RAM_HUGE");
+
+  // grow and shrink keep the data
+  a.resize(3 * N);
+  if(!is_aligned(a.raw()))
+  {
+    RM_THROW(rm::Exception, "RAM_HUGE memory is not aligned to huge pages after growing");
+  }
+  rm::Memory<rm::Vector, rm::RAM> a_grown = a(0, N);
+  check(a_grown, 0, "RAM_HUGE grow");
+  rm::MemoryView<rm::Vector, rm::RAM_HUGE> a_new = a(N, 3 * N);
+  fill(a_new, N);
+
+  a.resize(N / 2);
+  rm::Memory<rm::Vector, rm::RAM> a_shrunk = a;
+  check(a_shrunk, 0, "RAM_HUGE shrink");
+
+  std::cout << "- RAM_HUGE (prefault: " << prefault << ") correct" << std::endl;
+}
+
+// growing a mapping that cannot be extended in place moves it
+void test_huge_moved()
+{
+  const size_t bytes = rm::huge::HUGE_PAGE_SIZE;
+  std::vector<void*> blocks;
+  for(size_t i=0; i<16; i++)
+  {
+    blocks.push_back(rm::huge::allocate(bytes));
+    static_cast<char*>(blocks.back())[0] = static_cast<char>(i);
+  }
+
+  for(size_t i=0; i<blocks.size(); i++)
+  {
+    blocks[i] = rm::huge::reallocate(blocks[i], bytes, 5 * bytes + 1);
+    if(!is_aligned(blocks[i]) || static_cast<char*>(blocks[i])[0] != static_cast<char>(i))
+    {
+      RM_THROW(rm::Exception, "huge::reallocate: moved mapping not aligned or data lost");
+    }
+  }
+
+  for(void* block : blocks)
+  {
+    rm::huge::deallocate(block, 5 * bytes + 1);
+  }
+
+  std::cout << "- huge::reallocate keeps the alignment" << std::endl;
+}
+
+int main(int argc, char** argv)
+{
+  std::cout << "RMAGINE CORE MEMORY HUGE" << std::endl;
+
+  test_huge(false);
+  test_huge(true);
+  test_huge_moved();
+
+  rm::huge::set_prefault(false);
+
+  return 0;
+}
@@ -0,0 +1,171 @@
+#include <iostream>
+#include <thread>
+#include <vector>
+#include <cstdint>
+
+#include <rmagine/types/Memory.hpp>
+#include <rmagine/types/MemoryPooled.hpp>
+#include <rmagine/math/types.h>
+#include <rmagine/util/exceptions.h>
+#include <rmagine/util/prints.h>
+
+namespace rm = rmagine;
+
+bool is_aligned(const void* ptr)
+{
+  return reinterpret_cast<std::uintptr_t>(ptr) % rm::pooled::ALIGNMENT == 0;
+}
+
+void test_alignment()
+{
+  for(size_t N : {1, 3, 17, 100, 1000, 12345})
+  {
+    rm::Memory<rm::Vector, rm::RAM_POOLED> a(N);
+    if(!is_aligned(a.raw()))
+    {
+      RM_THROW(rm::Exception, "RAM_POOLED memory is not 64 byte aligned");
+    }
+  }
+  std::cout << "- alignment correct" << std::endl;
+}
+
+void test_reuse()
+{
+  rm::pooled::release();
+
+  rm::Vector* first = nullptr;
+  {
+    rm::Memory<rm::Vector, rm::RAM_POOLED> a(10000);
+    first = a.raw();
+  }
+
+  const rm::pooled::PoolStats stats_before = rm::pooled::stats();
+
+  // same size class: the freed block has to be reused
+  for(size_t frame = 0; frame < 10; frame++)
+  {
+    rm::Memory<rm::Vector, rm::RAM_POOLED> a(9999);
+    if(a.raw() != first)
+    {
+      RM_THROW(rm::Exception, "RAM_POOLED block was not reused");
+    }
+  }
+
+  const rm::pooled::PoolStats stats_after = rm::pooled::stats();
+  if(stats_after.misses != stats_before.misses 
+    || stats_after.hits != stats_before.hits + 10)
+  {
+    RM_THROW(rm::Exception, "RAM_POOLED statistics wrong");
+  }
+
+  if(stats_after.used_bytes != 0)
+  {
+    RM_THROW(rm::Exception, "RAM_POOLED leaks blocks");
+  }
+
+  rm::pooled::release();
+  if(rm::pooled::stats().cached_bytes != 0)
+  {
+    RM_THROW(rm::Exception, "RAM_POOLED release failed");
+  }
+
+  std::cout << "- reuse correct" << std::endl;
+}
+
+void test_resize_and_copy()
+{
+  rm::Memory<float, rm::RAM> src(1000);
+  for(size_t i=0; i<src.size(); i++)
+  {
+    src[i] = i;
+  }
+
+  rm::Memory<float, rm::RAM_POOLED> dst;
+  dst = src;
+
+  // grow across several size classes
+  dst.resize(5000);
+  for(size_t i=0; i<1000; i++)
+  {
+    if(dst[i] != static_cast<float>(i))
+    {
+      RM_THROW(rm::Exception, "RAM_POOLED resize lost data");
+    }
+  }
+
+  if(!is_aligned(dst.raw()))
+  {
+    RM_THROW(rm::Exception, "RAM_POOLED resize broke alignment");
+  }
+
+  // views and slices work like on RAM
+  rm::MemoryView<float, rm::RAM_POOLED> slice = dst(500, 1000);
+  rm::Memory<float, rm::RAM> back(slice.size());
+  back = slice;
+  for(size_t i=0; i<back.size(); i++)
+  {
+    if(back[i] != static_cast<float>(i + 500))
+    {
+      RM_THROW(rm::Exception, "RAM_POOLED -> RAM copy wrong");
+    }
+  }
+
+  rm::Memory<float, rm::RAM_POOLED> dst2 = dst;
+  if(dst2.raw() == dst.raw() || dst2[999] != 999.0)
+  {
+    RM_THROW(rm::Exception, "RAM_POOLED -> RAM_POOLED copy wrong");
+  }
+
+  std::cout << "- resize and copy correct" << std::endl;
+}
+
+void test_threads()
+{
+  const size_t Nthreads = 8;
+  std::vector<std::thread> threads;
+  for(size_t t=0; t<Nthreads; t++)
+  {
+    threads.emplace_back([t]()
+    {
+      for(size_t it=0; it<1000; it++)
+      {
+        rm::Memory<unsigned int, rm::RAM_POOLED> a(100 + (it * 37 + t) % 5000);
+        for(size_t i=0; i<a.size(); i++)
+        {
+          a[i] = t;
+        }
+        for(size_t i=0; i<a.size(); i++)
+        {
+          if(a[i] != t)
+          {
+            RM_THROW(rm::Exception, "RAM_POOLED block shared between threads");
+          }
+        }
+      }
+    });
+  }
+
+  for(auto& thread : threads)
+  {
+    thread.join();
+  }
+
+  if(rm::pooled::stats().used_bytes != 0)
+  {
+    RM_THROW(rm::Exception, "RAM_POOLED leaks blocks");
+  }
+
+  std::cout << "- threads correct" << std::endl;
+}
+
+int main(int argc, char** argv)
+{
+  std::cout << "RMAGINE CORE MEMORY POOLED" << std::endl;
+
+  test_alignment();
+  test_reuse();
+  test_resize_and_copy();
+  test_threads();
+
+  return 0;
+}
@@ -0,0 +1,181 @@
+#include <iostream>
+#include <cmath>
+#include <memory>
+#include <algorithm>
+
+#include <rmagine/noise/philox.h>
+#include <rmagine/noise/GaussianNoise.hpp>
+#include <rmagine/noise/RelGaussianNoise.hpp>
+#include <rmagine/noise/UniformDustNoise.hpp>
+#include <rmagine/types/Memory.hpp>
+#include <rmagine/util/exceptions.h>
+#include <rmagine/util/StopWatch.hpp>
+
+#include <tbb/task_arena.h>
+
+namespace rm = rmagine;
+
+size_t n_ranges = 1000003;
+
+void test_philox()
+{
+  std::cout << "- Philox4x32-10 known answers" << std::endl;
+
+  // known answer vectors of the Random123 library
+  const uint32_t ctrs[3][4] = {
+    {0, 0, 0, 0}, 
+    {0xffffffff, 0xffffffff, 0xffffffff, 0xffffffff}, 
+    {0x243f6a88, 0x85a308d3, 0x13198a2e, 0x03707344}};
+  const uint32_t keys[3][2] = {
+    {0, 0},
+    {0xffffffff, 0xffffffff},
+    {0xa4093822, 0x299f31d0}};
+  const uint32_t expected[3][4] = {
+    {0x6627e8d5, 0xe169c58d, 0xbc57ac4c, 0x9b00dbd8},
+    {0x408f276d, 0x41c83b0e, 0xa20bc7c6, 0x6d5451fd},
+    {0xd16cfe09, 0x94fdcceb, 0x5001e420, 0x24126ea1}};
+
+  for(size_t t=0; t<3; t++)
+  {
+    uint32_t out[4];
+    rm::philox4x32_10(ctrs[t], keys[t], out);
+    for(size_t i=0; i<4; i++)
+    {
+      if(out[i] != expected[t][i])
+      {
+        RM_THROW(rm::Exception, "Philox differs from known answer");
+      }
+    }
+  }
+}
+
+rm::Memory<float, rm::RAM> make_ranges()
+{
+  rm::Memory<float, rm::RAM> ranges(n_ranges);
+  for(size_t i=0; i<n_ranges; i++)
+  {
+    ranges[i] = 1.0 + static_cast<float>(i % 100) * 0.1;
+  }
+  return ranges;
+}
+
+void expect_equal(
+  const rm::MemoryView<float, rm::RAM>& a, 
+  const rm::MemoryView<float, rm::RAM>& b,
+  std::string name)
+{
+  for(size_t i=0; i<a.size(); i++)
+  {
+    // bitwise equal, including NaN
+    if(a[i] != b[i] && !(std::isnan(a[i]) && std::isnan(b[i])))
+    {
+      RM_THROW(rm::Exception, name + ": results differ");
+    }
+  }
+}
+
+void expect_near(
+  const rm::MemoryView<float, rm::RAM>& a, 
+  const rm::MemoryView<float, rm::RAM>& b,
+  std::string name)
+{
+  for(size_t i=0; i<a.size(); i++)
+  {
+    // the vectorized kernels may contract to FMA differently than single calls
+    if(fabs(a[i] - b[i]) > 1e-5 * std::max(1.0, fabs(a[i])) 
+      && !(std::isnan(a[i]) && std::isnan(b[i])))
+    {
+      RM_THROW(rm::Exception, name + ": results differ");
+    }
+  }
+}
+
+void test_reproducible(std::shared_ptr<rm::Noise> noise, std::string name)
+{
+  std::cout << "- " << name << std::endl;
+
+  rm::StopWatch sw;
+
+  // all threads
+  noise->reset();
+  rm::Memory<float, rm::RAM> ranges_par = make_ranges();
+  sw();
+  noise->apply(ranges_par);
+  double el = sw();
+  std::cout << "  " << n_ranges << " ranges: " << el * 1000.0 << "ms" << std::endl;
+
+  // one thread
+  noise->reset();
+  rm::Memory<float, rm::RAM> ranges_seq = make_ranges();
+  tbb::task_arena arena(1);
+  arena.execute([&]() { noise->apply(ranges_seq); });
+
+  expect_equal(ranges_par, ranges_seq, name + " (thread count)");
+
+  // single ranges
+  rm::Memory<float, rm::RAM> ranges_single = make_ranges();
+  for(size_t i=0; i<n_ranges; i++)
+  {
+    ranges_single[i] = noise->applyAt(ranges_single[i], i, 0);
+  }
+  expect_near(ranges_par, ranges_single, name + " (applyAt)");
+
+  // the next call draws new noise
+  rm::Memory<float, rm::RAM> ranges_next = make_ranges();
+  noise->apply(ranges_next);
+  size_t n_equal = 0;
+  for(size_t i=0; i<n_ranges; i++)
+  {
+    n_equal += (ranges_next[i] == ranges_par[i]);
+  }
+  if(noise->stream() != 2 || n_equal == n_ranges)
+  {
+    RM_THROW(rm::Exception, name + ": second call repeats the first one");
+  }
+}
+
+void test_gaussian_moments()
+{
+  std::cout << "- Gaussian moments" << std::endl;
+
+  rm::GaussianNoise noise(0.1, 0.5);
+  rm::Memory<float, rm::RAM> ranges(n_ranges);
+  for(size_t i=0; i<n_ranges; i++)
+  {
+    ranges[i] = 5.0;
+  }
+  noise.apply(ranges);
+
+  double sum = 0.0, sum2 = 0.0;
+  for(size_t i=0; i<n_ranges; i++)
+  {
+    const double d = ranges[i] - 5.0;
+    sum += d;
+    sum2 += d * d;
+  }
+  const double mean = sum / n_ranges;
+  const double stddev = sqrt(sum2 / n_ranges - mean * mean);
+  std::cout << "  mean: " << mean << ", stddev: " << stddev << std::endl;
+
+  if(fabs(mean - 0.1) > 0.005 || fabs(stddev - 0.5) > 0.005)
+  {
+    RM_THROW(rm::Exception, "wrong moments of Gaussian noise");
+  }
+}
+
+int main(int argc, char** argv)
+{
+  std::cout << "Rmagine Test: Noise" << std::endl;
+
+  test_philox();
+  test_gaussian_moments();
+
+  rm::Noise::Options opt;
+  opt.max_range = 8.0;
+  test_reproducible(std::make_shared<rm::GaussianNoise>(0.0, 0.1, opt), "GaussianNoise");
+  test_reproducible(std::make_shared<rm::RelGaussianNoise>(0.0, 0.01, 1.0, opt), "RelGaussianNoise");
+  test_reproducible(std::make_shared<rm::UniformDustNoise>(0.05, 0.5, opt), "UniformDustNoise");
+
+  std::cout << "Done." << std::endl;
+  return 0;
+}
@@ -4,6 +4,7 @@
 #include <rmagine/map/embree/embree_shapes.h>
 #include <rmagine/math/types.h>
 #include <rmagine/util/prints.h>
+#include <rmagine/util/exceptions.h>
 
 namespace rm = rmagine;
 
@@ -24,7 +25,7 @@ rm::EmbreeMapPtr make_map_1()
     return std::make_shared<rm::EmbreeMap>(cube_scene);;
 }
 
-// DOES NOT WORK YET
+// same as map 1, but the cube is placed via an instance
 rm::EmbreeMapPtr make_map_2()
 {
     rm::EmbreeScenePtr cube_scene = std::make_shared<rm::EmbreeScene>();
@@ -107,9 +108,201 @@ int main(int argc, char ** argv)
     cp = map->closestPoint(qp).p;
     std::cout << qp << " -> " << cp << std::endl;
     
+    // batched queries
+    rm::Memory<rm::Point, rm::RAM> qps(1000);
+    for(size_t i=0; i<qps.size(); i++)
+    {
+        qps[i] = {
+            -10.0f + 0.04f * static_cast<float>(i), 
+            -5.0f + 0.01f * static_cast<float>(i % 100), 
+            static_cast<float>(i % 10)};
+    }
+
+    rm::Memory<rm::EmbreeClosestPointResult, rm::RAM> cps = map->closestPoints(qps);
+
+    for(size_t i=0; i<qps.size(); i++)
+    {
+        const rm::EmbreeClosestPointResult cp_single = map->closestPoint(qps[i]);
+        if(cps[i].geomID != cp_single.geomID 
+            || cps[i].primID != cp_single.primID
+            || (cps[i].p - cp_single.p).l2norm() > 0.0001)
+        {
+            std::stringstream ss;
+            ss << "Batched closest point differs from single query " << i;
+            RM_THROW(rm::EmbreeException, ss.str());
+        }
+    }
 
+    std::cout << "Batched closest points match single queries" << std::endl;
 
+    // too few results for the queries are rejected
+    {
+        rm::Memory<rm::EmbreeClosestPointResult, rm::RAM> cps_short(qps.size() - 1);
+        rm::MemoryView<rm::EmbreeClosestPointResult, rm::RAM> cps_short_view = cps_short.slice(0, cps_short.size());
+        const rm::MemoryView<const rm::Point, rm::RAM> qps_view(qps.raw(), qps.size());
+        bool thrown = false;
+        try {
+            map->scene->closestPoints(qps_view, cps_short_view);
+        } catch(const rm::EmbreeException& e) {
+            thrown = true;
+        }
+        if(!thrown)
+        {
+            RM_THROW(rm::EmbreeException, "closestPoints accepted a too small result buffer");
+        }
+    }
+
+    // instanced scene without freeze
+    auto map_mesh = make_map_1();
+    auto map_inst = make_map_2();
+
+    rm::Memory<rm::EmbreeClosestPointResult, rm::RAM> cps_mesh = map_mesh->closestPoints(qps);
+    rm::Memory<rm::EmbreeClosestPointResult, rm::RAM> cps_inst = map_inst->closestPoints(qps);
+
+    for(size_t i=0; i<qps.size(); i++)
+    {
+        if(cps_inst[i].instID == RTC_INVALID_GEOMETRY_ID
+            || std::fabs(cps_inst[i].d - cps_mesh[i].d) > 0.0001
+            || (cps_inst[i].p - cps_mesh[i].p).l2norm() > 0.0001
+            || (cps_inst[i].primID == cps_mesh[i].primID 
+                && (cps_inst[i].n - cps_mesh[i].n).l2norm() > 0.0001))
+        {
+            std::stringstream ss;
+            ss << "Closest point in instanced scene differs from flat scene at query " << i;
+            RM_THROW(rm::EmbreeException, ss.str());
+        }
+    }
+
+    std::cout << "Closest points in instanced scene match flat scene" << std::endl;
+
+    // compacting an instanced mesh rebuilds the scenes above it
+    {
+        rm::EmbreeInstancePtr cube_inst = std::dynamic_pointer_cast<rm::EmbreeInstance>(
+            map_inst->scene->geometries().begin()->second);
+        const size_t instance_commits = cube_inst->scene()->commitStats().commits;
+        const size_t root_commits = map_inst->scene->commitStats().commits;
+
+        map_inst->scene->compact();
+
+        if(cube_inst->scene()->commitStats().commits != instance_commits + 1
+            || map_inst->scene->commitStats().commits != root_commits + 1)
+        {
+            RM_THROW(rm::EmbreeException, "Scenes of a compacted instanced mesh were not committed again");
+        }
+
+        rm::Memory<rm::EmbreeClosestPointResult, rm::RAM> cps_inst_compact = map_inst->closestPoints(qps);
+        for(size_t i=0; i<qps.size(); i++)
+        {
+            if(std::fabs(cps_inst_compact[i].d - cps_mesh[i].d) > 0.0001
+                || (cps_inst_compact[i].p - cps_mesh[i].p).l2norm() > 0.0001)
+            {
+                std::stringstream ss;
+                ss << "Closest point in compacted instanced scene differs from flat scene at query " << i;
+                RM_THROW(rm::EmbreeException, ss.str());
+            }
+        }
+    }
+
+    // compacted mesh: single vertex buffer, face normals computed on demand
+    rm::EmbreeSceneSettings settings;
+    settings.compact = true;
+    rm::EmbreeScenePtr compact_scene = std::make_shared<rm::EmbreeScene>(settings);
+    rm::EmbreeMeshPtr compact_mesh = std::make_shared<rm::EmbreeCube>();
+    {
+        rm::Transform T = rm::Transform::Identity();
+        T.t.z = 5.0;
+        compact_mesh->setTransform(T);
+        compact_mesh->apply();
+        compact_mesh->commit();
+        compact_scene->add(compact_mesh);
+    }
+
+    const size_t bytes_before = compact_scene->bytes();
+    compact_scene->freeze();
+    compact_scene->commit();
+
+    if(!compact_mesh->compacted() || compact_mesh->faceNormalsTransformed().size() != 0)
+    {
+        RM_THROW(rm::EmbreeException, "Mesh was not compacted on freeze");
+    }
+
+    std::cout << "Compacted buffers: " << bytes_before << " -> " << compact_scene->bytes() << " bytes" << std::endl;
+    if(compact_scene->bytes() >= bytes_before 
+        || compact_scene->bytes() != compact_mesh->bytes())
+    {
+        RM_THROW(rm::EmbreeException, "Compacting did not reduce the buffer sizes");
+    }
+
+    // memory and build instrumentation
+    const rm::EmbreeCommitStats& stats = compact_scene->commitStats();
+    std::cout << "Commits: " << stats.commits << ", last " << stats.last_time * 1000.0 << "ms" 
+        << ", embree device: " << compact_scene->device()->bytes() << " bytes" << std::endl;
+    if(stats.commits != 1 || stats.last_time < 0.0 || compact_scene->device()->bytes() == 0)
+    {
+        RM_THROW(rm::EmbreeException, "Commit statistics not recorded");
+    }
+
+    auto map_compact = std::make_shared<rm::EmbreeMap>(compact_scene);
+    rm::Memory<rm::EmbreeClosestPointResult, rm::RAM> cps_compact = map_compact->closestPoints(qps);
+    for(size_t i=0; i<qps.size(); i++)
+    {
+        if(std::fabs(cps_compact[i].d - cps_mesh[i].d) > 0.0001
+            || (cps_compact[i].p - cps_mesh[i].p).l2norm() > 0.0001
+            || (cps_compact[i].primID == cps_mesh[i].primID 
+                && (cps_compact[i].n - cps_mesh[i].n).l2norm() > 0.0001))
+        {
+            std::stringstream ss;
+            ss << "Closest point in compacted scene differs from flat scene at query " << i;
+            RM_THROW(rm::EmbreeException, ss.str());
+        }
+    }
+
+    // transforms are relative to the compacted pose
+    {
+        const rm::Vector v0 = compact_mesh->verticesTransformed()[0];
+        rm::Transform T = rm::Transform::Identity();
+        T.t.x = 1.0;
+        compact_mesh->setTransform(T);
+        compact_mesh->apply();
+        compact_mesh->commit();
+        compact_scene->commit();
+        if(compact_mesh->compacted() 
+            || (compact_mesh->verticesTransformed()[0] - v0 - T.t).l2norm() > 0.0001)
+        {
+            RM_THROW(rm::EmbreeException, "Transform of compacted mesh not applied");
+        }
+
+        // compact -> expand -> transform: face normals are available again
+        T.R = rm::EulerAngles{0.0, 0.0, M_PI / 2.0};
+        compact_mesh->setTransform(T);
+        compact_mesh->apply();
+        compact_mesh->commit();
+        compact_scene->commit();
+
+        rm::MemoryView<const rm::Vector, rm::RAM> normals = compact_mesh->faceNormalsTransformed();
+        if(normals.size() != compact_mesh->faces().size())
+        {
+            RM_THROW(rm::EmbreeException, "Face normals missing after expanding a compacted mesh");
+        }
+
+        rm::MemoryView<const rm::Vertex, rm::RAM> vertices = compact_mesh->verticesTransformed();
+        rm::MemoryView<rm::Face, rm::RAM> faces = compact_mesh->faces();
+        for(size_t i=0; i<faces.size(); i++)
+        {
+            const rm::Vertex a = vertices[faces[i].v0];
+            const rm::Vertex b = vertices[faces[i].v1];
+            const rm::Vertex c = vertices[faces[i].v2];
+            const rm::Vector n = (b - a).cross(c - a).normalize();
+            if((normals[i] - n).l2norm() > 0.0001)
+            {
+                std::stringstream ss;
+                ss << "Wrong face normal " << i << " after expanding a compacted mesh";
+                RM_THROW(rm::EmbreeException, ss.str());
+            }
+        }
+    }
 
+    std::cout << "Closest points in compacted scene match flat scene" << std::endl;
 
     return 0;
 }
\ No newline at end of file
@@ -0,0 +1,110 @@
+#include <iostream>
+#include <memory>
+#include <cassert>
+#include <sstream>
+
+#include <rmagine/map/EmbreeMap.hpp>
+#include <rmagine/map/embree/embree_shapes.h>
+#include <rmagine/map/embree/EmbreeScene.hpp>
+
+#include <rmagine/simulation/SphereSimulatorEmbree.hpp>
+#include <rmagine/types/sensors.h>
+
+#include <rmagine/math/statistics.h>
+#include <rmagine/math/statistics_embree.h>
+#include <rmagine/math/linalg.h>
+#include <rmagine/math/optimization.h>
+
+#include <rmagine/util/prints.h>
+#include <rmagine/util/exceptions.h>
+
+
+namespace rm = rmagine;
+
+rm::EmbreeMapPtr make_map()
+{
+    rm::EmbreeScenePtr scene = std::make_shared<rm::EmbreeScene>();
+
+    rm::EmbreeGeometryPtr mesh = std::make_shared<rm::EmbreeCube>();
+    mesh->apply();
+    mesh->commit();
+    scene->add(mesh);
+    scene->commit();
+
+    return std::make_shared<rm::EmbreeMap>(scene);
+}
+
+rm::SphericalModel define_sensor_model()
+{
+    rm::SphericalModel model;
+    model.theta.min = -M_PI;
+    model.theta.inc = 1.0 * DEG_TO_RAD_F;
+    model.theta.size = 360;
+
+    model.phi.min = -64.0 * DEG_TO_RAD_F;
+    model.phi.inc = 4.0 * DEG_TO_RAD_F;
+    model.phi.size = 32;
+    
+    model.range.min = 0.5;
+    model.range.max = 130.0;
+    return model;
+}
+
+int main(int argc, char** argv)
+{
+    std::cout << "Correction Embree closest points + CPU optimization" << std::endl;
+
+    rm::EmbreeMapPtr map = make_map();
+
+    // create a dataset. Only the points are used afterwards
+    rm::SphereSimulatorEmbree sim(map);
+    auto sensor_model = define_sensor_model();
+    sim.setModel(sensor_model);
+
+    rm::Transform Tbm_gt = rm::Transform::Identity();
+
+    rm::IntAttrAll<rm::RAM> dataset = sim.simulate<rm::IntAttrAll<rm::RAM> >(rm::make_view(Tbm_gt));
+
+    rm::PointCloudView cloud_dataset = {
+        .points = dataset.points,
+        .mask = dataset.hits
+    };
+
+    rm::UmeyamaReductionConstraints params;
+    params.max_dist = 1.0;
+
+    // closest points of the unperturbed dataset lie on the mesh
+    rm::CrossStatistics stats_gt = rm::statistics_p2p(Tbm_gt, cloud_dataset, map, params);
+    if(stats_gt.n_meas == 0 || (stats_gt.dataset_mean - stats_gt.model_mean).l2norm() > 0.001)
+    {
+        RM_THROW(rm::EmbreeException, "Dataset does not lie on the map");
+    }
+
+    // pose of robot
+    rm::Transform Tbm_est = rm::Transform::Identity();
+    // perturbe the pose
+    Tbm_est.t.z = 0.1;
+    Tbm_est.R = rm::EulerAngles{0.0, 0.0, 0.1};
+    
+    std::cout << "0: " << Tbm_est << " -> " << Tbm_gt << std::endl;
+
+    for(size_t i=0; i<30; i++)
+    {
+        // dataset in map frame -> closest points on map
+        rm::CrossStatistics stats = rm::statistics_p2l(Tbm_est, cloud_dataset, map, params);
+        rm::Transform Tcorr = rm::umeyama_transform(stats);
+        Tbm_est = Tcorr * Tbm_est;
+        std::cout << i+1 << ": " << Tbm_est << " -> " << Tbm_gt << std::endl;
+    }
+
+    auto Tdiff = ~Tbm_est * Tbm_gt;
+    const rm::EulerAngles Ediff = Tdiff.R;
+    if(fabs(Tdiff.t.z) > 0.01 || fabs(Ediff.yaw) > 0.01)
+    {
+        std::stringstream ss;
+        ss << "Unexpected Embree closest point correction results!";
+        RM_THROW(rm::EmbreeException, ss.str());
+    }
+
+    return 0;
+}
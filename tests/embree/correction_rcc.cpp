@@ -33,6 +33,31 @@ void printStats(rm::CrossStatistics_<DataT> stats)
     std::cout << "- n meas: " << stats.n_meas << std::endl; 
 }
 
+void checkStats(const rm::CrossStatistics& fused, const rm::CrossStatistics& ref)
+{
+    const float eps = 0.001;
+    bool equal = (fused.n_meas == ref.n_meas)
+        && (fused.dataset_mean - ref.dataset_mean).l2norm() < eps
+        && (fused.model_mean - ref.model_mean).l2norm() < eps;
+
+    for(size_t i=0; i<3; i++)
+    {
+        for(size_t j=0; j<3; j++)
+        {
+            equal = equal && fabs(fused.covariance(i,j) - ref.covariance(i,j)) < eps;
+        }
+    }
+
+    if(!equal)
+    {
+        std::cout << "Fused: " << std::endl;
+        printStats(fused);
+        std::cout << "Reference: " << std::endl;
+        printStats(ref);
+        RM_THROW(rm::EmbreeException, "Fused ray casting statistics differ from simulation + statistics");
+    }
+}
+
 rm::EmbreeMapPtr make_map()
 {
     rm::EmbreeScenePtr scene = std::make_shared<rm::EmbreeScene>();
@@ -158,6 +183,11 @@ int main(int argc, char** argv)
             {
               printStats(stats);
             }
+
+            // fused ray casting + reduction has to give the same statistics
+            checkStats(sim.statisticsP2L(Tbm_est, Tpre, cloud_dataset, params), stats);
+            checkStats(sim.statisticsP2P(Tbm_est, Tpre, cloud_dataset, params),
+              rm::statistics_p2p(Tpre, cloud_dataset, cloud_model, params));
             rm::Transform Tpre_next = rm::umeyama_transform(stats);
             Tpre = Tpre * Tpre_next;
         }
@@ -0,0 +1,129 @@
+#include <iostream>
+#include <vector>
+
+#include <rmagine/map/embree/EmbreeMesh.hpp>
+#include <rmagine/math/types.h>
+#include <rmagine/util/synthetic.h>
+#include <rmagine/util/exceptions.h>
+
+namespace rm = rmagine;
+
+// the serial transformation of EmbreeMesh::apply
+void apply_serial(
+    const rm::Transform& T,
+    const rm::Vector3& S,
+    const rm::MemoryView<rm::Vertex, rm::RAM>& vertices,
+    const rm::MemoryView<rm::Vector, rm::RAM>& face_normals,
+    const rm::MemoryView<rm::Vector, rm::RAM>& vertex_normals,
+    std::vector<rm::Vertex>& vertices_transformed,
+    std::vector<rm::Vector>& face_normals_transformed,
+    std::vector<rm::Vector>& vertex_normals_transformed)
+{
+    vertices_transformed.resize(vertices.size());
+    for(size_t i=0; i<vertices.size(); i++)
+    {
+        vertices_transformed[i] = T * (vertices[i].multEwise(S));
+    }
+
+    face_normals_transformed.resize(face_normals.size());
+    for(size_t i=0; i<face_normals.size(); i++)
+    {
+        face_normals_transformed[i] = T.R * face_normals[i].multEwise(S).normalize();
+    }
+
+    vertex_normals_transformed.resize(vertex_normals.size());
+    for(size_t i=0; i<vertex_normals.size(); i++)
+    {
+        vertex_normals_transformed[i] = T.R * vertex_normals[i].multEwise(S).normalize();
+    }
+}
+
+template<typename ArrayT>
+void check_equal(
+    const rm::MemoryView<const rm::Vector, rm::RAM>& a,
+    const ArrayT& b,
+    const std::string& what)
+{
+    if(a.size() != b.size())
+    {
+        RM_THROW(rm::EmbreeException, what + ": wrong size");
+    }
+    for(size_t i=0; i<a.size(); i++)
+    {
+        if((a[i] - b[i]).l2norm() > 0.0001)
+        {
+            RM_THROW(rm::EmbreeException, what + " differs from the serial result at " + std::to_string(i));
+        }
+    }
+}
+
+void check_apply(rm::EmbreeMeshPtr mesh, const std::string& what)
+{
+    std::vector<rm::Vertex> vertices;
+    std::vector<rm::Vector> face_normals;
+    std::vector<rm::Vector> vertex_normals;
+    apply_serial(mesh->transform(), mesh->scale(),
+        mesh->vertices(), mesh->faceNormals(), mesh->vertexNormals(),
+        vertices, face_normals, vertex_normals);
+
+    mesh->apply();
+
+    check_equal(mesh->verticesTransformed(), vertices, what + " vertices");
+    check_equal(mesh->faceNormalsTransformed(), face_normals, what + " face normals");
+    check_equal(mesh->vertexNormalsTransformed(), vertex_normals, what + " vertex normals");
+}
+
+int main(int argc, char** argv)
+{
+    std::cout << "RMAGINE EMBREE MESH APPLY" << std::endl;
+
+    // enough faces and vertices for several parallel blocks
+    std::vector<rm::Vector3> sphere_vertices;
+    std::vector<rm::Face> sphere_faces;
+    rm::genSphere(sphere_vertices, sphere_faces, 200, 100);
+
+    rm::EmbreeMeshPtr mesh = std::make_shared<rm::EmbreeMesh>(
+        sphere_vertices.size(), sphere_faces.size());
+
+    rm::MemoryView<rm::Vertex, rm::RAM> vertices = mesh->vertices();
+    rm::MemoryView<rm::Face, rm::RAM> faces = mesh->faces();
+    for(size_t i=0; i<sphere_vertices.size(); i++)
+    {
+        vertices[i] = sphere_vertices[i];
+    }
+    for(size_t i=0; i<sphere_faces.size(); i++)
+    {
+        faces[i] = sphere_faces[i];
+    }
+
+    mesh->computeFaceNormals();
+
+    // vertex normals of a sphere. not unit length
+    mesh->initVertexNormals();
+    rm::MemoryView<rm::Vector, rm::RAM> vertex_normals = mesh->vertexNormals();
+    for(size_t i=0; i<vertex_normals.size(); i++)
+    {
+        vertex_normals[i] = vertices[i] * 3.0f;
+    }
+
+    // 1. scaled and rotated
+    rm::Transform T;
+    T.R = rm::EulerAngles{0.1, -0.4, 1.2};
+    T.t = {1.0, -2.0, 3.0};
+    mesh->setTransform(T);
+    mesh->setScale({1.5, 0.5, 2.0});
+    check_apply(mesh, "scaled mesh:");
+
+    // 2. unit scale with face normals that are not unit length
+    rm::MemoryView<rm::Vector, rm::RAM> face_normals = mesh->faceNormals();
+    for(size_t i=0; i<face_normals.size(); i++)
+    {
+        face_normals[i] = face_normals[i] * 2.0f;
+    }
+    mesh->setScale({1.0, 1.0, 1.0});
+    check_apply(mesh, "unit scale:");
+
+    std::cout << "Parallel apply() matches the serial transformation" << std::endl;
+
+    return 0;
+}
@@ -0,0 +1,305 @@
+#include <iostream>
+#include <algorithm>
+#include <cmath>
+#include <map>
+#include <unordered_set>
+
+#include <assimp/scene.h>
+
+#include <rmagine/map/EmbreeMap.hpp>
+#include <rmagine/map/embree/EmbreeInstance.hpp>
+#include <rmagine/map/embree/EmbreeMesh.hpp>
+#include <rmagine/simulation/SphereSimulatorEmbree.hpp>
+#include <rmagine/types/sensors.h>
+#include <rmagine/math/linalg.h>
+#include <rmagine/util/synthetic.h>
+#include <rmagine/util/assimp/helper.h>
+#include <rmagine/util/exceptions.h>
+
+namespace rm = rmagine;
+
+using ResT = rm::Bundle<
+    rm::Hits<rm::RAM>,
+    rm::Ranges<rm::RAM>,
+    rm::FaceIds<rm::RAM>,
+    rm::GeomIds<rm::RAM>,
+    rm::ObjectIds<rm::RAM> >;
+
+aiMesh* make_ai_mesh(
+    const std::vector<rm::Vector3>& vertices,
+    const std::vector<rm::Face>& faces)
+{
+    aiMesh* mesh = new aiMesh();
+    mesh->mPrimitiveTypes = aiPrimitiveType_TRIANGLE;
+
+    mesh->mNumVertices = vertices.size();
+    mesh->mVertices = new aiVector3D[vertices.size()];
+    for(size_t i=0; i<vertices.size(); i++)
+    {
+        mesh->mVertices[i].x = vertices[i].x;
+        mesh->mVertices[i].y = vertices[i].y;
+        mesh->mVertices[i].z = vertices[i].z;
+    }
+
+    mesh->mNumFaces = faces.size();
+    mesh->mFaces = new aiFace[faces.size()];
+    for(size_t i=0; i<faces.size(); i++)
+    {
+        mesh->mFaces[i].mNumIndices = 3;
+        mesh->mFaces[i].mIndices = new unsigned int[3];
+        mesh->mFaces[i].mIndices[0] = faces[i].v0;
+        mesh->mFaces[i].mIndices[1] = faces[i].v1;
+        mesh->mFaces[i].mIndices[2] = faces[i].v2;
+    }
+
+    return mesh;
+}
+
+// yaw, uniform scale and translation
+aiMatrix4x4 make_ai_transform(float yaw, float scale, rm::Vector3 t)
+{
+    aiMatrix4x4 M;
+    M.a1 = scale * cosf(yaw); M.a2 = -scale * sinf(yaw); M.a3 = 0.0; M.a4 = t.x;
+    M.b1 = scale * sinf(yaw); M.b2 = scale * cosf(yaw);  M.b3 = 0.0; M.b4 = t.y;
+    M.c1 = 0.0;               M.c2 = 0.0;                M.c3 = scale; M.c4 = t.z;
+    M.d1 = 0.0;               M.d2 = 0.0;                M.d3 = 0.0; M.d4 = 1.0;
+    return M;
+}
+
+aiNode* make_ai_node(
+    const char* name,
+    const aiMatrix4x4& M,
+    const std::vector<unsigned int>& mesh_ids,
+    aiNode* parent)
+{
+    aiNode* node = new aiNode();
+    node->mName = aiString(name);
+    node->mTransformation = M;
+    node->mParent = parent;
+    node->mNumChildren = 0;
+    node->mChildren = nullptr;
+    node->mNumMeshes = mesh_ids.size();
+    node->mMeshes = nullptr;
+    if(!mesh_ids.empty())
+    {
+        node->mMeshes = new unsigned int[mesh_ids.size()];
+        std::copy(mesh_ids.begin(), mesh_ids.end(), node->mMeshes);
+    }
+    return node;
+}
+
+void set_children(aiNode* node, const std::vector<aiNode*>& children)
+{
+    node->mNumChildren = children.size();
+    node->mChildren = new aiNode*[children.size()];
+    std::copy(children.begin(), children.end(), node->mChildren);
+}
+
+// 4 meshes. mesh 1 is instanced twice, mesh 3 is not instanced at all
+void fill_ai_scene(aiScene& ascene)
+{
+    std::vector<rm::Vector3> vertices;
+    std::vector<rm::Face> faces;
+
+    ascene.mNumMeshes = 4;
+    ascene.mMeshes = new aiMesh*[4];
+
+    rm::genCube(vertices, faces, 2);
+    ascene.mMeshes[0] = make_ai_mesh(vertices, faces);
+    vertices.clear(); faces.clear();
+
+    rm::genSphere(vertices, faces, 20, 20);
+    ascene.mMeshes[1] = make_ai_mesh(vertices, faces);
+    vertices.clear(); faces.clear();
+
+    rm::genCylinder(vertices, faces, 30);
+    ascene.mMeshes[2] = make_ai_mesh(vertices, faces);
+    vertices.clear(); faces.clear();
+
+    rm::genPlane(vertices, faces, 2);
+    ascene.mMeshes[3] = make_ai_mesh(vertices, faces);
+
+    aiNode* root = make_ai_node("root", make_ai_transform(0.0, 1.0, {0.0, 0.0, 0.0}), {}, nullptr);
+    aiNode* cube_and_sphere = make_ai_node("cube_and_sphere",
+        make_ai_transform(0.3, 1.0, {3.0, 0.0, 0.0}), {0, 1}, root);
+    aiNode* sphere = make_ai_node("sphere",
+        make_ai_transform(0.0, 2.0, {0.0, 3.0, 0.0}), {1}, root);
+    aiNode* group = make_ai_node("group",
+        make_ai_transform(0.0, 1.0, {0.0, 0.0, 0.5}), {}, root);
+    aiNode* cylinder = make_ai_node("cylinder",
+        make_ai_transform(0.5, 1.5, {-3.0, 0.0, 0.0}), {2}, group);
+
+    set_children(group, {cylinder});
+    set_children(root, {cube_and_sphere, sphere, group});
+    ascene.mRootNode = root;
+}
+
+// make_embree_scene(aiScene) as it was built before the construction became parallel
+rm::EmbreeScenePtr make_embree_scene_sequential(
+    const aiScene* ascene,
+    rm::EmbreeDevicePtr device)
+{
+    rm::EmbreeScenePtr scene = std::make_shared<rm::EmbreeScene>(rm::EmbreeSceneSettings{}, device);
+
+    std::map<unsigned int, rm::EmbreeMeshPtr> meshes;
+    for(size_t i=0; i<ascene->mNumMeshes; i++)
+    {
+        const aiMesh* amesh = ascene->mMeshes[i];
+        if(amesh->mPrimitiveTypes & aiPrimitiveType_TRIANGLE)
+        {
+            rm::EmbreeMeshPtr mesh = std::make_shared<rm::EmbreeMesh>(amesh, device);
+            mesh->commit();
+            meshes[i] = mesh;
+        }
+    }
+
+    std::unordered_set<rm::EmbreeGeometryPtr> instanciated_meshes;
+    std::vector<const aiNode*> mesh_nodes = rm::get_nodes_with_meshes(ascene->mRootNode);
+    for(size_t i=0; i<mesh_nodes.size(); i++)
+    {
+        const aiNode* node = mesh_nodes[i];
+
+        rm::Matrix4x4 M = rm::global_transform(node);
+        rm::Transform T;
+        rm::Vector3 scale;
+        rm::decompose(M, T, scale);
+
+        rm::EmbreeScenePtr mesh_scene = std::make_shared<rm::EmbreeScene>(rm::EmbreeSceneSettings{}, device);
+        for(unsigned int j=0; j<node->mNumMeshes; j++)
+        {
+            auto mesh_it = meshes.find(node->mMeshes[j]);
+            if(mesh_it != meshes.end())
+            {
+                instanciated_meshes.insert(mesh_it->second);
+                mesh_scene->add(mesh_it->second);
+                mesh_scene->commit();
+            }
+        }
+        mesh_scene->commit();
+
+        rm::EmbreeInstancePtr mesh_instance = std::make_shared<rm::EmbreeInstance>(device);
+        mesh_instance->set(mesh_scene);
+        mesh_instance->name = node->mName.C_Str();
+        mesh_instance->setTransform(T);
+        mesh_instance->setScale(scale);
+        mesh_instance->apply();
+        mesh_instance->commit();
+        scene->add(mesh_instance);
+    }
+
+    for(auto elem : meshes)
+    {
+        if(instanciated_meshes.find(elem.second) == instanciated_meshes.end())
+        {
+            scene->add(elem.second);
+        }
+    }
+
+    return scene;
+}
+
+void check_same_geometries(rm::EmbreeScenePtr scene, rm::EmbreeScenePtr scene_ref)
+{
+    auto geoms = scene->geometries();
+    auto geoms_ref = scene_ref->geometries();
+    if(geoms.size() != geoms_ref.size())
+    {
+        RM_THROW(rm::EmbreeException, "Different number of geometries");
+    }
+
+    for(auto elem : geoms_ref)
+    {
+        auto it = geoms.find(elem.first);
+        if(it == geoms.end())
+        {
+            RM_THROW(rm::EmbreeException, "Geometry id " + std::to_string(elem.first) + " missing");
+        }
+
+        rm::EmbreeInstancePtr inst = std::dynamic_pointer_cast<rm::EmbreeInstance>(it->second);
+        rm::EmbreeInstancePtr inst_ref = std::dynamic_pointer_cast<rm::EmbreeInstance>(elem.second);
+        rm::EmbreeMeshPtr mesh = std::dynamic_pointer_cast<rm::EmbreeMesh>(it->second);
+        rm::EmbreeMeshPtr mesh_ref = std::dynamic_pointer_cast<rm::EmbreeMesh>(elem.second);
+
+        if(inst_ref)
+        {
+            if(!inst || inst->name != inst_ref->name)
+            {
+                RM_THROW(rm::EmbreeException, "Instance with geometry id " + std::to_string(elem.first) + " differs");
+            }
+            check_same_geometries(inst->scene(), inst_ref->scene());
+        } else if(mesh_ref) {
+            if(!mesh || mesh->faces().size() != mesh_ref->faces().size()
+                || mesh->vertices().size() != mesh_ref->vertices().size())
+            {
+                RM_THROW(rm::EmbreeException, "Mesh with geometry id " + std::to_string(elem.first) + " differs");
+            }
+        }
+    }
+}
+
+int main(int argc, char** argv)
+{
+    std::cout << "RMAGINE EMBREE SCENE IMPORT" << std::endl;
+
+    aiScene ascene;
+    fill_ai_scene(ascene);
+
+    rm::EmbreeDevicePtr device = rm::embree_default_device();
+
+    rm::EmbreeScenePtr scene = rm::make_embree_scene(&ascene, device);
+    scene->commit();
+    rm::EmbreeScenePtr scene_ref = make_embree_scene_sequential(&ascene, device);
+    scene_ref->commit();
+
+    // same geometry and instance ids
+    check_same_geometries(scene, scene_ref);
+    std::cout << "Geometry and instance ids match the sequential import" << std::endl;
+
+    // same ray casting results
+    rm::SphereSimulatorEmbree sim(std::make_shared<rm::EmbreeMap>(scene));
+    rm::SphereSimulatorEmbree sim_ref(std::make_shared<rm::EmbreeMap>(scene_ref));
+    auto model = rm::example_spherical();
+    sim.setModel(model);
+    sim_ref.setModel(model);
+
+    rm::Memory<rm::Transform, rm::RAM> Tbm(4);
+    for(size_t i=0; i<Tbm.size(); i++)
+    {
+        Tbm[i] = rm::Transform::Identity();
+        Tbm[i].t = {0.5f * static_cast<float>(i), -0.5f * static_cast<float>(i), 0.5};
+    }
+
+    ResT res = sim.simulate<ResT>(Tbm);
+    ResT res_ref = sim_ref.simulate<ResT>(Tbm);
+
+    size_t n_hits = 0;
+    for(size_t i=0; i<res_ref.hits.size(); i++)
+    {
+        if(res.hits[i] != res_ref.hits[i])
+        {
+            RM_THROW(rm::EmbreeException, "Hits differ at ray " + std::to_string(i));
+        }
+        if(!res_ref.hits[i])
+        {
+            continue;
+        }
+        n_hits++;
+
+        if(std::fabs(res.ranges[i] - res_ref.ranges[i]) > 0.0001
+            || res.face_ids[i] != res_ref.face_ids[i]
+            || res.geom_ids[i] != res_ref.geom_ids[i]
+            || res.object_ids[i] != res_ref.object_ids[i])
+        {
+            RM_THROW(rm::EmbreeException, "Ray casting results differ at ray " + std::to_string(i));
+        }
+    }
+
+    if(n_hits == 0)
+    {
+        RM_THROW(rm::EmbreeException, "Scene was not hit");
+    }
+
+    std::cout << "Ray casting results match the sequential import (" << n_hits << " hits)" << std::endl;
+
+    return 0;
+}
@@ -0,0 +1,127 @@
+#include <iostream>
+#include <atomic>
+
+#include <rmagine/simulation/SphereSimulatorEmbree.hpp>
+#include <rmagine/map/embree/embree_shapes.h>
+#include <rmagine/map/EmbreeMap.hpp>
+#include <rmagine/types/sensors.h>
+#include <rmagine/util/exceptions.h>
+#include <rmagine/util/prints.h>
+
+#include <tbb/task_arena.h>
+#include <tbb/task_scheduler_observer.h>
+
+
+using namespace rmagine;
+
+using ResT = Bundle<Hits<RAM>, Ranges<RAM> >;
+
+EmbreeMapPtr make_map(EmbreeDevicePtr device)
+{
+    EmbreeScenePtr scene = std::make_shared<EmbreeScene>(EmbreeSceneSettings(), device);
+
+    EmbreeGeometryPtr mesh = std::make_shared<EmbreeCube>(1, device);
+    mesh->commit();
+    scene->add(mesh);
+    scene->commit();
+
+    return std::make_shared<EmbreeMap>(scene);
+}
+
+// records the highest number of threads that were in the observed arena at once
+class ThreadCounter : public tbb::task_scheduler_observer
+{
+public:
+    ThreadCounter(tbb::task_arena& arena)
+    :tbb::task_scheduler_observer(arena)
+    {
+        observe(true);
+    }
+
+    void on_scheduler_entry(bool /*is_worker*/) override
+    {
+        int n = ++active;
+        int p = peak.load();
+        while(n > p && !peak.compare_exchange_weak(p, n)) {}
+    }
+
+    void on_scheduler_exit(bool /*is_worker*/) override
+    {
+        --active;
+    }
+
+    std::atomic<int> active{0};
+    std::atomic<int> peak{0};
+};
+
+int main(int argc, char** argv)
+{
+    // 1. device settings
+    EmbreeDeviceSettings device_settings;
+    device_settings.threads = 2;
+    device_settings.set_affinity = true;
+    device_settings.frequency_level = "simd256";
+
+    std::string config = device_settings.toConfigString();
+    std::cout << "Device config: " << config << std::endl;
+    if(config != "threads=2,set_affinity=1,frequency_level=simd256")
+    {
+        RM_THROW(EmbreeException, "Unexpected device config string: " + config);
+    }
+
+    EmbreeDevicePtr device = std::make_shared<EmbreeDevice>(device_settings);
+
+    SphereSimulatorEmbree sim;
+    sim.setMap(make_map(device));
+
+    auto model = example_spherical();
+    sim.setModel(model);
+
+    Memory<Transform, RAM> T(100);
+    for(size_t i=0; i<T.size(); i++)
+    {
+      T[i] = Transform::Identity();
+      T[i].t.x = -0.2 + 0.004 * static_cast<float>(i);
+    }
+
+    ResT ref = sim.simulate<ResT>(T);
+
+    // 2. simulate in an arena of fixed concurrency
+    const int concurrency = 2;
+    sim.setConcurrency(concurrency);
+
+    ThreadCounter counter(*sim.arena());
+
+    ResT res = sim.simulate<ResT>(T);
+    ResT res_async;
+    resize_memory_bundle<RAM>(res_async, model.getWidth(), model.getHeight(), T.size());
+    sim.simulateAsync(T, res_async).get();
+
+    for(size_t i=0; i<ref.ranges.size(); i++)
+    {
+      if(res.hits[i] != ref.hits[i] || res.ranges[i] != ref.ranges[i]
+        || res_async.hits[i] != ref.hits[i] || res_async.ranges[i] != ref.ranges[i])
+      {
+        std::stringstream ss;
+        ss << "Arena simulation differs at ray " << i;
+        RM_THROW(EmbreeException, ss.str());
+      }
+    }
+
+    counter.observe(false);
+
+    std::cout << "Max. threads in arena: " << counter.peak.load() << std::endl;
+    if(counter.peak.load() > concurrency)
+    {
+      RM_THROW(EmbreeException, "Simulation used more threads than the arena allows");
+    }
+
+    // 3. unbind
+    sim.setArena(nullptr);
+    if(sim.arena())
+    {
+      RM_THROW(EmbreeException, "Simulator is still bound to an arena");
+    }
+
+    return 0;
+}
@@ -0,0 +1,172 @@
+#include <iostream>
+#include <thread>
+#include <vector>
+
+#include <rmagine/simulation/SphereSimulatorEmbree.hpp>
+#include <rmagine/simulation/BundlePool.hpp>
+#include <rmagine/types/MemoryPooled.hpp>
+#include <rmagine/types/MemoryHuge.hpp>
+#include <rmagine/map/embree/embree_shapes.h>
+#include <rmagine/map/EmbreeMap.hpp>
+#include <rmagine/types/sensors.h>
+#include <rmagine/util/exceptions.h>
+#include <rmagine/util/prints.h>
+
+
+using namespace rmagine;
+
+using ResT = Bundle<Hits<RAM>, Ranges<RAM> >;
+using ResPooledT = Bundle<Hits<RAM_POOLED>, Ranges<RAM_POOLED> >;
+using ResHugeT = Bundle<Hits<RAM_HUGE>, Ranges<RAM_HUGE> >;
+
+EmbreeMapPtr make_map()
+{
+    EmbreeScenePtr scene = std::make_shared<EmbreeScene>();
+
+    EmbreeGeometryPtr mesh = std::make_shared<EmbreeCube>();
+    mesh->commit();
+    scene->add(mesh);
+    scene->commit();
+
+    return std::make_shared<EmbreeMap>(scene);
+}
+
+Memory<Transform, RAM> make_poses(size_t N, float shift)
+{
+    Memory<Transform, RAM> T(N);
+    for(size_t i=0; i<T.size(); i++)
+    {
+      T[i] = Transform::Identity();
+      T[i].t.x = shift + 0.02 * static_cast<float>(i);
+    }
+    return T;
+}
+
+void compare(const ResT& res, const ResT& ref, std::string name)
+{
+    for(size_t i=0; i<ref.ranges.size(); i++)
+    {
+      if(res.hits[i] != ref.hits[i] || std::fabs(res.ranges[i] - ref.ranges[i]) > 0.0001)
+      {
+        std::stringstream ss;
+        ss << name << ": mismatch at ray " << i;
+        RM_THROW(EmbreeException, ss.str());
+      }
+    }
+}
+
+int main(int argc, char** argv)
+{
+    SphereSimulatorEmbree sim;
+    sim.setMap(make_map());
+
+    auto model = example_spherical();
+    sim.setModel(model);
+
+    const size_t Nposes = 4;
+    const size_t Nproducers = 4;
+    const size_t Nruns = 10;
+
+    // 1. single async call
+    Memory<Transform, RAM> T = make_poses(Nposes, -0.2);
+    ResT ref = sim.simulate<ResT>(T);
+
+    ResT res;
+    resize_memory_bundle<RAM>(res, model.getWidth(), model.getHeight(), Nposes);
+    std::future<void> fut = sim.simulateAsync(T, res);
+    fut.get();
+    compare(res, ref, "simulateAsync");
+    std::cout << "simulateAsync matches simulate" << std::endl;
+
+    // 2. several producers sharing one double buffered pool
+    BundlePool<ResT> pool(model.getWidth(), model.getHeight(), Nposes);
+
+    std::vector<ResT> refs(Nproducers);
+    for(size_t p=0; p<Nproducers; p++)
+    {
+      refs[p] = sim.simulate<ResT>(make_poses(Nposes, -0.2 + 0.05 * p));
+    }
+
+    std::vector<std::thread> producers;
+    std::vector<std::string> errors(Nproducers);
+    for(size_t p=0; p<Nproducers; p++)
+    {
+      producers.emplace_back([&, p]()
+      {
+        try {
+          Memory<Transform, RAM> Tp = make_poses(Nposes, -0.2 + 0.05 * p);
+          for(size_t i=0; i<Nruns; i++)
+          {
+            std::shared_ptr<ResT> buffer = sim.simulateAsync(Tp, pool).get();
+            compare(*buffer, refs[p], "producer " + std::to_string(p));
+          }
+        } catch(const std::exception& ex) {
+          errors[p] = ex.what();
+        }
+      });
+    }
+
+    for(auto& producer : producers)
+    {
+      producer.join();
+    }
+
+    for(size_t p=0; p<Nproducers; p++)
+    {
+      if(!errors[p].empty())
+      {
+        RM_THROW(EmbreeException, errors[p]);
+      }
+    }
+
+    if(pool.available() != pool.size())
+    {
+      RM_THROW(EmbreeException, "Not every buffer was returned to the pool");
+    }
+
+    std::cout << Nproducers << " producers x " << Nruns << " async simulations with " 
+      << pool.size() << " buffers match simulate" << std::endl;
+
+    // 3. a too small pool is rejected
+    BundlePool<ResT> pool_small(model.getWidth(), model.getHeight(), 1);
+    bool thrown = false;
+    try {
+      sim.simulateAsync(T, pool_small);
+    } catch(const EmbreeException& ex) {
+      thrown = true;
+    }
+
+    if(!thrown)
+    {
+      RM_THROW(EmbreeException, "simulateAsync accepted a pool that is too small");
+    }
+
+    // 4. pooled host memory: frames reuse the same buffers
+    BundlePool<ResPooledT, RAM_POOLED> pool_pooled(model.getWidth(), model.getHeight(), Nposes);
+    for(size_t i=0; i<Nruns; i++)
+    {
+      std::shared_ptr<ResPooledT> buffer = sim.simulateAsync(T, pool_pooled).get();
+      ResT res_ram;
+      res_ram.hits = buffer->hits;
+      res_ram.ranges = buffer->ranges;
+      compare(res_ram, ref, "RAM_POOLED");
+    }
+
+    ResPooledT res_pooled = sim.simulate<ResPooledT>(T);
+    ResT res_ram;
+    res_ram.hits = res_pooled.hits;
+    res_ram.ranges = res_pooled.ranges;
+    compare(res_ram, ref, "simulate RAM_POOLED");
+    std::cout << "RAM_POOLED bundles match RAM bundles" << std::endl;
+
+    // 5. huge page memory with parallel first touch
+    huge::set_prefault(true);
+    ResHugeT res_huge = sim.simulate<ResHugeT>(T);
+    huge::set_prefault(false);
+    res_ram.hits = res_huge.hits;
+    res_ram.ranges = res_huge.ranges;
+    compare(res_ram, ref, "simulate RAM_HUGE");
+    std::cout << "RAM_HUGE bundles match RAM bundles" << std::endl;
+
+    return 0;
+}
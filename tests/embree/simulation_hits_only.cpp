@@ -0,0 +1,78 @@
+#include <iostream>
+
+#include <rmagine/simulation/SphereSimulatorEmbree.hpp>
+#include <rmagine/map/embree/embree_shapes.h>
+#include <rmagine/map/EmbreeMap.hpp>
+#include <rmagine/types/sensors.h>
+#include <rmagine/util/exceptions.h>
+#include <rmagine/util/prints.h>
+
+
+using namespace rmagine;
+
+
+EmbreeMapPtr make_map()
+{
+    EmbreeScenePtr scene = std::make_shared<EmbreeScene>();
+
+    EmbreeGeometryPtr mesh = std::make_shared<EmbreeCube>();
+    mesh->commit();
+    scene->add(mesh);
+    scene->commit();
+
+    return std::make_shared<EmbreeMap>(scene);
+}
+
+int main(int argc, char** argv)
+{
+    SphereSimulatorEmbree sim;
+
+    EmbreeMapPtr map = make_map();
+    sim.setMap(map);
+
+    // limit the range so that only parts of the cube are visible
+    auto model = example_spherical();
+    model.range.max = 0.6;
+    sim.setModel(model);
+
+    Memory<Transform, RAM> T(10);
+    for(size_t i=0; i<T.size(); i++)
+    {
+      T[i] = Transform::Identity();
+      T[i].t.x = -0.2 + 0.04 * static_cast<float>(i);
+    }
+
+    for(unsigned int packet_size : {1, 0})
+    {
+      sim.setPacketSize(packet_size);
+
+      // full intersection
+      using ResFullT = Bundle<Hits<RAM>, Ranges<RAM> >;
+      ResFullT res_full = sim.simulate<ResFullT>(T);
+
+      // occlusion only
+      using ResHitsT = Bundle<Hits<RAM> >;
+      ResHitsT res_hits = sim.simulate<ResHitsT>(T);
+
+      size_t nhits = 0;
+      for(size_t i=0; i<res_hits.hits.size(); i++)
+      {
+        if(res_hits.hits[i] != res_full.hits[i])
+        {
+          std::stringstream ss;
+          ss << "Packet size " << packet_size << ": occlusion result differs from intersection at ray " << i;
+          RM_THROW(EmbreeException, ss.str());
+        }
+        nhits += res_hits.hits[i];
+      }
+
+      if(nhits == 0 || nhits == res_hits.hits.size())
+      {
+        RM_THROW(EmbreeException, "Expected both hits and misses");
+      }
+
+      std::cout << "Packet size " << packet_size << ": " << nhits << "/" << res_hits.hits.size() << " hits" << std::endl;
+    }
+
+    return 0;
+}
@@ -0,0 +1,147 @@
+#include <iostream>
+#include <cmath>
+
+#include <rmagine/simulation/SphereSimulatorEmbree.hpp>
+#include <rmagine/map/embree/embree_shapes.h>
+#include <rmagine/map/EmbreeMap.hpp>
+#include <rmagine/noise/GaussianNoise.hpp>
+#include <rmagine/noise/UniformDustNoise.hpp>
+#include <rmagine/types/sensors.h>
+#include <rmagine/util/exceptions.h>
+#include <rmagine/util/prints.h>
+
+
+using namespace rmagine;
+
+
+EmbreeMapPtr make_map()
+{
+    EmbreeScenePtr scene = std::make_shared<EmbreeScene>();
+
+    EmbreeGeometryPtr mesh = std::make_shared<EmbreeCube>();
+    mesh->commit();
+    scene->add(mesh);
+    scene->commit();
+
+    return std::make_shared<EmbreeMap>(scene);
+}
+
+using ResT = Bundle<Hits<RAM>, Ranges<RAM>, Points<RAM>, Normals<RAM> >;
+
+/**
+ * @brief Ranges, points and hits of a noisy simulation have to agree
+ */
+void check_consistent(const ResT& res, const Interval& range)
+{
+    for(size_t i=0; i<res.ranges.size(); i++)
+    {
+        const bool hit = range.inside(res.ranges[i]);
+        if(hit != static_cast<bool>(res.hits[i]))
+        {
+            RM_THROW(EmbreeException, "Hits do not match the noisy ranges");
+        }
+
+        // the rays start at the sensor origin
+        if(!std::isnan(res.points[i].x) 
+            && fabs(res.points[i].l2normSquared() - res.ranges[i] * res.ranges[i]) > 1e-4)
+        {
+            RM_THROW(EmbreeException, "Points do not match the noisy ranges");
+        }
+    }
+}
+
+int main(int argc, char** argv)
+{
+    SphereSimulatorEmbree sim;
+
+    EmbreeMapPtr map = make_map();
+    sim.setMap(map);
+
+    auto model = example_spherical();
+    model.range.max = 0.6;
+    sim.setModel(model);
+
+    Memory<Transform, RAM> T(10);
+    for(size_t i=0; i<T.size(); i++)
+    {
+      T[i] = Transform::Identity();
+      T[i].t.x = -0.2 + 0.04 * static_cast<float>(i);
+    }
+
+    // clean simulation
+    ResT res_clean = sim.simulate<ResT>(T);
+
+    ///////
+    // Gaussian noise: same ranges as a separate pass
+    NoisePtr gauss = std::make_shared<GaussianNoise>(0.0, 0.01);
+    sim.setNoise(gauss);
+
+    ResT res_noisy = sim.simulate<ResT>(T);
+    check_consistent(res_noisy, model.range);
+
+    gauss->reset();
+    Memory<float, RAM> ranges_pass = res_clean.ranges;
+    gauss->apply(ranges_pass);
+
+    size_t n_changed = 0;
+    for(size_t i=0; i<ranges_pass.size(); i++)
+    {
+        if(!res_clean.hits[i])
+        {
+            // misses stay invalid
+            continue;
+        }
+        if(fabs(ranges_pass[i] - res_noisy.ranges[i]) > 1e-5)
+        {
+            RM_THROW(EmbreeException, "Fused noise differs from a separate noise pass");
+        }
+        n_changed += (res_noisy.ranges[i] != res_clean.ranges[i]);
+    }
+
+    if(n_changed == 0)
+    {
+        RM_THROW(EmbreeException, "Noise was not applied");
+    }
+    std::cout << "Gaussian: " << n_changed << " disturbed ranges" << std::endl;
+
+    // hits only: occlusion is replaced by intersections
+    gauss->reset();
+    Bundle<Hits<RAM> > res_hits = sim.simulate<Bundle<Hits<RAM> > >(T);
+    for(size_t i=0; i<res_hits.hits.size(); i++)
+    {
+        if(res_hits.hits[i] != res_noisy.hits[i])
+        {
+            RM_THROW(EmbreeException, "Hits only simulation ignores the noise");
+        }
+    }
+
+    ///////
+    // Dust noise: returns on rays that hit nothing
+    Noise::Options opt;
+    opt.max_range = 100.0;
+    sim.setNoise(std::make_shared<UniformDustNoise>(0.5, 0.9, opt));
+
+    ResT res_dust = sim.simulate<ResT>(T);
+    check_consistent(res_dust, model.range);
+
+    size_t n_dust = 0;
+    for(size_t i=0; i<res_dust.hits.size(); i++)
+    {
+        if(!res_clean.hits[i] && res_dust.hits[i])
+        {
+            if(!std::isnan(res_dust.normals[i].x))
+            {
+                RM_THROW(EmbreeException, "Returns without surface must not have a normal");
+            }
+            n_dust++;
+        }
+    }
+
+    if(n_dust == 0)
+    {
+        RM_THROW(EmbreeException, "Expected dust returns on missed rays");
+    }
+    std::cout << "Dust: " << n_dust << " returns on missed rays" << std::endl;
+
+    return 0;
+}
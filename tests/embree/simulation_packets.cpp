@@ -0,0 +1,105 @@
+#include <iostream>
+
+#include <rmagine/simulation/SphereSimulatorEmbree.hpp>
+#include <rmagine/map/embree/embree_shapes.h>
+#include <rmagine/map/EmbreeMap.hpp>
+#include <rmagine/types/sensors.h>
+#include <rmagine/util/exceptions.h>
+#include <rmagine/util/prints.h>
+
+
+using namespace rmagine;
+
+
+EmbreeMapPtr make_map()
+{
+    EmbreeScenePtr scene = std::make_shared<EmbreeScene>();
+
+    EmbreeGeometryPtr mesh = std::make_shared<EmbreeCube>();
+    mesh->commit();
+    scene->add(mesh);
+    scene->commit();
+
+    return std::make_shared<EmbreeMap>(scene);
+}
+
+int main(int argc, char** argv)
+{
+    SphereSimulatorEmbree sim;
+
+    EmbreeMapPtr map = make_map();
+    sim.setMap(map);
+
+    auto model = example_spherical();
+    sim.setModel(model);
+
+    std::cout << "Native packet size: " << map->device->nativePacketSize() << std::endl;
+
+    Memory<Transform, RAM> T(10);
+    for(size_t i=0; i<T.size(); i++)
+    {
+      T[i] = Transform::Identity();
+      T[i].t.x = -0.2 + 0.04 * static_cast<float>(i);
+      T[i].t.y = 0.1 - 0.02 * static_cast<float>(i);
+    }
+
+    // reference: single rays
+    sim.setPacketSize(1);
+    IntAttrAll<RAM> res_single = sim.simulate<IntAttrAll<RAM> >(T);
+
+    for(unsigned int packet_size : {4, 8, 16, 0})
+    {
+      sim.setPacketSize(packet_size);
+      IntAttrAll<RAM> res = sim.simulate<IntAttrAll<RAM> >(T);
+
+      for(size_t i=0; i<res.ranges.size(); i++)
+      {
+        if(res.hits[i] != res_single.hits[i] 
+          || res.face_ids[i] != res_single.face_ids[i])
+        {
+          std::stringstream ss;
+          ss << "Packet size " << packet_size << ": hit/face mismatch at ray " << i;
+          RM_THROW(EmbreeException, ss.str());
+        }
+
+        float error = std::fabs(res.ranges[i] - res_single.ranges[i]);
+        if(error > 0.0001)
+        {
+          std::stringstream ss;
+          ss << "Packet size " << packet_size << ": range error too high at ray " << i << ": " << error;
+          RM_THROW(EmbreeException, ss.str());
+        }
+      }
+
+      std::cout << "Packet size " << packet_size << " (" << sim.packetSize() << ") matches single rays" << std::endl;
+    }
+
+    // structure of arrays results match Points and Normals
+    using ResSoA = Bundle<Hits<RAM>, PointsSoA<RAM>, NormalsSoA<RAM> >;
+    sim.setPacketSize(0);
+    ResSoA res_soa = sim.simulate<ResSoA>(T);
+    for(size_t i=0; i<res_soa.hits.size(); i++)
+    {
+      if(!res_soa.hits[i])
+      {
+        if(res_soa.points_soa.x[i] == res_soa.points_soa.x[i])
+        {
+          RM_THROW(EmbreeException, "PointsSoA: miss is not NaN");
+        }
+        continue;
+      }
+
+      const Vector p = {res_soa.points_soa.x[i], res_soa.points_soa.y[i], res_soa.points_soa.z[i]};
+      const Vector n = {res_soa.normals_soa.x[i], res_soa.normals_soa.y[i], res_soa.normals_soa.z[i]};
+      if((p - res_single.points[i]).l2norm() > 0.0001 
+        || (n - res_single.normals[i]).l2norm() > 0.0001)
+      {
+        std::stringstream ss;
+        ss << "PointsSoA/NormalsSoA mismatch at ray " << i;
+        RM_THROW(EmbreeException, ss.str());
+      }
+    }
+    std::cout << "PointsSoA and NormalsSoA match Points and Normals" << std::endl;
+
+    return 0;
+}